@@ -181,6 +181,27 @@ void *sha1HashHelper(const void *data, const size_t dataLength, void *resultArra
     br_sha1_out(&context, resultArray);
     return resultArray;
 }
+
+template <typename T>
+size_t updateFromStream(T &context, Stream &stream, const size_t maxLength)
+{
+    uint8_t buffer[experimental::crypto::STREAM_BUFFER_SIZE];
+    size_t total = 0;
+
+    while (total < maxLength)
+    {
+        size_t readLength = stream.readBytes(buffer, std::min(sizeof buffer, maxLength - total));
+        if (readLength == 0)
+        {
+            break;
+        }
+
+        context.update(buffer, readLength);
+        total += readLength;
+    }
+
+    return total;
+}
 }
 
 namespace experimental
@@ -217,6 +238,95 @@ nonceGeneratorType getNonceGenerator()
 }
 
 
+// #################### Streaming hash and HMAC ####################
+
+HashContext::HashContext(const br_hash_class *hashType)
+{
+    _context.vtable = hashType;
+    begin();
+}
+
+void HashContext::begin()
+{
+    _context.vtable->init(&_context.vtable);
+}
+
+void HashContext::update(const void *data, const size_t dataLength)
+{
+    _context.vtable->update(&_context.vtable, data, dataLength);
+}
+
+size_t HashContext::update(Stream &stream, const size_t maxLength)
+{
+    return updateFromStream(*this, stream, maxLength);
+}
+
+void *HashContext::finish(void *resultArray) const
+{
+    // out() does not modify the context, so hashing can continue afterwards.
+    _context.vtable->out(&_context.vtable, resultArray);
+    return resultArray;
+}
+
+String HashContext::finish() const
+{
+    uint8_t hashArray[length()];
+    finish(hashArray);
+    return TypeCast::uint8ArrayToHexString(hashArray, length());
+}
+
+size_t HashContext::length() const
+{
+    return (_context.vtable->desc >> BR_HASHDESC_OUT_OFF) & BR_HASHDESC_OUT_MASK;
+}
+
+HmacContext::HmacContext(const br_hash_class *hashType, const void *hashKey, const size_t hashKeyLength)
+{
+    br_hmac_key_init(&_keyContext, hashType, hashKey, hashKeyLength);
+    begin();
+}
+
+void HmacContext::setKey(const void *hashKey, const size_t hashKeyLength)
+{
+    br_hmac_key_init(&_keyContext, br_hmac_key_get_digest(&_keyContext), hashKey, hashKeyLength);
+    begin();
+}
+
+void HmacContext::begin(const size_t outputLength)
+{
+    // The key context holds the inner and outer hash states of the processed key, so this is a plain copy.
+    br_hmac_init(&_context, &_keyContext, outputLength);
+}
+
+void HmacContext::update(const void *data, const size_t dataLength)
+{
+    br_hmac_update(&_context, data, dataLength);
+}
+
+size_t HmacContext::update(Stream &stream, const size_t maxLength)
+{
+    return updateFromStream(*this, stream, maxLength);
+}
+
+void *HmacContext::finish(void *resultArray) const
+{
+    br_hmac_out(&_context, resultArray);
+    return resultArray;
+}
+
+String HmacContext::finish() const
+{
+    uint8_t hmac[length()];
+    finish(hmac);
+    return TypeCast::uint8ArrayToHexString(hmac, length());
+}
+
+size_t HmacContext::length() const
+{
+    return br_hmac_size(const_cast<br_hmac_context *>(&_context));
+}
+
+
 // #################### MD5 ####################
 
 // resultArray must have size MD5::NATURAL_LENGTH or greater
@@ -549,5 +659,154 @@ bool ChaCha20Poly1305::decrypt(void *data, const size_t dataLength, const void *
 
     return true;
 }
+
+ChaCha20Poly1305::Context::Context(const void *key, const void *keySalt, const size_t keySaltLength)
+{
+    if (keySalt == nullptr)
+    {
+        memcpy(_key, key, ENCRYPTION_KEY_LENGTH);
+    }
+    else
+    {
+        // Same subkey as chacha20Poly1305Kernel, derived once instead of for every message.
+        HKDF hkdfInstance(key, ENCRYPTION_KEY_LENGTH, keySalt, keySaltLength);
+        hkdfInstance.produce(_key, ENCRYPTION_KEY_LENGTH);
+    }
+
+    getNonceGenerator()(_noncePrefix, sizeof _noncePrefix);
+}
+
+ChaCha20Poly1305::Context::~Context()
+{
+    memset(_key, 0, sizeof _key);
+}
+
+void ChaCha20Poly1305::Context::setNoncePrefix(const void *noncePrefix)
+{
+    memcpy(_noncePrefix, noncePrefix, sizeof _noncePrefix);
+}
+
+const uint8_t *ChaCha20Poly1305::Context::getNoncePrefix() const
+{
+    return _noncePrefix;
+}
+
+void ChaCha20Poly1305::Context::setCounter(const uint32_t counter)
+{
+    _counter = counter;
+}
+
+uint32_t ChaCha20Poly1305::Context::getCounter() const
+{
+    return _counter;
+}
+
+void ChaCha20Poly1305::Context::nextNonce(uint8_t *nonce)
+{
+    memcpy(nonce, _noncePrefix, sizeof _noncePrefix);
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        nonce[sizeof _noncePrefix + i] = _counter >> (8 * i);
+    }
+
+    if (++_counter == 0)
+    {
+        // All counter values were used with this prefix
+        getNonceGenerator()(_noncePrefix, sizeof _noncePrefix);
+    }
+}
+
+void ChaCha20Poly1305::Context::seal(void *data, const size_t dataLength, void *resultingNonce, void *resultingTag, const void *aad, const size_t aadLength)
+{
+    uint8_t *nonce = (uint8_t *)resultingNonce;
+    nextNonce(nonce);
+
+    br_poly1305_ctmul32_run(_key, nonce, data, dataLength, aad, aadLength, resultingTag, br_chacha20_ct_run, 1);
+}
+
+bool ChaCha20Poly1305::Context::open(void *data, const size_t dataLength, const void *encryptionNonce, const void *encryptionTag, const void *aad, const size_t aadLength) const
+{
+    const uint8_t *oldTag = (const uint8_t *)encryptionTag;
+    uint8_t newTag[TAG_LENGTH] {0};
+
+    br_poly1305_ctmul32_run(_key, encryptionNonce, data, dataLength, aad, aadLength, newTag, br_chacha20_ct_run, 0);
+
+    // Constant-time comparison, the tag of a forged message should not be guessable byte by byte.
+    uint8_t difference = 0;
+    for (uint32_t i = 0; i < sizeof newTag; ++i)
+    {
+        difference |= newTag[i] ^ oldTag[i];
+    }
+
+    return difference == 0;
+}
+
+size_t ChaCha20Poly1305::Context::sealBatch(const Message *messages, const size_t messageCount, void *output, const size_t outputLength, const void *aad, const size_t aadLength)
+{
+    size_t totalLength = 0;
+    for (size_t i = 0; i < messageCount; ++i)
+    {
+        if (messages[i].length > UINT16_MAX)
+        {
+            return 0;
+        }
+
+        totalLength += RECORD_OVERHEAD + messages[i].length;
+    }
+
+    if (totalLength > outputLength)
+    {
+        return 0;
+    }
+
+    uint8_t *record = (uint8_t *)output;
+    for (size_t i = 0; i < messageCount; ++i)
+    {
+        const size_t dataLength = messages[i].length;
+        uint8_t *data = record + RECORD_HEADER_LENGTH;
+
+        record[0] = dataLength;
+        record[1] = dataLength >> 8;
+        memmove(data, messages[i].data, dataLength);
+        seal(data, dataLength, record + 2, data + dataLength, aad, aadLength);
+
+        record = data + dataLength + TAG_LENGTH;
+    }
+
+    return totalLength;
+}
+
+size_t ChaCha20Poly1305::Context::openBatch(void *buffer, const size_t bufferLength, Message *messages, const size_t maxMessageCount, const void *aad, const size_t aadLength) const
+{
+    uint8_t *record = (uint8_t *)buffer;
+    size_t remaining = bufferLength;
+    size_t messageCount = 0;
+
+    while (messageCount < maxMessageCount && remaining >= RECORD_OVERHEAD)
+    {
+        const size_t dataLength = record[0] | (record[1] << 8);
+        if (remaining - RECORD_OVERHEAD < dataLength)
+        {
+            break;
+        }
+
+        uint8_t *data = record + RECORD_HEADER_LENGTH;
+        if (open(data, dataLength, record + 2, data + dataLength, aad, aadLength))
+        {
+            messages[messageCount] = { data, dataLength };
+        }
+        else
+        {
+            messages[messageCount] = { nullptr, 0 };
+        }
+
+        ++messageCount;
+        record += RECORD_OVERHEAD + dataLength;
+        remaining -= RECORD_OVERHEAD + dataLength;
+    }
+
+    return messageCount;
+}
 }
 }
@@ -98,12 +98,176 @@ void setNonceGenerator(nonceGeneratorType nonceGenerator);
 nonceGeneratorType getNonceGenerator();
 
 
+// #################### Streaming hash and HMAC ####################
+
+/**
+    Buffer size used when hashing from a Stream (e.g. a File). Large enough to amortize the FS read overhead,
+    small enough to live on the stack.
+*/
+constexpr size_t STREAM_BUFFER_SIZE = 512;
+
+/**
+    Incremental hash computation, for data that does not fit in RAM at once or arrives in pieces.
+    Use the Context type of the hash struct (e.g. SHA256::Context) rather than this class directly.
+    Uses the BearSSL cryptographic library.
+*/
+class HashContext
+{
+public:
+    /**
+        Start a new hash computation, discarding any data added so far. Called by the constructor.
+    */
+    void begin();
+
+    /**
+        Add data to the hash. May be called any number of times between begin() and finish().
+
+        @param data The data array to add.
+        @param dataLength The length of the data array in bytes.
+    */
+    void update(const void *data, const size_t dataLength);
+
+    /**
+        Add all data read from the stream, until it has no more or maxLength bytes have been read.
+        Reads are done in chunks of STREAM_BUFFER_SIZE bytes.
+
+        @param stream The stream to read from, for example a File.
+        @param maxLength The maximum number of bytes to read.
+
+        @return The number of bytes read from the stream.
+    */
+    size_t update(Stream &stream, const size_t maxLength = SIZE_MAX);
+
+    /**
+        Write the hash of all data added since begin() into resultArray. The context is not modified,
+        so more data may be added afterwards to obtain the hash of a longer message.
+
+        @param resultArray The array wherein to store the resulting hash. MUST be be able to contain length() bytes or more.
+
+        @return A pointer to resultArray.
+    */
+    void *finish(void *resultArray) const;
+
+    /**
+        @return The hash of all data added since begin(), in HEX format.
+    */
+    String finish() const;
+
+    /**
+        @return The length of the hash in bytes.
+    */
+    size_t length() const;
+
+protected:
+    explicit HashContext(const br_hash_class *hashType);
+
+private:
+    br_hash_compat_context _context;
+};
+
+/**
+    Incremental HMAC computation. The key is processed once, when constructing the context or calling setKey(),
+    after which any number of HMACs can be computed with begin()/update()/finish() without handling the key again.
+    Use the HmacContext type of the hash struct (e.g. SHA256::HmacContext) rather than this class directly.
+    Uses the BearSSL cryptographic library.
+*/
+class HmacContext
+{
+public:
+    /**
+        Set a new key and start a new HMAC computation.
+
+        @param hashKey The hash key to use when creating the HMAC.
+        @param hashKeyLength The length of the hash key in bytes.
+    */
+    void setKey(const void *hashKey, const size_t hashKeyLength);
+
+    /**
+        Start a new HMAC computation with the current key, discarding any data added so far.
+
+        @param outputLength The desired length of the generated HMAC, in bytes. If it is 0 or greater than the natural length,
+                            the natural length of the underlying hash is used.
+    */
+    void begin(const size_t outputLength = 0);
+
+    /**
+        Add data to the HMAC. May be called any number of times between begin() and finish().
+
+        @param data The data array to add.
+        @param dataLength The length of the data array in bytes.
+    */
+    void update(const void *data, const size_t dataLength);
+
+    /**
+        Add all data read from the stream, until it has no more or maxLength bytes have been read.
+        Reads are done in chunks of STREAM_BUFFER_SIZE bytes.
+
+        @param stream The stream to read from, for example a File.
+        @param maxLength The maximum number of bytes to read.
+
+        @return The number of bytes read from the stream.
+    */
+    size_t update(Stream &stream, const size_t maxLength = SIZE_MAX);
+
+    /**
+        Write the HMAC of all data added since begin() into resultArray. The context is not modified.
+
+        @param resultArray The array wherein to store the resulting HMAC. MUST be be able to contain length() bytes or more.
+
+        @return A pointer to resultArray.
+    */
+    void *finish(void *resultArray) const;
+
+    /**
+        @return The HMAC of all data added since begin(), in HEX format.
+    */
+    String finish() const;
+
+    /**
+        @return The length of the HMAC in bytes, as selected by begin().
+    */
+    size_t length() const;
+
+protected:
+    HmacContext(const br_hash_class *hashType, const void *hashKey, const size_t hashKeyLength);
+
+private:
+    br_hmac_key_context _keyContext; // Inner and outer key states, computed once
+    br_hmac_context _context;
+};
+
+/**
+    Per algorithm context types, e.g. SHA256::Context and SHA256::HmacContext.
+*/
+template <const br_hash_class *hashType>
+struct HashContextType : public HashContext
+{
+    HashContextType() : HashContext(hashType) {}
+};
+
+template <const br_hash_class *hashType>
+struct HmacContextType : public HmacContext
+{
+    HmacContextType(const void *hashKey, const size_t hashKeyLength) : HmacContext(hashType, hashKey, hashKeyLength) {}
+};
+
+
 // #################### MD5 ####################
 
 struct MD5
 {
     static constexpr uint8_t NATURAL_LENGTH = 16;
 
+    /**
+        Incremental MD5 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_md5_vtable>;
+
+    /**
+        MD5 HMAC with a precomputed key, see HmacContext.
+    */
+    using HmacContext = HmacContextType<&br_md5_vtable>;
+
     /**
         WARNING! The MD5 hash is broken in terms of attacker resistance.
         Only use it in those cases where attacker resistance is not important. Prefer SHA-256 or higher otherwise.
@@ -202,6 +366,16 @@ struct SHA1
 {
     static constexpr uint8_t NATURAL_LENGTH = 20;
 
+    /**
+        Incremental SHA1 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_sha1_vtable>;
+
+    /**
+        SHA1 HMAC with a precomputed key, see HmacContext.
+    */
+    using HmacContext = HmacContextType<&br_sha1_vtable>;
+
     /**
         WARNING! The SHA-1 hash is broken in terms of attacker resistance.
         Only use it in those cases where attacker resistance is not important. Prefer SHA-256 or higher otherwise.
@@ -300,6 +474,16 @@ struct SHA224
 {
     static constexpr uint8_t NATURAL_LENGTH = 28;
 
+    /**
+        Incremental SHA224 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_sha224_vtable>;
+
+    /**
+        SHA224 HMAC with a precomputed key, see HmacContext.
+    */
+    using HmacContext = HmacContextType<&br_sha224_vtable>;
+
     /**
         Create a SHA224 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -392,6 +576,16 @@ struct SHA256
 {
     static constexpr uint8_t NATURAL_LENGTH = 32;
 
+    /**
+        Incremental SHA256 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_sha256_vtable>;
+
+    /**
+        SHA256 HMAC with a precomputed key, see HmacContext.
+    */
+    using HmacContext = HmacContextType<&br_sha256_vtable>;
+
     /**
         Create a SHA256 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -484,6 +678,16 @@ struct SHA384
 {
     static constexpr uint8_t NATURAL_LENGTH = 48;
 
+    /**
+        Incremental SHA384 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_sha384_vtable>;
+
+    /**
+        SHA384 HMAC with a precomputed key, see HmacContext.
+    */
+    using HmacContext = HmacContextType<&br_sha384_vtable>;
+
     /**
         Create a SHA384 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -576,6 +780,16 @@ struct SHA512
 {
     static constexpr uint8_t NATURAL_LENGTH = 64;
 
+    /**
+        Incremental SHA512 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_sha512_vtable>;
+
+    /**
+        SHA512 HMAC with a precomputed key, see HmacContext.
+    */
+    using HmacContext = HmacContextType<&br_sha512_vtable>;
+
     /**
         Create a SHA512 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -668,6 +882,11 @@ struct MD5SHA1
 {
     static constexpr uint8_t NATURAL_LENGTH = 36;
 
+    /**
+        Incremental MD5SHA1 hash, see HashContext.
+    */
+    using Context = HashContextType<&br_md5sha1_vtable>;
+
     /**
         Create a MD5+SHA-1 hash of the data. The result will be NATURAL_LENGTH bytes long and stored in resultArray.
         Uses the BearSSL cryptographic library.
@@ -797,6 +1016,7 @@ struct ChaCha20Poly1305
         An alternative to using a keySalt is to change the nonceGenerator so that it does not rely on random numbers.
         One way to do this would be to use a counter that guarantees the same key + nonce combination is never used.
         This may not be easily achievable in all scenarios, however.
+        ChaCha20Poly1305::Context does this, and also avoids deriving the subkey for every message.
 
         @param data An array containing the data to encrypt. The encrypted data is generated in place, so when the function returns the data array will contain the encrypted data.
         @param dataLength The length of the data array in bytes.
@@ -839,6 +1059,131 @@ struct ChaCha20Poly1305
         @return True if the decryption was successful (the generated tag matches encryptionTag). False otherwise. Note that the data array is modified regardless of this outcome.
     */
     static bool decrypt(void *data, const size_t dataLength, const void *key, const void *keySalt, const size_t keySaltLength, const void *encryptionNonce, const void *encryptionTag, const void *aad = nullptr, const size_t aadLength = 0);
+
+    static constexpr uint8_t NONCE_LENGTH = 12;
+    static constexpr uint8_t TAG_LENGTH = 16;
+
+    /**
+        A message for Context::sealBatch() and Context::openBatch(). The data does not need to be contiguous with other messages.
+    */
+    struct Message
+    {
+        void *data;
+        size_t length;
+    };
+
+    /**
+        Sealing context for high message rates. Compared to ChaCha20Poly1305::encrypt/decrypt, the (sub)key is derived once
+        when the context is created, and nonces are built from an 8 byte prefix followed by a 32 bit little-endian message counter,
+        so no call to the nonce generator is made per message.
+
+        The nonce prefix is taken from getNonceGenerator() when the context is created, and again whenever the counter wraps around.
+        A restarted device thus draws a new random prefix instead of repeating the nonces of its previous run, but this only makes a repeat
+        unlikely (about one chance in 2^33 after 2^16 contexts with the same key), it does not rule it out, and it relies on the nonce generator
+        being random at boot. Where that is not good enough, give each context a prefix which is unique for the key, e.g. a boot count kept in
+        flash or RTC memory, with setNoncePrefix(), and use setCounter() to manage the counter explicitly. Either way, the same key + nonce
+        combination must never be used for two distinct messages.
+
+        Messages sealed by a Context can be opened with ChaCha20Poly1305::decrypt and vice versa, as long as the same key and keySalt are used.
+        Uses the BearSSL cryptographic library.
+    */
+    class Context
+    {
+    public:
+        /**
+            Length of the header put in front of each message by sealBatch(): a 2 byte little-endian data length followed by the nonce.
+        */
+        static constexpr uint8_t RECORD_HEADER_LENGTH = 2 + NONCE_LENGTH;
+
+        /**
+            Total space taken by a record in addition to its data, i.e. header and tag.
+        */
+        static constexpr uint8_t RECORD_OVERHEAD = RECORD_HEADER_LENGTH + TAG_LENGTH;
+
+        /**
+            Length of the nonce prefix, the remaining 4 bytes of each nonce hold the message counter.
+        */
+        static constexpr uint8_t NONCE_PREFIX_LENGTH = 8;
+
+        /**
+            @param key The secret encryption key to use. Must be 32 bytes (ENCRYPTION_KEY_LENGTH) long.
+            @param keySalt The salt to use when generating a subkey from key, as for ChaCha20Poly1305::encrypt. Set to nullptr to use the key as is.
+            @param keySaltLength The length of keySalt in bytes.
+        */
+        Context(const void *key, const void *keySalt = nullptr, const size_t keySaltLength = 0);
+
+        ~Context();
+
+        /**
+            Set the first NONCE_PREFIX_LENGTH bytes of all nonces generated by this context. The counter is not reset.
+        */
+        void setNoncePrefix(const void *noncePrefix);
+        const uint8_t *getNoncePrefix() const;
+
+        /**
+            Set the counter used for the next nonce. It is incremented by one for every sealed message,
+            and a new prefix is drawn from getNonceGenerator() when it wraps around to 0.
+        */
+        void setCounter(const uint32_t counter);
+        uint32_t getCounter() const;
+
+        /**
+            Encrypt the data array in place, like ChaCha20Poly1305::encrypt but using the stored key and the next counter based nonce.
+
+            @param data An array containing the data to encrypt. The encrypted data is generated in place.
+            @param dataLength The length of the data array in bytes.
+            @param resultingNonce The array that will store the nonce used. Must be able to contain at least NONCE_LENGTH bytes.
+            @param resultingTag The array that will store the message authentication tag. Must be able to contain at least TAG_LENGTH bytes.
+            @param aad Additional authenticated data, covered by the Poly1305 MAC but not encrypted. Defaults to nullptr.
+            @param aadLength The length of the aad array in bytes. Defaults to 0.
+        */
+        void seal(void *data, const size_t dataLength, void *resultingNonce, void *resultingTag, const void *aad = nullptr, const size_t aadLength = 0);
+
+        /**
+            Decrypt the data array in place, like ChaCha20Poly1305::decrypt but using the stored key.
+
+            @return True if the generated tag matches encryptionTag. False otherwise. Note that the data array is modified regardless of this outcome.
+        */
+        bool open(void *data, const size_t dataLength, const void *encryptionNonce, const void *encryptionTag, const void *aad = nullptr, const size_t aadLength = 0) const;
+
+        /**
+            Seal a list of messages into one contiguous output buffer, e.g. a UDP payload. Each message becomes a record made of
+            a RECORD_HEADER_LENGTH bytes header, the encrypted data and the tag. The messages themselves are not modified,
+            and must not overlap the output buffer.
+
+            @param messages The messages to seal. Each message must be at most 65535 bytes long.
+            @param messageCount The number of messages.
+            @param output The buffer wherein to store the records.
+            @param outputLength The size of the output buffer in bytes.
+            @param aad Additional authenticated data used for every message of the batch, for example a packet header. Defaults to nullptr.
+            @param aadLength The length of the aad array in bytes. Defaults to 0.
+
+            @return The number of bytes written to output, or 0 if the records do not all fit in outputLength bytes (in which case no counter value is used).
+        */
+        size_t sealBatch(const Message *messages, const size_t messageCount, void *output, const size_t outputLength, const void *aad = nullptr, const size_t aadLength = 0);
+
+        /**
+            Open the records of a buffer filled by sealBatch(). Decryption is done in place, and the resulting messages point into the buffer.
+            Messages that fail authentication are returned with data set to nullptr and length 0.
+
+            @param buffer The buffer containing the records.
+            @param bufferLength The number of bytes in buffer.
+            @param messages The array wherein to store the resulting messages.
+            @param maxMessageCount The size of the messages array.
+            @param aad Additional authenticated data, must be the same as used by sealBatch(). Defaults to nullptr.
+            @param aadLength The length of the aad array in bytes. Defaults to 0.
+
+            @return The number of records found, at most maxMessageCount. Parsing stops at the first truncated record.
+        */
+        size_t openBatch(void *buffer, const size_t bufferLength, Message *messages, const size_t maxMessageCount, const void *aad = nullptr, const size_t aadLength = 0) const;
+
+    private:
+        void nextNonce(uint8_t *nonce);
+
+        uint8_t _key[ENCRYPTION_KEY_LENGTH];
+        uint8_t _noncePrefix[NONCE_PREFIX_LENGTH];
+        uint32_t _counter = 0;
+    };
 };
 }
 }
@@ -20,6 +20,7 @@
 
 #include "FS.h"
 #include "FSImpl.h"
+#include "Schedule.h"
 
 using namespace fs;
 
@@ -129,6 +130,20 @@ bool File::truncate(uint32_t size) {
     return _p->truncate(size);
 }
 
+const uint8_t* File::mapped() const {
+    if (!_p)
+        return nullptr;
+
+    return _p->mapped();
+}
+
+uint64_t File::contentHash() const {
+    if (!_p)
+        return 0;
+
+    return _p->contentHash();
+}
+
 const char* File::name() const {
     if (!_p)
         return nullptr;
@@ -330,6 +345,48 @@ bool FS::check() {
     return _impl->check();
 }
 
+bool FS::stats(FSStats& stats, bool reset) {
+    if (!_impl) {
+        return false;
+    }
+    return _impl->stats(stats, reset);
+}
+
+bool FS::gcStep(uint32_t budgetUs) {
+    if (!_impl) {
+        return false;
+    }
+    return _impl->gcStep(budgetUs);
+}
+
+bool FS::setBackgroundGC(uint32_t periodUs, uint32_t budgetUs) {
+    if (!_impl) {
+        return false;
+    }
+    if (_backgroundGC) {
+        *_backgroundGC = false;
+        _backgroundGC.reset();
+    }
+    if (!periodUs) {
+        return true;
+    }
+    // Scheduled functions cannot be cancelled and may outlive this FS
+    auto running = std::make_shared<bool>(true);
+    std::weak_ptr<FSImpl> impl = _impl;
+    if (!schedule_recurrent_function_us([running, impl, budgetUs]() {
+        auto fs = impl.lock();
+        if (!*running || !fs) {
+            return false;
+        }
+        fs->gcStep(budgetUs);
+        return true;
+    }, periodUs)) {
+        return false;
+    }
+    _backgroundGC = running;
+    return true;
+}
+
 bool FS::format() {
     if (!_impl) {
         return false;
@@ -80,6 +80,14 @@ public:
     const char* fullName() const; // Includes path
     bool truncate(uint32_t size);
 
+    // Whole file contents in memory-mapped flash, or nullptr when the filesystem
+    // does not store this file contiguously there.  PROGMEM: read with pgm_read_*
+    // or memcpy_P.  Valid while the filesystem stays mounted.
+    const uint8_t* mapped() const;
+
+    // Hash of the contents kept by read-only filesystems (usable as an HTTP ETag), 0 if none
+    uint64_t contentHash() const;
+
     bool isFile() const;
     bool isDirectory() const;
 
@@ -168,6 +176,34 @@ struct FSInfo64 {
     size_t maxPathLength;
 };
 
+// Activity of a filesystem since it was created or last reset
+struct FSStats {
+    static constexpr size_t latencyBuckets = 6;
+
+    uint32_t readCalls;     // flash traffic
+    uint32_t readBytes;
+    uint32_t progCalls;
+    uint32_t progBytes;
+    uint32_t eraseCalls;
+    uint32_t eraseBytes;
+    uint32_t lookupHits;    // name lookups answered from RAM
+    uint32_t lookupMisses;  // name lookups that scanned the flash
+    uint32_t writeLatency[latencyBuckets]; // File::write() and flush() taking <100us, <1ms, ... <1s, longer
+    uint32_t writeMaxUs;
+    uint32_t gcSteps;       // gcStep() calls that reclaimed space
+
+    void addWriteLatency(uint32_t us) {
+        size_t i = 0;
+        for (uint32_t limit = 100; (i < latencyBuckets - 1) && (us >= limit); limit *= 10) {
+            i++;
+        }
+        writeLatency[i]++;
+        if (us > writeMaxUs) {
+            writeMaxUs = us;
+        }
+    }
+};
+
 
 class FSConfig
 {
@@ -189,10 +225,20 @@ class SPIFFSConfig : public FSConfig
 {
 public:
     static constexpr uint32_t FSId = 0x53504946;
-    SPIFFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat) { }
+    SPIFFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat), _nameCache(0) { }
 
     // Inherit _type and _autoFormat
-    // nothing yet, enableTime TBD when SPIFFS has metadate
+    // enableTime TBD when SPIFFS has metadate
+
+    // Entries in the RAM cache of file names, so that exists(), open() and
+    // remove() of known (or known missing) files skip the flash scan.  Each
+    // entry costs 36 bytes, 0 (default) disables the cache.
+    SPIFFSConfig setNameCache(uint16_t entries) {
+        _nameCache = entries;
+        return *this;
+    }
+
+    uint16_t _nameCache;
 };
 
 class FS
@@ -233,6 +279,15 @@ public:
     // Low-level FS routines, not needed by most applications
     bool gc();
     bool check();
+    bool stats(FSStats& stats, bool reset = false);
+
+    // Garbage collection ahead of demand, so that writes do not stall on it.
+    // gcStep() only starts work expected to end within budgetUs (a SPIFFS
+    // step erases a block, ~100ms) and returns true while work remains,
+    // setBackgroundGC() calls it every periodUs from a recurrent scheduled
+    // function (periodUs = 0 stops it).
+    bool gcStep(uint32_t budgetUs);
+    bool setBackgroundGC(uint32_t periodUs, uint32_t budgetUs = 200000);
 
     void setTimeCallback(time_t (*cb)(void));
 
@@ -240,6 +295,7 @@ public:
 protected:
     FSImplPtr _impl;
     FSImplPtr getImpl() { return _impl; }
+    std::shared_ptr<bool> _backgroundGC; // Cleared to stop the scheduled function
     time_t (*timeCallback)(void);
     static time_t _defaultTimeCB(void) { return time(NULL); }
 };
@@ -262,6 +318,7 @@ using fs::SeekSet;
 using fs::SeekCur;
 using fs::SeekEnd;
 using fs::FSInfo;
+using fs::FSStats;
 using fs::FSConfig;
 using fs::SPIFFSConfig;
 #endif //FS_NO_GLOBALS
@@ -36,6 +36,8 @@ public:
     virtual size_t position() const = 0;
     virtual size_t size() const = 0;
     virtual int availableForWrite() { return 0; }
+    virtual const uint8_t* mapped() const { return nullptr; } // Only for contiguous files in mapped flash
+    virtual uint64_t contentHash() const { return 0; } // Only for read-only images hashed at build time
     virtual bool truncate(uint32_t size) = 0;
     virtual void close() = 0;
     virtual const char* name() const = 0;
@@ -115,6 +117,8 @@ public:
     virtual bool rmdir(const char* path) = 0;
     virtual bool gc() { return true; } // May not be implemented in all file systems.
     virtual bool check() { return true; } // May not be implemented in all file systems.
+    virtual bool stats(FSStats& stats, bool reset) { (void)stats; (void)reset; return false; } // Ditto.
+    virtual bool gcStep(uint32_t budgetUs) { (void)budgetUs; return false; } // Ditto, true while work remains.
 
     // Filesystems *may* support a timestamp per-file, so allow the user to override with
     // their own callback for all files on this FS.  The default implementation simply
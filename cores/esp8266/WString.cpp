@@ -126,12 +126,6 @@ String::~String() {
 /*  Memory Management                        */
 /*********************************************/
 
-inline void String::init(void) {
-    setSSO(true);
-    setLen(0);
-    wbuffer()[0] = 0;
-}
-
 void String::invalidate(void) {
     if(!isSSO() && wbuffer())
         free(wbuffer());
@@ -308,7 +308,12 @@ class String {
         inline char *wbuffer() const { return isSSO() ? const_cast<char *>(sso.buff) : ptr.buff; } // Writable version of buffer
 
     protected:
-        void init(void);
+        // inline here, the default constructor above uses it from every translation unit
+        inline void init(void) {
+            setSSO(true);
+            setLen(0);
+            wbuffer()[0] = 0;
+        }
         void invalidate(void);
         unsigned char changeBuffer(unsigned int maxStrLen);
 
@@ -29,7 +29,7 @@ extern "C" {
 #include "spi_flash.h"
 }
 
-int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
+int32_t flash_hal_phys_read(uint32_t addr, uint32_t size, uint8_t *dst) {
     optimistic_yield(10000);
 
     // We use flashRead overload that handles proper alignment
@@ -40,7 +40,16 @@ int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
     }
 }
 
-int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
+const uint8_t *flash_hal_phys_map(uint32_t addr, uint32_t size) {
+    // The cache maps the first megabyte of flash at 0x40200000
+    const uint32_t mapped = 0x100000;
+    if (addr >= mapped || size > mapped - addr) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uint8_t*>(0x40200000 + addr);
+}
+
+int32_t flash_hal_phys_write(uint32_t addr, uint32_t size, const uint8_t *src) {
     optimistic_yield(10000);
 
     // We use flashWrite overload that handles proper alignment
@@ -51,7 +60,7 @@ int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
     }
 }
 
-int32_t flash_hal_erase(uint32_t addr, uint32_t size) {
+int32_t flash_hal_phys_erase(uint32_t addr, uint32_t size) {
     if ((size & (SPI_FLASH_SEC_SIZE - 1)) != 0 ||
         (addr & (SPI_FLASH_SEC_SIZE - 1)) != 0) {
         DEBUGV("_spif_erase called with addr=%x, size=%d\r\n", addr, size);
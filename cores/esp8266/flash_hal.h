@@ -45,5 +45,34 @@ extern "C" uint32_t _FS_block;
 extern int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src);
 extern int32_t flash_hal_erase(uint32_t addr, uint32_t size);
 extern int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst);
+// Pointer to [addr, addr+size) in memory-mapped flash (PROGMEM), nullptr if not mapped
+extern const uint8_t *flash_hal_map(uint32_t addr, uint32_t size);
+
+// Optional RAM cache in front of the functions above, shared by all filesystems.
+// It holds up to size bytes of 256-byte flash pages, 0 (the default) disables it.
+// With writeBack, writes are merged in RAM and only reach the flash on
+// flash_hal_sync(), on eviction or before an erase, in the order they were
+// made: a reset loses the writes since the last write-back.  LittleFS syncs on
+// every commit, SPIFFS after file flush and close and metadata changes.
+// Without writeBack, writes go through immediately and only reads are cached.
+#define FLASH_HAL_CACHE_LINE  (256)
+
+struct flash_hal_cache_stats {
+    uint32_t readHits;      // Pages read from the cache
+    uint32_t readMisses;    // Reads that went to flash
+    uint32_t writeHits;     // Pages written into the cache
+    uint32_t writeMisses;
+    uint32_t writeBacks;    // Flash programs of merged pages
+};
+
+extern bool flash_hal_cache_begin(uint32_t size, bool writeBack = true);
+extern int32_t flash_hal_sync();
+extern void flash_hal_cache_get_stats(flash_hal_cache_stats *stats, bool reset = false);
+
+// Physical access below the cache, implemented by flash_hal.cpp (or the host mock)
+extern int32_t flash_hal_phys_write(uint32_t addr, uint32_t size, const uint8_t *src);
+extern int32_t flash_hal_phys_erase(uint32_t addr, uint32_t size);
+extern int32_t flash_hal_phys_read(uint32_t addr, uint32_t size, uint8_t *dst);
+extern const uint8_t *flash_hal_phys_map(uint32_t addr, uint32_t size);
 
 #endif // !defined(flash_hal_h)
@@ -0,0 +1,323 @@
+/*
+ flash_hal_cache.cpp - optional RAM cache in front of the flash HAL
+
+ Filesystems access flash through flash_hal_read/write/erase, which land
+ here.  Without a cache (the default) they go straight to the physical
+ functions in flash_hal.cpp.  With flash_hal_cache_begin() a small LRU
+ cache of 256-byte lines (one flash program page each) sits in between:
+ repeated reads of metadata come from RAM, consecutive small writes into
+ the same page are merged and programmed once by flash_hal_sync() or on
+ eviction, and misses always move whole aligned pages.
+
+ Filesystems survive resets because the flash takes their writes in
+ order.  Dirty lines are therefore written back in the order they were
+ first written, a write to a page that is not the last one written first
+ pushes everything pending, and so does anything that reaches the flash
+ directly (erases, page sized writes).  The flash always holds a prefix of
+ the writes made, as it would have without the cache at an earlier reset.
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "flash_hal.h"
+
+namespace {
+
+constexpr uint32_t lineSize = FLASH_HAL_CACHE_LINE;
+constexpr uint32_t lineMask = lineSize - 1;
+constexpr uint32_t invalid = UINT32_MAX;
+
+struct CacheLine {
+    uint8_t  data[lineSize] __attribute__((aligned(4)));
+    uint32_t addr;      // Flash address of data[0], invalid when unused
+    uint32_t stamp;     // Last use, the smallest one is evicted
+    uint32_t dirtySeq;  // Order in which dirty lines were written, 0 when clean
+    uint16_t dirtyLo;   // [dirtyLo, dirtyHi) is newer than the flash
+    uint16_t dirtyHi;
+};
+
+CacheLine *s_lines = nullptr;
+uint32_t s_count = 0;
+uint32_t s_clock = 0;
+uint32_t s_dirtySeq = 0;    // Of the last line made dirty
+uint32_t s_dirtyCount = 0;
+bool s_writeBack = false;
+flash_hal_cache_stats s_stats;
+
+CacheLine *findLine(uint32_t lineAddr, bool touch = true) {
+    for (uint32_t i = 0; i < s_count; ++i) {
+        if (s_lines[i].addr == lineAddr) {
+            if (touch) {
+                s_lines[i].stamp = ++s_clock;
+            }
+            return &s_lines[i];
+        }
+    }
+    return nullptr;
+}
+
+int32_t writeBack(CacheLine &line) {
+    if (!line.dirtySeq) {
+        return FLASH_HAL_OK;
+    }
+    // Whole words program fastest; the bytes around the dirty range hold what
+    // the flash already has, so programming them again changes nothing
+    const uint32_t lo = line.dirtyLo & ~3U;
+    const uint32_t hi = (line.dirtyHi + 3U) & ~3U;
+    if (flash_hal_phys_write(line.addr + lo, hi - lo, line.data + lo) != FLASH_HAL_OK) {
+        return FLASH_HAL_WRITE_ERROR;
+    }
+    line.dirtyLo = line.dirtyHi = 0;
+    line.dirtySeq = 0;
+    if (!--s_dirtyCount) {
+        s_dirtySeq = 0; // Nothing pending, the numbering can restart
+    }
+    s_stats.writeBacks++;
+    return FLASH_HAL_OK;
+}
+
+// Write back, oldest first, the dirty lines written no later than seq
+int32_t syncUpTo(uint32_t seq) {
+    while (s_dirtyCount) {
+        CacheLine *oldest = nullptr;
+        for (uint32_t i = 0; i < s_count; ++i) {
+            if (s_lines[i].dirtySeq && (!oldest || s_lines[i].dirtySeq < oldest->dirtySeq)) {
+                oldest = &s_lines[i];
+            }
+        }
+        if (oldest->dirtySeq > seq) {
+            break;
+        }
+        if (writeBack(*oldest) != FLASH_HAL_OK) {
+            return FLASH_HAL_WRITE_ERROR;
+        }
+    }
+    return FLASH_HAL_OK;
+}
+
+// Evict the least recently used line and fill it from flash
+CacheLine *fillLine(uint32_t lineAddr, int32_t &rc) {
+    CacheLine *victim = &s_lines[0];
+    for (uint32_t i = 1; i < s_count && victim->addr != invalid; ++i) {
+        if (s_lines[i].addr == invalid || s_lines[i].stamp < victim->stamp) {
+            victim = &s_lines[i];
+        }
+    }
+    rc = syncUpTo(victim->dirtySeq);
+    if (rc != FLASH_HAL_OK) {
+        return nullptr;
+    }
+    victim->addr = invalid;
+    if (flash_hal_phys_read(lineAddr, lineSize, victim->data) != FLASH_HAL_OK) {
+        rc = FLASH_HAL_READ_ERROR;
+        return nullptr;
+    }
+    victim->addr = lineAddr;
+    victim->stamp = ++s_clock;
+    return victim;
+}
+
+// Length of the run of bytes from addr, at most size, that is not cached
+uint32_t uncachedRun(uint32_t addr, uint32_t size) {
+    uint32_t run = 0;
+    while (run < size && !findLine((addr + run) & ~lineMask, false)) {
+        run += std::min(size - run, lineSize - ((addr + run) & lineMask));
+    }
+    return run;
+}
+
+}; // namespace
+
+bool flash_hal_cache_begin(uint32_t size, bool writeBack) {
+    if (flash_hal_sync() != FLASH_HAL_OK) {
+        return false;
+    }
+    free(s_lines);
+    s_lines = nullptr;
+    s_count = 0;
+    s_writeBack = writeBack;
+    const uint32_t count = size / sizeof(CacheLine);
+    if (!count) {
+        return true;
+    }
+    s_lines = static_cast<CacheLine *>(malloc(count * sizeof(CacheLine)));
+    if (!s_lines) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        s_lines[i].addr = invalid;
+        s_lines[i].stamp = 0;
+        s_lines[i].dirtySeq = 0;
+        s_lines[i].dirtyLo = s_lines[i].dirtyHi = 0;
+    }
+    s_count = count;
+    s_clock = 0;
+    s_dirtySeq = 0;
+    s_dirtyCount = 0;
+    return true;
+}
+
+int32_t flash_hal_sync() {
+    return syncUpTo(UINT32_MAX);
+}
+
+void flash_hal_cache_get_stats(flash_hal_cache_stats *stats, bool reset) {
+    if (stats) {
+        *stats = s_stats;
+    }
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+    }
+}
+
+int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
+    if (!s_count) {
+        return flash_hal_phys_read(addr, size, dst);
+    }
+    // Large reads (file contents) would only flush the metadata out of the
+    // cache, so their uncached parts go to flash in single transfers
+    const bool bulk = size >= 2 * lineSize;
+    while (size) {
+        const uint32_t lineAddr = addr & ~lineMask;
+        const uint32_t offset = addr - lineAddr;
+        uint32_t len = std::min(size, lineSize - offset);
+        CacheLine *line = findLine(lineAddr);
+        if (line) {
+            s_stats.readHits++;
+            memcpy(dst, line->data + offset, len);
+        } else if (bulk) {
+            s_stats.readMisses++;
+            len = uncachedRun(addr, size);
+            if (flash_hal_phys_read(addr, len, dst) != FLASH_HAL_OK) {
+                return FLASH_HAL_READ_ERROR;
+            }
+        } else {
+            s_stats.readMisses++;
+            int32_t rc;
+            line = fillLine(lineAddr, rc);
+            if (!line) {
+                return rc;
+            }
+            memcpy(dst, line->data + offset, len);
+        }
+        addr += len;
+        dst += len;
+        size -= len;
+    }
+    return FLASH_HAL_OK;
+}
+
+int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
+    if (!s_count) {
+        return flash_hal_phys_write(addr, size, src);
+    }
+    while (size) {
+        const uint32_t lineAddr = addr & ~lineMask;
+        const uint32_t offset = addr - lineAddr;
+        uint32_t len = std::min(size, lineSize - offset);
+        CacheLine *line = findLine(lineAddr);
+        if (line) {
+            s_stats.writeHits++;
+        } else {
+            s_stats.writeMisses++;
+            if (!s_writeBack || len == lineSize) {
+                // Nothing to merge with: whole pages and write-through misses go
+                // straight to flash, in one transfer for consecutive pages,
+                // after the writes made before them
+                if (len == lineSize) {
+                    len = uncachedRun(addr, size) & ~lineMask;
+                }
+                if (flash_hal_sync() != FLASH_HAL_OK ||
+                    flash_hal_phys_write(addr, len, src) != FLASH_HAL_OK) {
+                    return FLASH_HAL_WRITE_ERROR;
+                }
+                addr += len;
+                src += len;
+                size -= len;
+                continue;
+            }
+            int32_t rc;
+            line = fillLine(lineAddr, rc);
+            if (!line) {
+                return rc;
+            }
+        }
+        if (s_writeBack && line->dirtySeq && line->dirtySeq != s_dirtySeq) {
+            // Other pages were written since this one, merging would reorder
+            if (flash_hal_sync() != FLASH_HAL_OK) {
+                return FLASH_HAL_WRITE_ERROR;
+            }
+        }
+        // Programming can only clear bits, keep the line equal to the flash
+        for (uint32_t i = 0; i < len; ++i) {
+            line->data[offset + i] &= src[i];
+        }
+        if (!s_writeBack) {
+            if (flash_hal_phys_write(addr, len, src) != FLASH_HAL_OK) {
+                return FLASH_HAL_WRITE_ERROR;
+            }
+        } else if (!line->dirtySeq) {
+            line->dirtySeq = ++s_dirtySeq;
+            line->dirtyLo = offset;
+            line->dirtyHi = offset + len;
+            s_dirtyCount++;
+        } else {
+            line->dirtyLo = std::min<uint32_t>(line->dirtyLo, offset);
+            line->dirtyHi = std::max<uint32_t>(line->dirtyHi, offset + len);
+        }
+        addr += len;
+        src += len;
+        size -= len;
+    }
+    return FLASH_HAL_OK;
+}
+
+int32_t flash_hal_erase(uint32_t addr, uint32_t size) {
+    // Everything written before the erase must be on the flash first: a
+    // filesystem erases a block once it has copied what it still needs from
+    // it, and the copies may be pending here
+    if (flash_hal_sync() != FLASH_HAL_OK) {
+        return FLASH_HAL_ERASE_ERROR;
+    }
+    for (uint32_t i = 0; i < s_count; ++i) {
+        CacheLine &line = s_lines[i];
+        if (line.addr != invalid && line.addr >= addr && line.addr < addr + size) {
+            line.addr = invalid;
+            line.stamp = 0;
+        }
+    }
+    return flash_hal_phys_erase(addr, size);
+}
+
+const uint8_t *flash_hal_map(uint32_t addr, uint32_t size) {
+    // Readers of mapped flash bypass the cache, so it must hold nothing newer
+    uint32_t seq = 0;
+    for (uint32_t i = 0; i < s_count; ++i) {
+        const CacheLine &line = s_lines[i];
+        if (line.dirtySeq && line.addr < addr + size && line.addr + lineSize > addr) {
+            seq = std::max(seq, line.dirtySeq);
+        }
+    }
+    if (seq && syncUpTo(seq) != FLASH_HAL_OK) {
+        return nullptr;
+    }
+    return flash_hal_phys_map(addr, size);
+}
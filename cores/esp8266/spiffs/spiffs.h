@@ -281,6 +281,17 @@ typedef struct spiffs_t {
 #endif
 #endif
 
+#if SPIFFS_NAME_CACHE
+  // name lookup cache memory, null if not used
+  void *name_cache;
+  // number of entries in name lookup cache
+  u32_t name_cache_count;
+  // lookups answered by the name lookup cache
+  u32_t name_cache_hits;
+  // lookups that scanned the file system
+  u32_t name_cache_misses;
+#endif
+
   // check callback function
   spiffs_check_callback check_cb_f;
   // file callback function
@@ -674,6 +685,22 @@ s32_t SPIFFS_gc_quick(spiffs *fs, u16_t max_free_pages);
  */
 s32_t SPIFFS_gc(spiffs *fs, u32_t size);
 
+/**
+ * Does a bounded part of the garbage collection ahead of demand: if fewer
+ * than min_free_blocks blocks are free and there are deleted pages, one
+ * block is reclaimed by moving the live pages, if any, out of the best
+ * block holding deleted pages and erasing it. Blocks are scored on deleted
+ * pages, used pages and erase age as for the collection in writes, but
+ * blocks without deleted pages are never moved. Writes collect garbage
+ * themselves when 3 or fewer blocks are free, so calling this while idle
+ * with min_free_blocks above that keeps the collection out of the writes.
+ * Returns 1 if a block was reclaimed, 0 if there was nothing to do.
+ *
+ * @param fs              the file system struct
+ * @param min_free_blocks number of free blocks to keep
+ */
+s32_t SPIFFS_gc_step(spiffs *fs, u32_t min_free_blocks);
+
 /**
  * Check if EOF reached.
  * @param fs            the file system struct
@@ -704,6 +731,23 @@ s32_t SPIFFS_tell(spiffs *fs, spiffs_file fh);
  */
 s32_t SPIFFS_set_file_callback_func(spiffs *fs, spiffs_file_callback cb_func);
 
+#if SPIFFS_NAME_CACHE
+/**
+ * Gives spiffs memory for a name lookup cache, used when finding files by
+ * name in open, stat, rename and remove. The cache starts empty and fills
+ * as names are looked up; lookups answered from it are counted in
+ * fs->name_cache_hits, lookups scanning the medium in fs->name_cache_misses.
+ * Must be invoked after mount, as mounting forgets the cache. Give a null
+ * cache to stop using it.
+ *
+ * @param fs            the file system struct
+ * @param cache         memory for the cache, owned by spiffs until unmount
+ * @param cache_size    size of the cache memory, see
+ *                      SPIFFS_buffer_bytes_for_name_cache
+ */
+s32_t SPIFFS_set_name_cache(spiffs *fs, void *cache, u32_t cache_size);
+#endif
+
 #if SPIFFS_IX_MAP
 
 /**
@@ -805,6 +849,14 @@ u32_t SPIFFS_buffer_bytes_for_filedescs(spiffs *fs, u32_t num_descs);
  */
 u32_t SPIFFS_buffer_bytes_for_cache(spiffs *fs, u32_t num_pages);
 #endif
+
+#if SPIFFS_NAME_CACHE
+/**
+ * Returns number of bytes needed for the name lookup cache given
+ * amount of entries.
+ */
+u32_t SPIFFS_buffer_bytes_for_name_cache(spiffs *fs, u32_t num_entries);
+#endif
 #endif
 
 #if SPIFFS_CACHE
@@ -310,6 +310,20 @@ typedef uint8_t u8_t;
 #define SPIFFS_TEMPORAL_CACHE_HIT_SCORE       4
 #endif
 
+// Enable to be able to give spiffs a name lookup cache after mounting.
+// Finding a file by name otherwise scans the object lookup pages of the
+// whole file system and reads every object index header on the way, for
+// each open, stat, rename or remove - also when the file does not exist.
+// The cache is a table of entries in memory provided by user, each
+// remembering where the object index header of a name lives, or that no
+// file has that name. Entries are kept coherent on create, rename, remove
+// and garbage collection, and found headers are still verified on the
+// medium before being trusted. Each entry costs SPIFFS_OBJ_NAME_LEN + 4
+// bytes, see SPIFFS_set_name_cache.
+#ifndef SPIFFS_NAME_CACHE
+#define SPIFFS_NAME_CACHE                     1
+#endif
+
 // Enable to be able to map object indices to memory.
 // This allows for faster and more deterministic reading if cases of reading
 // large files and when changing file offset by seeking around a lot.
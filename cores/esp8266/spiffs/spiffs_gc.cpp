@@ -197,6 +197,88 @@ s32_t spiffs_gc_check(
   return res;
 }
 
+// Counts the deleted pages in a block
+static s32_t spiffs_gc_deleted_pages(
+    spiffs *fs,
+    spiffs_block_ix bix,
+    u32_t *dele) {
+  s32_t res = SPIFFS_OK;
+  int obj_lookup_page = 0;
+  int entries_per_page = (SPIFFS_CFG_LOG_PAGE_SZ(fs) / sizeof(spiffs_obj_id));
+  spiffs_obj_id *obj_lu_buf = (spiffs_obj_id *)fs->lu_work;
+  int cur_entry = 0;
+
+  *dele = 0;
+  while (res == SPIFFS_OK && obj_lookup_page < (int)SPIFFS_OBJ_LOOKUP_PAGES(fs)) {
+    int entry_offset = obj_lookup_page * entries_per_page;
+    res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU | SPIFFS_OP_C_READ,
+        0, bix * SPIFFS_CFG_LOG_BLOCK_SZ(fs) + SPIFFS_PAGE_TO_PADDR(fs, obj_lookup_page), SPIFFS_CFG_LOG_PAGE_SZ(fs), fs->lu_work);
+    while (res == SPIFFS_OK &&
+        cur_entry - entry_offset < entries_per_page && cur_entry < (int)(SPIFFS_PAGES_PER_BLOCK(fs)-SPIFFS_OBJ_LOOKUP_PAGES(fs))) {
+      if (obj_lu_buf[cur_entry-entry_offset] == SPIFFS_OBJ_ID_DELETED) {
+        (*dele)++;
+      }
+      cur_entry++;
+    } // per entry
+    obj_lookup_page++;
+  } // per object lookup page
+  return res;
+}
+
+// Reclaims at most one block if fewer than min_free_blocks blocks are free,
+// so that garbage is collected while the system is idle rather than inside
+// a later write, which collects when 3 or fewer blocks are free. Returns 1
+// if a block was erased, SPIFFS_OK if there was nothing to reclaim.
+s32_t spiffs_gc_step(
+    spiffs *fs,
+    u32_t min_free_blocks) {
+  s32_t res;
+  spiffs_block_ix *cands;
+  int count;
+  spiffs_block_ix cand;
+  u32_t dele;
+
+  if (fs->free_blocks >= min_free_blocks || fs->stats_p_deleted == 0) {
+    return SPIFFS_OK;
+  }
+
+  // move the live pages, if any, out of a block holding deleted ones, ranked
+  // as the collection in writes does, erase age included, so that steps do
+  // not keep erasing the same blocks. Blocks of static data are not moved
+  // just to even out wear, only the collection in writes does that.
+  int max_candidates = MIN(fs->block_count, (SPIFFS_CFG_LOG_PAGE_SZ(fs)-8)/(sizeof(spiffs_block_ix) + sizeof(s32_t)));
+  dele = 0;
+  for (int crammed = 0; crammed < 2 && dele == 0; crammed++) {
+    // if none of the oldest blocks holds deleted pages, rank by garbage only
+    res = spiffs_gc_find_candidate(fs, &cands, &count, crammed);
+    SPIFFS_CHECK_RES(res);
+    // the candidates live in fs->work, spiffs_gc_deleted_pages uses fs->lu_work
+    for (int i = 0; i < MIN(count, max_candidates) && dele == 0; i++) {
+      cand = cands[i];
+      res = spiffs_gc_deleted_pages(fs, cand, &dele);
+      SPIFFS_CHECK_RES(res);
+    }
+  }
+  if (dele == 0) {
+    return SPIFFS_OK;
+  }
+  SPIFFS_GC_DBG("gc_step: cleaning block " _SPIPRIbl ", " _SPIPRIi " deleted pages\n", cand, dele);
+#if SPIFFS_GC_STATS
+  fs->stats_gc_runs++;
+#endif
+  fs->cleaning = 1;
+  res = spiffs_gc_clean(fs, cand);
+  fs->cleaning = 0;
+  SPIFFS_CHECK_RES(res);
+
+  res = spiffs_gc_erase_page_stats(fs, cand);
+  SPIFFS_CHECK_RES(res);
+
+  res = spiffs_gc_erase_block(fs, cand);
+  SPIFFS_CHECK_RES(res);
+  return 1;
+}
+
 // Updates page statistics for a block that is about to be erased
 s32_t spiffs_gc_erase_page_stats(
     spiffs *fs,
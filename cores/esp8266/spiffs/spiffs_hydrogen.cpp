@@ -24,6 +24,12 @@ u32_t SPIFFS_buffer_bytes_for_cache(spiffs *fs, u32_t num_pages) {
   return sizeof(spiffs_cache) + num_pages * (sizeof(spiffs_cache_page) + SPIFFS_CFG_LOG_PAGE_SZ(fs));
 }
 #endif
+#if SPIFFS_NAME_CACHE
+u32_t SPIFFS_buffer_bytes_for_name_cache(spiffs *fs, u32_t num_entries) {
+  (void)fs; // unused, avoid warning
+  return num_entries * sizeof(spiffs_name_cache_entry);
+}
+#endif
 #endif
 
 u8_t SPIFFS_mounted(spiffs *fs) {
@@ -1110,6 +1116,11 @@ s32_t SPIFFS_check(spiffs *fs) {
   SPIFFS_API_CHECK_MOUNT(fs);
   SPIFFS_LOCK(fs);
 
+#if SPIFFS_NAME_CACHE
+  // the checks move and delete pages without object events
+  spiffs_name_cache_clear(fs);
+#endif
+
   res = spiffs_lookup_consistency_check(fs, 0);
 
   res = spiffs_object_index_consistency_check(fs);
@@ -1187,6 +1198,25 @@ s32_t SPIFFS_gc(spiffs *fs, u32_t size) {
 #endif // SPIFFS_READ_ONLY
 }
 
+s32_t SPIFFS_gc_step(spiffs *fs, u32_t min_free_blocks) {
+  SPIFFS_API_DBG("%s " _SPIPRIi "\n", __func__, min_free_blocks);
+#if SPIFFS_READ_ONLY
+  (void)fs; (void)min_free_blocks;
+  return SPIFFS_ERR_RO_NOT_IMPL;
+#else
+  s32_t res;
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+
+  res = spiffs_gc_step(fs, min_free_blocks);
+
+  SPIFFS_API_CHECK_RES_UNLOCK(fs, res);
+  SPIFFS_UNLOCK(fs);
+  return res;
+#endif // SPIFFS_READ_ONLY
+}
+
 s32_t SPIFFS_eof(spiffs *fs, spiffs_file fh) {
   SPIFFS_API_DBG("%s " _SPIPRIfd "\n", __func__, fh);
   s32_t res;
@@ -1243,6 +1273,23 @@ s32_t SPIFFS_set_file_callback_func(spiffs *fs, spiffs_file_callback cb_func) {
   return 0;
 }
 
+#if SPIFFS_NAME_CACHE
+s32_t SPIFFS_set_name_cache(spiffs *fs, void *cache, u32_t cache_size) {
+  SPIFFS_API_DBG("%s " _SPIPRIi "\n", __func__, cache_size);
+  SPIFFS_API_CHECK_CFG(fs);
+  SPIFFS_API_CHECK_MOUNT(fs);
+  SPIFFS_LOCK(fs);
+  u32_t count = cache ? cache_size / sizeof(spiffs_name_cache_entry) : 0;
+  fs->name_cache = count ? cache : 0;
+  fs->name_cache_count = count;
+  fs->name_cache_hits = 0;
+  fs->name_cache_misses = 0;
+  spiffs_name_cache_clear(fs);
+  SPIFFS_UNLOCK(fs);
+  return SPIFFS_OK;
+}
+#endif
+
 #if SPIFFS_IX_MAP
 
 s32_t SPIFFS_ix_map(spiffs *fs,  spiffs_file fh, spiffs_ix_map *map,
@@ -1050,6 +1050,104 @@ s32_t spiffs_object_update_index_hdr(
 }
 #endif // !SPIFFS_READ_ONLY
 
+#if SPIFFS_NAME_CACHE
+// Name lookup cache. Entries are direct mapped by a hash of the name and
+// remember either the object index header page of a name, or that no object
+// has that name. Object events keep them coherent, and positive entries are
+// verified against the header on the medium when used.
+
+static spiffs_name_cache_entry *spiffs_name_cache_slot(spiffs *fs, const u8_t *name) {
+  // FNV-1a
+  u32_t hash = 2166136261UL;
+  u32_t i;
+  for (i = 0; i < SPIFFS_OBJ_NAME_LEN && name[i]; i++) {
+    hash = (hash ^ name[i]) * 16777619UL;
+  }
+  return &((spiffs_name_cache_entry *)fs->name_cache)[hash % fs->name_cache_count];
+}
+
+static void spiffs_name_cache_set(
+    spiffs *fs,
+    const u8_t *name,
+    spiffs_obj_id obj_id,
+    spiffs_page_ix pix) {
+  spiffs_name_cache_entry *e = spiffs_name_cache_slot(fs, name);
+  e->obj_id = obj_id;
+  e->pix = pix;
+  strncpy((char *)e->name, (const char *)name, SPIFFS_OBJ_NAME_LEN);
+}
+
+void spiffs_name_cache_clear(spiffs *fs) {
+  if (fs->name_cache) {
+    memset(fs->name_cache, 0, fs->name_cache_count * sizeof(spiffs_name_cache_entry));
+  }
+}
+
+// Returns SPIFFS_OK with the header page if the name is cached, SPIFFS_ERR_NOT_FOUND
+// if the name is cached as absent, or SPIFFS_VIS_COUNTINUE if the medium must be scanned
+static s32_t spiffs_name_cache_lookup(
+    spiffs *fs,
+    const u8_t *name,
+    spiffs_page_ix *pix) {
+  spiffs_name_cache_entry *e = spiffs_name_cache_slot(fs, name);
+  if (e->obj_id == SPIFFS_OBJ_ID_DELETED ||
+      strncmp((const char *)e->name, (const char *)name, SPIFFS_OBJ_NAME_LEN) != 0) {
+    return SPIFFS_VIS_COUNTINUE;
+  }
+  if (e->obj_id == SPIFFS_OBJ_ID_FREE) {
+    return SPIFFS_ERR_NOT_FOUND;
+  }
+  spiffs_page_object_ix_header objix_hdr;
+  s32_t res = _spiffs_rd(fs, SPIFFS_OP_T_OBJ_LU2 | SPIFFS_OP_C_READ,
+      0, SPIFFS_PAGE_TO_PADDR(fs, e->pix), sizeof(spiffs_page_object_ix_header), (u8_t *)&objix_hdr);
+  if (res == SPIFFS_OK &&
+      objix_hdr.p_hdr.obj_id == (e->obj_id | SPIFFS_OBJ_ID_IX_FLAG) &&
+      objix_hdr.p_hdr.span_ix == 0 &&
+      (objix_hdr.p_hdr.flags & (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_FINAL | SPIFFS_PH_FLAG_IXDELE)) ==
+          (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_IXDELE) &&
+      strncmp((const char *)objix_hdr.name, (const char *)name, SPIFFS_OBJ_NAME_LEN) == 0) {
+    *pix = e->pix;
+    return SPIFFS_OK;
+  }
+  // stale, forget it and scan
+  e->obj_id = SPIFFS_OBJ_ID_DELETED;
+  return SPIFFS_VIS_COUNTINUE;
+}
+
+// Follows an event on an object index header page
+static void spiffs_name_cache_event(
+    spiffs *fs,
+    spiffs_page_object_ix *objix,
+    int ev,
+    spiffs_obj_id obj_id,
+    spiffs_page_ix new_pix) {
+  spiffs_name_cache_entry *entries = (spiffs_name_cache_entry *)fs->name_cache;
+  // creating and renaming make names appear, and pass the full header
+  u8_t named = ev == SPIFFS_EV_IX_NEW || ev == SPIFFS_EV_IX_UPD_HDR;
+  const u8_t *name = named && objix ? ((spiffs_page_object_ix_header *)objix)->name : 0;
+  u32_t i;
+  for (i = 0; i < fs->name_cache_count; i++) {
+    spiffs_name_cache_entry *e = &entries[i];
+    if (e->obj_id == obj_id) {
+      if (ev == SPIFFS_EV_IX_DEL ||
+          (named && (name == 0 || strncmp((const char *)e->name, (const char *)name, SPIFFS_OBJ_NAME_LEN) != 0))) {
+        // removed or renamed
+        e->obj_id = SPIFFS_OBJ_ID_DELETED;
+      } else {
+        // moved or rewritten
+        e->pix = new_pix;
+      }
+    } else if (e->obj_id == SPIFFS_OBJ_ID_FREE && named && name == 0) {
+      // some unknown name appeared, it may be this one
+      e->obj_id = SPIFFS_OBJ_ID_DELETED;
+    }
+  }
+  if (name) {
+    spiffs_name_cache_set(fs, name, obj_id, new_pix);
+  }
+}
+#endif // SPIFFS_NAME_CACHE
+
 void spiffs_cb_object_event(
     spiffs *fs,
     spiffs_page_object_ix *objix,
@@ -1067,6 +1165,11 @@ void spiffs_cb_object_event(
   spiffs_fd *fds = (spiffs_fd *)fs->fd_space;
   SPIFFS_DBG("       CALLBACK  %s obj_id:" _SPIPRIid " spix:" _SPIPRIsp " npix:" _SPIPRIpg " nsz:" _SPIPRIi "\n", (const char *[]){"UPD", "NEW", "DEL", "MOV", "HUP","???"}[MIN(ev,5)],
       obj_id_raw, spix, new_pix, new_size);
+#if SPIFFS_NAME_CACHE
+  if (fs->name_cache && spix == 0) {
+    spiffs_name_cache_event(fs, objix, ev, obj_id, new_pix);
+  }
+#endif
   for (i = 0; i < fs->fd_count; i++) {
     spiffs_fd *cur_fd = &fds[i];
     if ((cur_fd->obj_id & ~SPIFFS_OBJ_ID_IX_FLAG) != obj_id) continue; // fd not related to updated file
@@ -1677,7 +1780,6 @@ static s32_t spiffs_object_find_object_index_header_by_name_v(
     int ix_entry,
     const void *user_const_p,
     void *user_var_p) {
-  (void)user_var_p;
   s32_t res;
   spiffs_page_object_ix_header objix_hdr;
   spiffs_page_ix pix = SPIFFS_OBJ_LOOKUP_ENTRY_TO_PIX(fs, bix, ix_entry);
@@ -1692,6 +1794,9 @@ static s32_t spiffs_object_find_object_index_header_by_name_v(
       (objix_hdr.p_hdr.flags & (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_FINAL | SPIFFS_PH_FLAG_IXDELE)) ==
           (SPIFFS_PH_FLAG_DELET | SPIFFS_PH_FLAG_IXDELE)) {
     if (strcmp((const char*)user_const_p, (char*)objix_hdr.name) == 0) {
+      if (user_var_p) {
+        *(spiffs_obj_id *)user_var_p = obj_id & ~SPIFFS_OBJ_ID_IX_FLAG;
+      }
       return SPIFFS_OK;
     }
   }
@@ -1707,6 +1812,22 @@ s32_t spiffs_object_find_object_index_header_by_name(
   s32_t res;
   spiffs_block_ix bix;
   int entry;
+  spiffs_obj_id obj_id = SPIFFS_OBJ_ID_FREE;
+
+#if SPIFFS_NAME_CACHE
+  if (fs->name_cache) {
+    spiffs_page_ix cached_pix = 0;
+    res = spiffs_name_cache_lookup(fs, name, &cached_pix);
+    if (res != SPIFFS_VIS_COUNTINUE) {
+      fs->name_cache_hits++;
+      if (res == SPIFFS_OK && pix) {
+        *pix = cached_pix;
+      }
+      return res;
+    }
+    fs->name_cache_misses++;
+  }
+#endif
 
   res = spiffs_obj_lu_find_entry_visitor(fs,
       fs->cursor_block_ix,
@@ -1715,13 +1836,19 @@ s32_t spiffs_object_find_object_index_header_by_name(
       0,
       spiffs_object_find_object_index_header_by_name_v,
       name,
-      0,
+      &obj_id,
       &bix,
       &entry);
 
   if (res == SPIFFS_VIS_END) {
     res = SPIFFS_ERR_NOT_FOUND;
   }
+#if SPIFFS_NAME_CACHE
+  if (fs->name_cache && (res == SPIFFS_OK || res == SPIFFS_ERR_NOT_FOUND)) {
+    spiffs_name_cache_set(fs, name, obj_id,
+        res == SPIFFS_OK ? SPIFFS_OBJ_LOOKUP_ENTRY_TO_PIX(fs, bix, entry) : 0);
+  }
+#endif
   SPIFFS_CHECK_RES(res);
 
   if (pix) {
@@ -521,6 +521,19 @@ typedef struct SPIFFS_PACKED {
  u8_t _align[4 - ((sizeof(spiffs_page_header)&3)==0 ? 4 : (sizeof(spiffs_page_header)&3))];
 } spiffs_page_object_ix;
 
+#if SPIFFS_NAME_CACHE
+// name lookup cache entry
+typedef struct {
+  // id of object without index flag, SPIFFS_OBJ_ID_DELETED if entry is
+  // unused, SPIFFS_OBJ_ID_FREE if no object has this name
+  spiffs_obj_id obj_id;
+  // object index header page
+  spiffs_page_ix pix;
+  // name of object
+  u8_t name[SPIFFS_OBJ_NAME_LEN];
+} spiffs_name_cache_entry;
+#endif
+
 // callback func for object lookup visitor
 typedef s32_t (*spiffs_visitor_f)(spiffs *fs, spiffs_obj_id id, spiffs_block_ix bix, int ix_entry,
     const void *user_const_p, void *user_var_p);
@@ -750,6 +763,10 @@ s32_t spiffs_gc_check(
     spiffs *fs,
     u32_t len);
 
+s32_t spiffs_gc_step(
+    spiffs *fs,
+    u32_t min_free_blocks);
+
 s32_t spiffs_gc_erase_page_stats(
     spiffs *fs,
     spiffs_block_ix bix);
@@ -790,6 +807,11 @@ void spiffs_fd_temporal_cache_rehash(
     const char *new_path);
 #endif
 
+#if SPIFFS_NAME_CACHE
+void spiffs_name_cache_clear(
+    spiffs *fs);
+#endif
+
 #if SPIFFS_CACHE
 void spiffs_cache_init(
     spiffs *fs);
@@ -76,8 +76,10 @@ public:
     , _pageSize(pageSize)
     , _blockSize(blockSize)
     , _maxOpenFds(maxOpenFds)
+    , _gcStepUs(_gcStepModelUs())
     {
         memset(&_fs, 0, sizeof(_fs));
+        memset(&_stats, 0, sizeof(_stats));
     }
 
     ~SPIFFSImpl()
@@ -100,6 +102,7 @@ public:
             return false;
         }
         auto rc = SPIFFS_rename(&_fs, pathFrom, pathTo);
+        flash_hal_sync();
         if (rc != SPIFFS_OK) {
             DEBUGV("SPIFFS_rename: rc=%d, from=`%s`, to=`%s`\r\n", rc,
                    pathFrom, pathTo);
@@ -146,6 +149,7 @@ public:
             return false;
         }
         auto rc = SPIFFS_remove(&_fs, path);
+        flash_hal_sync();
         if (rc != SPIFFS_OK) {
             DEBUGV("SPIFFS_remove: rc=%d path=`%s`\r\n", rc, path);
             return false;
@@ -204,9 +208,11 @@ public:
             return;
         }
         SPIFFS_unmount(&_fs);
+        flash_hal_sync();
         _workBuf.reset(nullptr);
         _fdsBuf.reset(nullptr);
         _cacheBuf.reset(nullptr);
+        _nameCacheBuf.reset(nullptr);
     }
 
     bool format() override
@@ -236,12 +242,71 @@ public:
 
     bool gc() override
     {
-        return SPIFFS_gc_quick( &_fs, 0 ) == SPIFFS_OK;
+        auto rc = SPIFFS_gc_quick( &_fs, 0 );
+        flash_hal_sync();
+        return rc == SPIFFS_OK;
     }
 
     bool check() override
     {
-        return SPIFFS_check(&_fs) == SPIFFS_OK;
+        auto rc = SPIFFS_check(&_fs);
+        flash_hal_sync();
+        return rc == SPIFFS_OK;
+    }
+
+    bool stats(FSStats& stats, bool reset) override
+    {
+        // Flash traffic is not tracked, the HAL callbacks have no context
+        if (SPIFFS_mounted(&_fs) == 0) {
+            memset(&stats, 0, sizeof(stats));
+            return false;
+        }
+        stats = _stats;
+#if SPIFFS_NAME_CACHE
+        stats.lookupHits = _fs.name_cache_hits;
+        stats.lookupMisses = _fs.name_cache_misses;
+        if (reset) {
+            _fs.name_cache_hits = 0;
+            _fs.name_cache_misses = 0;
+        }
+#endif
+        if (reset) {
+            memset(&_stats, 0, sizeof(_stats));
+        }
+        return true;
+    }
+
+    bool gcStep(uint32_t budgetUs) override
+    {
+        if (SPIFFS_mounted(&_fs) == 0) {
+            return false;
+        }
+        // A step reclaims one block and cannot be split, so one is started
+        // only when the estimate of a step still fits in what is left
+        uint32_t start = micros();
+        bool stepped = false;
+        while ((uint32_t)(micros() - start) + _gcStepUs <= budgetUs) {
+            uint32_t stepStart = micros();
+            auto rc = SPIFFS_gc_step(&_fs, gcFreeBlocks);
+            flash_hal_sync();
+            if (rc <= 0) {
+                if (rc < 0) {
+                    DEBUGV("SPIFFS_gc_step: rc=%d, err=%d\r\n", rc, _fs.err_code);
+                }
+                return false;
+            }
+            _stats.gcSteps++;
+            // Follow slower steps at once and faster ones a quarter of the way,
+            // never above the model: one outlier (an erase near the datasheet
+            // maximum, a long interrupt) must not keep every later step out of
+            // the budget
+            uint32_t stepUs = micros() - stepStart;
+            _gcStepUs = stepUs >= _gcStepUs ? stepUs : _gcStepUs - (_gcStepUs - stepUs) / 4;
+            _gcStepUs = std::min(_gcStepUs, _gcStepModelUs());
+            stepped = true;
+        }
+        // Also false when not even one step fits in budgetUs
+        return stepped;
     }
 
 protected:
@@ -316,6 +381,18 @@ protected:
 
         DEBUGV("SPIFFSImpl: mount rc=%d\r\n", err);
 
+#if SPIFFS_NAME_CACHE
+        if (err == SPIFFS_OK && _cfg._nameCache) {
+            // Mounting forgets the name cache, hand it back every time
+            size_t nameCacheBufSize = SPIFFS_buffer_bytes_for_name_cache(&_fs, _cfg._nameCache);
+            if (!_nameCacheBuf) {
+                DEBUGV("SPIFFSImpl: allocating %zd bytes of name cache\r\n", nameCacheBufSize);
+                _nameCacheBuf.reset(new uint8_t[nameCacheBufSize]);
+            }
+            SPIFFS_set_name_cache(&_fs, _nameCacheBuf.get(), nameCacheBufSize);
+        }
+#endif
+
         return err == SPIFFS_OK;
     }
 
@@ -354,6 +431,21 @@ protected:
     std::unique_ptr<uint8_t[]> _workBuf;
     std::unique_ptr<uint8_t[]> _fdsBuf;
     std::unique_ptr<uint8_t[]> _cacheBuf;
+    std::unique_ptr<uint8_t[]> _nameCacheBuf;
+
+    FSStats _stats;
+
+    // Writes collect garbage when 3 or fewer blocks are free, gcStep() aims for
+    // 5 so that a whole block can fill up before that happens
+    static constexpr uint32_t gcFreeBlocks = 5;
+    // Until measured, and at most, a step is assumed to cost the erase of
+    // its block at 50ms per sector, a little over typical SPI flash figures
+    static constexpr uint32_t gcSectorEraseUs = 50000;
+    uint32_t _gcStepModelUs() const
+    {
+        return _blockSize / FLASH_SECTOR_SIZE * gcSectorEraseUs;
+    }
+    uint32_t _gcStepUs;
 
     SPIFFSConfig _cfg;
 };
@@ -381,7 +473,9 @@ public:
     {
         CHECKFD();
 
+        uint32_t start = micros();
         auto result = SPIFFS_write(_fs->getFs(), _fd, (void*) buf, size);
+        _fs->_stats.addWriteLatency(micros() - start);
         if (result < 0) {
             DEBUGV("SPIFFS_write rc=%d\r\n", result);
             return 0;
@@ -406,7 +500,10 @@ public:
     {
         CHECKFD();
 
+        uint32_t start = micros();
         auto rc = SPIFFS_fflush(_fs->getFs(), _fd);
+        flash_hal_sync();
+        _fs->_stats.addWriteLatency(micros() - start);
         if (rc < 0) {
             DEBUGV("SPIFFS_fflush rc=%d\r\n", rc);
         }
@@ -480,6 +577,7 @@ public:
         CHECKFD();
 
         SPIFFS_close(_fs->getFs(), _fd);
+        flash_hal_sync();
         DEBUGV("SPIFFS_close: fd=%d\r\n", _fd);
     }
 
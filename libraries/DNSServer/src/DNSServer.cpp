@@ -2,6 +2,7 @@
 #include <lwip/def.h>
 #include <Arduino.h>
 #include <memory>
+#include <algorithm>
 
 #ifdef DEBUG_ESP_PORT
 #define DEBUG_OUTPUT DEBUG_ESP_PORT
@@ -13,8 +14,25 @@
 
 DNSServer::DNSServer()
 {
-  _ttl = lwip_htonl(60);
   _errorReplyCode = DNSReplyCode::NonExistentDomain;
+  _domainHash = 0;
+
+  // Rather than restate the name in the answer, we use a pointer to the name
+  // contained in the query section. Pointers have the top two bits set.
+  _answer[0] = 0xC0;
+  _answer[1] = DNS_HEADER_SIZE;
+  // Answer is type A (an IPv4 address)
+  _answer[2] = 0;
+  _answer[3] = DNS_QTYPE_A;
+  // Answer is in the Internet Class
+  _answer[4] = 0;
+  _answer[5] = DNS_QCLASS_IN;
+  // TTL at 6..9
+  setTTL(60);
+  // Length of RData is 4 bytes (because, in this case, RData is IPv4)
+  _answer[10] = 0;
+  _answer[11] = 4;
+  // address at 12..15, patched for each reply
 }
 
 bool DNSServer::start(const uint16_t &port, const String &domainName,
@@ -28,7 +46,62 @@ bool DNSServer::start(const uint16_t &port, const String &domainName,
   _resolvedIP[2] = resolvedIP[2];
   _resolvedIP[3] = resolvedIP[3];
   downcaseAndRemoveWwwPrefix(_domainName);
-  return _udp.begin(_port) == 1;
+  _domainHash = hashName(_domainName.c_str());
+
+  if (!_buffer)
+    _buffer.reset(new (std::nothrow) uint8_t[MAX_DNS_PACKETSIZE + DNS_ANSWER_SIZE]);
+  if (!_buffer || _udp.begin(_port) != 1)
+    return false;
+
+  // reuse reply buffers, the driver may still hold the last one sent
+  // while the next reply is built, so keep two
+  _udp.setTxPool(2);
+  return true;
+}
+
+bool DNSServer::addRecord(const String &domainName, const IPAddress &resolvedIP)
+{
+  Record record;
+  record.name = domainName;
+  downcaseAndRemoveWwwPrefix(record.name);
+  if (record.name.isEmpty() || record.name.length() > MAX_DNSNAME_LENGTH)
+    return false;
+  record.hash = hashName(record.name.c_str());
+  for (int i = 0; i < 4; i++)
+    record.ip[i] = resolvedIP[i];
+
+  auto it = std::lower_bound(_records.begin(), _records.end(), record.hash,
+                             [](const Record &r, uint32_t hash) { return r.hash < hash; });
+  for (auto same = it; same != _records.end() && same->hash == record.hash; ++same)
+    if (same->name == record.name)
+    {
+      memcpy(same->ip, record.ip, sizeof(record.ip));
+      return true;
+    }
+  _records.insert(it, std::move(record));
+  return true;
+}
+
+bool DNSServer::removeRecord(const String &domainName)
+{
+  String name = domainName;
+  downcaseAndRemoveWwwPrefix(name);
+  uint32_t hash = hashName(name.c_str());
+
+  auto it = std::lower_bound(_records.begin(), _records.end(), hash,
+                             [](const Record &r, uint32_t hash) { return r.hash < hash; });
+  for (; it != _records.end() && it->hash == hash; ++it)
+    if (it->name == name)
+    {
+      _records.erase(it);
+      return true;
+    }
+  return false;
+}
+
+void DNSServer::clearRecords()
+{
+  _records.clear();
 }
 
 void DNSServer::setErrorReplyCode(const DNSReplyCode &replyCode)
@@ -39,11 +112,14 @@ void DNSServer::setErrorReplyCode(const DNSReplyCode &replyCode)
 void DNSServer::setTTL(const uint32_t &ttl)
 {
   _ttl = lwip_htonl(ttl);
+  // already NBO
+  memcpy(&_answer[6], &_ttl, 4);
 }
 
 void DNSServer::stop()
 {
   _udp.stop();
+  _buffer.reset();
 }
 
 void DNSServer::downcaseAndRemoveWwwPrefix(String &domainName)
@@ -53,11 +129,80 @@ void DNSServer::downcaseAndRemoveWwwPrefix(String &domainName)
       domainName.remove(0, 4);
 }
 
+// FNV-1a over the dotted lowercase name
+uint32_t DNSServer::hashName(const char *name)
+{
+  uint32_t hash = 2166136261U;
+  for (; *name; ++name)
+    hash = (hash ^ (uint8_t) *name) * 16777619U;
+  return hash;
+}
+
+// same as hashName() over query labels, without building the dotted name
+uint32_t DNSServer::hashQuery(const uint8_t *labels)
+{
+  uint32_t hash = 2166136261U;
+  bool first = true;
+  while (*labels != 0) {
+    size_t labelLength = *labels++;
+    if (!first)
+      hash = (hash ^ '.') * 16777619U;
+    first = false;
+    while (labelLength--)
+      hash = (hash ^ (uint8_t) tolower(*labels++)) * 16777619U;
+  }
+  return hash;
+}
+
+bool DNSServer::matchQuery(const uint8_t *labels, const char *name)
+{
+  while (*labels != 0) {
+    size_t labelLength = *labels++;
+    while (labelLength > 0) {
+      if (tolower(*labels) != *name)
+        return false;
+      ++labels;
+      ++name;
+      --labelLength;
+    }
+    if (*labels == 0)
+      return *name == '\0';
+    if (*name != '.')
+      return false;
+    ++name;
+  }
+  return false;
+}
+
+// labels must be validated and 0-terminated, returns nullptr if unknown
+const unsigned char *DNSServer::lookup(const uint8_t *labels)
+{
+  // If there's a leading 'www', skip it
+  if (*labels == 3 && strncasecmp("www", (const char *) labels + 1, 3) == 0)
+    labels += 4;
+
+  uint32_t hash = hashQuery(labels);
+
+  auto it = std::lower_bound(_records.begin(), _records.end(), hash,
+                             [](const Record &r, uint32_t hash) { return r.hash < hash; });
+  for (; it != _records.end() && it->hash == hash; ++it)
+    if (matchQuery(labels, it->name.c_str()))
+      return it->ip;
+
+  // If we're running with a wildcard we can just return a result now
+  if (_domainName == "*")
+    return _resolvedIP;
+
+  if (!_domainName.isEmpty() && hash == _domainHash && matchQuery(labels, _domainName.c_str()))
+    return _resolvedIP;
+
+  return nullptr;
+}
+
 void DNSServer::respondToRequest(uint8_t *buffer, size_t length)
 {
   DNSHeader *dnsHeader;
   uint8_t *query, *start;
-  const char *matchString;
   size_t remaining, labelLength, queryLength;
   uint16_t qtype, qclass;
 
@@ -118,42 +263,9 @@ void DNSServer::respondToRequest(uint8_t *buffer, size_t length)
     return replyWithError(dnsHeader, DNSReplyCode::NonExistentDomain,
 			  query, queryLength);
 
-  // If we have no domain name configured, just return an error
-  if (_domainName.isEmpty())
-    return replyWithError(dnsHeader, _errorReplyCode,
-			  query, queryLength);
-
-  // If we're running with a wildcard we can just return a result now
-  if (_domainName == "*")
-    return replyWithIP(dnsHeader, query, queryLength);
-
-  matchString = _domainName.c_str();
-
-  start = query;
-
-  // If there's a leading 'www', skip it
-  if (*start == 3 && strncasecmp("www", (char *) start + 1, 3) == 0)
-      start += 4;
-
-  while (*start != 0) {
-    labelLength = *start;
-    start += 1;
-    while (labelLength > 0) {
-      if (tolower(*start) != *matchString)
-	return replyWithError(dnsHeader, _errorReplyCode,
-			      query, queryLength);
-      ++start;
-      ++matchString;
-      --labelLength;
-    }
-    if (*start == 0 && *matchString == '\0')
-      return replyWithIP(dnsHeader, query, queryLength);
-
-    if (*matchString != '.')
-      return replyWithError(dnsHeader, _errorReplyCode,
-			    query, queryLength);
-    ++matchString;
-  }
+  const unsigned char *ip = lookup(query);
+  if (ip)
+    return replyWithIP(dnsHeader, query, queryLength, ip);
 
   return replyWithError(dnsHeader, _errorReplyCode,
 			query, queryLength);
@@ -177,52 +289,32 @@ void DNSServer::processNextRequest()
   if (currentPacketSize < DNS_HEADER_SIZE)
     return;
 
-  std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[currentPacketSize]);
-  if (buffer == nullptr)
+  if (!_buffer)
     return;
 
-  _udp.read(buffer.get(), currentPacketSize);
-  respondToRequest(buffer.get(), currentPacketSize);
-}
-
-void DNSServer::writeNBOShort(uint16_t value)
-{
-   _udp.write((unsigned char *)&value, 2);
+  _udp.read(_buffer.get(), currentPacketSize);
+  respondToRequest(_buffer.get(), currentPacketSize);
 }
 
 void DNSServer::replyWithIP(DNSHeader *dnsHeader,
 			    unsigned char * query,
-			    size_t queryLength)
+			    size_t queryLength,
+			    const unsigned char *ip)
 {
-  uint16_t value;
-
   dnsHeader->QR = DNS_QR_RESPONSE;
   dnsHeader->QDCount = lwip_htons(1);
   dnsHeader->ANCount = lwip_htons(1);
   dnsHeader->NSCount = 0;
   dnsHeader->ARCount = 0;
 
-  _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-  _udp.write((unsigned char *) dnsHeader, sizeof(DNSHeader));
-  _udp.write(query, queryLength);
+  // query directly follows the header in _buffer, append the answer
+  // (room for it is reserved after MAX_DNS_PACKETSIZE)
+  unsigned char *answer = query + queryLength;
+  memcpy(answer, _answer, DNS_ANSWER_SIZE - 4);
+  memcpy(answer + DNS_ANSWER_SIZE - 4, ip, 4);
 
-  // Rather than restate the name here, we use a pointer to the name contained
-  // in the query section. Pointers have the top two bits set.
-  value = 0xC000 | DNS_HEADER_SIZE;
-  writeNBOShort(lwip_htons(value));
-
-  // Answer is type A (an IPv4 address)
-  writeNBOShort(lwip_htons(DNS_QTYPE_A));
-
-  // Answer is in the Internet Class
-  writeNBOShort(lwip_htons(DNS_QCLASS_IN));
-
-  // Output TTL (already NBO)
-  _udp.write((unsigned char*)&_ttl, 4);
-
-  // Length of RData is 4 bytes (because, in this case, RData is IPv4)
-  writeNBOShort(lwip_htons(sizeof(_resolvedIP)));
-  _udp.write(_resolvedIP, sizeof(_resolvedIP));
+  _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
+  _udp.write((unsigned char *) dnsHeader, DNS_HEADER_SIZE + queryLength + DNS_ANSWER_SIZE);
   _udp.endPacket();
 }
 
@@ -241,10 +333,9 @@ void DNSServer::replyWithError(DNSHeader *dnsHeader,
   dnsHeader->NSCount = 0;
   dnsHeader->ARCount = 0;
 
+  // query, if any, directly follows the header
   _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-  _udp.write((unsigned char *)dnsHeader, sizeof(DNSHeader));
-  if (query != NULL)
-     _udp.write(query, queryLength);
+  _udp.write((unsigned char *)dnsHeader, DNS_HEADER_SIZE + (query? queryLength: 0));
   _udp.endPacket();
 }
 
@@ -1,6 +1,8 @@
 #ifndef DNSServer_h
 #define DNSServer_h
 #include <WiFiUdp.h>
+#include <memory>
+#include <vector>
 
 #define DNS_QR_QUERY 0
 #define DNS_QR_RESPONSE 1
@@ -14,6 +16,7 @@
 
 #define MAX_DNSNAME_LENGTH 253
 #define MAX_DNS_PACKETSIZE 512
+#define DNS_ANSWER_SIZE 16 // name pointer, type, class, TTL, rdata length, IPv4
 
 enum class DNSReplyCode
 {
@@ -63,6 +66,12 @@ class DNSServer
     // stops the DNS server
     void stop();
 
+    // Additional name -> IP records, looked up before the domain given
+    // to start(). Names are case insensitive, a leading "www." is ignored.
+    bool addRecord(const String &domainName, const IPAddress &resolvedIP);
+    bool removeRecord(const String &domainName);
+    void clearRecords();
+
   private:
     WiFiUDP _udp;
     uint16_t _port;
@@ -70,11 +79,30 @@ class DNSServer
     unsigned char _resolvedIP[4];
     uint32_t _ttl;
     DNSReplyCode _errorReplyCode;
+    uint32_t _domainHash;
+
+    struct Record
+    {
+      uint32_t hash;
+      String name;          // normalized: lowercase, no www. prefix
+      unsigned char ip[4];
+    };
+    std::vector<Record> _records; // sorted by hash
+
+    // received query, reply is built in place
+    std::unique_ptr<uint8_t[]> _buffer;
+    // answer section, only the address is patched for each reply
+    unsigned char _answer[DNS_ANSWER_SIZE];
 
     void downcaseAndRemoveWwwPrefix(String &domainName);
+    static uint32_t hashName(const char *name);
+    static uint32_t hashQuery(const uint8_t *labels);
+    static bool matchQuery(const uint8_t *labels, const char *name);
+    const unsigned char *lookup(const uint8_t *labels);
     void replyWithIP(DNSHeader *dnsHeader,
 		     unsigned char * query,
-		     size_t queryLength);
+		     size_t queryLength,
+		     const unsigned char *ip);
     void replyWithError(DNSHeader *dnsHeader,
 			DNSReplyCode rcode,
 			unsigned char *query,
@@ -82,6 +110,5 @@ class DNSServer
     void replyWithError(DNSHeader *dnsHeader,
 			DNSReplyCode rcode);
     void respondToRequest(uint8_t *buffer, size_t length);
-    void writeNBOShort(uint16_t value);
 };
 #endif
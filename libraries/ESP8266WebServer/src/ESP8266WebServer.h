@@ -215,7 +215,7 @@ public:
     size_t contentLength = 0;
     _streamFileCore(file.size(), file.name(), contentType);
     if (requestMethod == HTTP_GET) {
-      contentLength = _currentClient.write(file);
+      contentLength = _streamFileBody(file);
     }
     return contentLength;
   }
@@ -252,6 +252,22 @@ protected:
 
   void _streamFileCore(const size_t fileSize, const String & fileName, const String & contentType);
 
+  template<typename T>
+  size_t _streamFileBody(T &file) {
+    return _currentClient.write(file);
+  }
+  // Files stored contiguously in mapped flash are sent from there, without the FS read path
+  size_t _streamFileBody(fs::File &file) {
+    const uint8_t* mapped = file.mapped();
+    if (!mapped) {
+      return _currentClient.write(file);
+    }
+    size_t pos = file.position();
+    size_t sent = _currentClient.write_P((PGM_P)(mapped + pos), file.size() - pos);
+    file.seek(pos + sent, SeekSet);
+    return sent;
+  }
+
   static String _getRandomHexString();
   // for extracting Auth parameters
   String _extractParam(String& authReq,const String& param,const char delimit = '"') const;
@@ -147,6 +147,20 @@ public:
         if (_cache_header.length() != 0)
             server.sendHeader("Cache-Control", _cache_header);
 
+        // Read-only images carry a content hash: send it as ETag, and answer 304 when the
+        // client already has it (If-None-Match must be in collectHeaders() for that)
+        uint64_t hash = f.contentHash();
+        if (hash) {
+            char etag[19];
+            snprintf(etag, sizeof(etag), "\"%08x%08x\"", (unsigned)(hash >> 32), (unsigned)hash);
+            server.sendHeader("ETag", etag);
+            if (server.header("If-None-Match") == etag) {
+                f.close();
+                server.send(304);
+                return true;
+            }
+        }
+
         server.streamFile(f, contentType, requestMethod);
         return true;
     }
@@ -7,6 +7,11 @@
 // You do not need to generate the ".IDX" file listed below,
 // it is generated automatically when the CertStore object
 // is created and written to SD or LittleFS by the ESP8266.
+// Alternatively, the script also writes "certs_idx.h" with a
+// sorted PROGMEM index of the same .AR file: include it and call
+// certStore.initCertStore(LittleFS, certs_idx,
+//   sizeof(certs_idx) / sizeof(certs_idx[0]), PSTR("/certs.ar"))
+// to skip the preprocessing step at boot.
 //
 // Why would you need a CertStore?
 //
@@ -6,9 +6,14 @@
 # Upload these to an on-chip filesystem and use the CertManager to parse
 # and use them for your outgoing SSL connections.
 #
+# It also writes certs_idx.h, a sorted PROGMEM index of data/certs.ar which
+# can be passed to CertStore::initCertStore() so the ESP8266 doesn't need
+# to preprocess the archive or keep an index file.
+#
 # Script by Earle F. Philhower, III.  Released to the public domain.
 from __future__ import print_function
 import csv
+import hashlib
 import os
 import sys
 from shutil import which
@@ -79,3 +84,49 @@ call( arCmd )
 
 for der in derFiles:
     os.unlink(der)
+
+# Length of the DER TLV starting at der[pos], and the offset of its contents
+def der_tlv(der, pos):
+    length = der[pos + 1]
+    hdr = 2
+    if length & 0x80:
+        nbytes = length & 0x7f
+        length = int.from_bytes(der[pos + 2:pos + 2 + nbytes], 'big')
+        hdr += nbytes
+    return hdr + length, pos + hdr
+
+# SHA256 of the subject DN, the same hash BearSSL uses for hashed_dn lookups
+def subject_hash(der):
+    _, tbs = der_tlv(der, 0)      # Certificate
+    _, pos = der_tlv(der, tbs)    # TBSCertificate
+    if der[pos] == 0xa0:          # [0] version, optional
+        pos += der_tlv(der, pos)[0]
+    for field in range(4):        # serial, signature, issuer, validity
+        pos += der_tlv(der, pos)[0]
+    size, _ = der_tlv(der, pos)   # subject
+    return hashlib.sha256(der[pos:pos + size]).digest()
+
+# Walk the archive the same way CertStore::initCertStore() does
+index = []
+with open("data/certs.ar", "rb") as f:
+    ar = bytearray(f.read())
+offset = 8
+while offset + 60 <= len(ar):
+    header = ar[offset:offset + 60]
+    offset += 60
+    length = int(header[48:58].decode('ascii').strip() or 0)
+    if not length:
+        break
+    if header[0:2] != b'//':
+        index.append((subject_hash(ar[offset:offset + length]), offset, length))
+    offset += length + (length & 1)
+index.sort()
+
+with open("certs_idx.h", "w") as f:
+    f.write("// Generated by certs-from-mozilla.py, only valid with the matching data/certs.ar\n")
+    f.write("#include <CertStoreBearSSL.h>\n\n")
+    f.write("static const BearSSL::CertStore::CertInfo certs_idx[] PROGMEM = {\n")
+    for sha, off, length in index:
+        f.write("  { { %s }, %d, %d },\n" % (", ".join("0x%02x" % b for b in sha), off, length))
+    f.write("};\n")
+print("Wrote certs_idx.h with %d entries" % len(index))
@@ -30,6 +30,7 @@
 #include <Arduino.h>
 #include <StackThunk.h>
 #include <Updater_Signing.h>
+#include <coredecls.h>
 #ifndef ARDUINO_SIGNING
   #define ARDUINO_SIGNING 0
 #endif
@@ -872,6 +873,440 @@ bool X509List::append(const uint8_t *derCert, size_t derLen) {
   return true;
 }
 
+// ----- Session Cache -----
+
+// Serialized form: header, then one record per valid entry, each followed
+// by its host name (hostLen bytes, no terminator), then CRC32 of all that
+static const uint32_t SESSION_CACHE_MAGIC = 0x42534333; // "BSC3"
+
+struct SessionCacheHeader {
+  uint32_t magic;
+  uint16_t count;
+  uint16_t recordSize;
+  uint32_t length;  // Of the whole serialized form, CRC included
+};
+
+struct SessionCacheRecord {
+  uint32_t key;
+  uint16_t port;
+  uint16_t mfln;
+  uint16_t hostLen;
+  uint16_t reserved;
+  br_ssl_session_parameters params;
+};
+
+SessionCache::SessionCache(size_t size) {
+  _size = size ? size : 1;
+  _entries = new (std::nothrow) Entry[_size];
+  if (!_entries) {
+    _size = 0;
+  }
+  for (size_t i = 0; i < _size; i++) {
+    _entries[i].host = nullptr;
+  }
+  _stamp = 0;
+  _full = 0;
+  _resumed = 0;
+  clear();
+}
+
+SessionCache::~SessionCache() {
+  clear();
+  delete[] _entries;
+}
+
+void SessionCache::clear() {
+  for (size_t i = 0; i < _size; i++) {
+    free(_entries[i].host);
+    _entries[i].host = nullptr;
+    _entries[i].key = 0;
+    _entries[i].port = 0;
+    _entries[i].mfln = 0;
+    _entries[i].used = 0;
+    _entries[i].session = Session();
+  }
+}
+
+size_t SessionCache::getCount() const {
+  size_t cnt = 0;
+  for (size_t i = 0; i < _size; i++) {
+    if (_entries[i].used) {
+      cnt++;
+    }
+  }
+  return cnt;
+}
+
+uint32_t SessionCache::_hash(const char *host) {
+  // FNV-1a, names are case insensitive
+  uint32_t h = 2166136261UL;
+  while (host && *host) {
+    h ^= (uint8_t)tolower(*host++);
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+SessionCache::Entry *SessionCache::_find(const char *host, uint32_t key, uint16_t port) {
+  for (size_t i = 0; i < _size; i++) {
+    const Entry *e = &_entries[i];
+    // Different names can share a hash, only the name itself tells them apart
+    if (e->used && e->key == key && e->port == port && !strcasecmp(e->host, host ? host : "")) {
+      return &_entries[i];
+    }
+  }
+  return nullptr;
+}
+
+bool SessionCache::_setHost(Entry *e, const char *host, size_t len) {
+  char *copy = (char *)realloc(e->host, len + 1);
+  if (!copy) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    copy[i] = tolower(host[i]);
+  }
+  copy[len] = 0;
+  e->host = copy;
+  return true;
+}
+
+Session *SessionCache::_get(const char *host, uint16_t port) {
+  if (!_size) {
+    return nullptr;
+  }
+  if (!host) {
+    host = "";
+  }
+  uint32_t key = _hash(host);
+  Entry *e = _find(host, key, port);
+  if (!e) {
+    // Take a free slot or recycle the least recently used one
+    e = &_entries[0];
+    for (size_t i = 1; i < _size && e->used; i++) {
+      if (!_entries[i].used || _entries[i].used < e->used) {
+        e = &_entries[i];
+      }
+    }
+    e->used = 0;
+    e->mfln = 0;
+    e->session = Session();
+    if (!_setHost(e, host, strlen(host))) {
+      return nullptr;
+    }
+    e->key = key;
+    e->port = port;
+  }
+  e->used = ++_stamp;
+  return &e->session;
+}
+
+void SessionCache::_forget(Session *session) {
+  for (size_t i = 0; i < _size; i++) {
+    if (&_entries[i].session == session) {
+      _entries[i].session = Session();
+      // The MFLN result is still good
+      if (!_entries[i].mfln) {
+        _entries[i].used = 0;
+      }
+    }
+  }
+}
+
+uint16_t SessionCache::_getMFLN(Session *session) {
+  for (size_t i = 0; i < _size; i++) {
+    if (&_entries[i].session == session) {
+      return _entries[i].mfln;
+    }
+  }
+  return 0;
+}
+
+void SessionCache::_setMFLN(Session *session, uint16_t mfln) {
+  for (size_t i = 0; i < _size; i++) {
+    if (&_entries[i].session == session) {
+      _entries[i].mfln = mfln;
+      if (!_entries[i].used) {
+        _entries[i].used = ++_stamp;
+      }
+    }
+  }
+}
+
+void SessionCache::remove(const char *host, uint16_t port) {
+  Entry *e = _find(host, _hash(host), port);
+  if (e) {
+    e->used = 0;
+    e->mfln = 0;
+    e->session = Session();
+  }
+}
+
+bool SessionCache::_persistable(const Entry *e) {
+  return e->used && (e->session._session.session_id_len || e->mfln) && strlen(e->host) <= 0xffff;
+}
+
+size_t SessionCache::serializedSize() const {
+  size_t len = sizeof(SessionCacheHeader) + sizeof(uint32_t);
+  for (size_t i = 0; i < _size; i++) {
+    if (_persistable(&_entries[i])) {
+      len += sizeof(SessionCacheRecord) + strlen(_entries[i].host);
+    }
+  }
+  return len;
+}
+
+size_t SessionCache::serialize(uint8_t *buf, size_t len) const {
+  size_t need = serializedSize();
+  if (!buf || len < need) {
+    return 0;
+  }
+  SessionCacheHeader hdr;
+  hdr.magic = SESSION_CACHE_MAGIC;
+  hdr.count = 0;
+  for (size_t i = 0; i < _size; i++) {
+    hdr.count += _persistable(&_entries[i]) ? 1 : 0;
+  }
+  hdr.recordSize = sizeof(SessionCacheRecord);
+  hdr.length = need;
+  memcpy(buf, &hdr, sizeof(hdr));
+  uint8_t *ptr = buf + sizeof(hdr);
+  // Most recently used first, so a smaller cache loading this keeps the best ones
+  uint32_t below = UINT32_MAX;
+  for (int n = 0; n < hdr.count; n++) {
+    const Entry *best = nullptr;
+    for (size_t i = 0; i < _size; i++) {
+      const Entry *e = &_entries[i];
+      if (_persistable(e) && e->used < below && (!best || e->used > best->used)) {
+        best = e;
+      }
+    }
+    SessionCacheRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.key = best->key;
+    rec.port = best->port;
+    rec.mfln = best->mfln;
+    rec.hostLen = strlen(best->host);
+    rec.params = best->session._session;
+    memcpy(ptr, &rec, sizeof(rec));
+    ptr += sizeof(rec);
+    memcpy(ptr, best->host, rec.hostLen);
+    ptr += rec.hostLen;
+    below = best->used;
+  }
+  uint32_t crc = crc32(buf, ptr - buf);
+  memcpy(ptr, &crc, sizeof(crc));
+  return need;
+}
+
+bool SessionCache::deserialize(const uint8_t *buf, size_t len) {
+  SessionCacheHeader hdr;
+  if (!buf || len < sizeof(hdr) + sizeof(uint32_t)) {
+    return false;
+  }
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.magic != SESSION_CACHE_MAGIC || hdr.recordSize != sizeof(SessionCacheRecord) ||
+      hdr.length < sizeof(hdr) + sizeof(uint32_t) || len < hdr.length) {
+    return false;
+  }
+  size_t body = hdr.length - sizeof(uint32_t);
+  uint32_t crc;
+  memcpy(&crc, buf + body, sizeof(crc));
+  if (crc != crc32(buf, body)) {
+    return false;
+  }
+  // Check every record fits before touching the current contents
+  const uint8_t *ptr = buf + sizeof(hdr);
+  for (size_t n = 0; n < hdr.count; n++) {
+    SessionCacheRecord rec;
+    if ((size_t)(buf + body - ptr) < sizeof(rec)) {
+      return false;
+    }
+    memcpy(&rec, ptr, sizeof(rec));
+    if ((size_t)(buf + body - ptr) < sizeof(rec) + rec.hostLen) {
+      return false;
+    }
+    ptr += sizeof(rec) + rec.hostLen;
+  }
+  clear();
+  // Records are most recent first, the first ones go to the end of the
+  // table with the highest stamps so the LRU order is kept.  If we're
+  // smaller than the saved cache, the oldest ones are dropped.
+  size_t keep = std::min<size_t>(hdr.count, _size);
+  ptr = buf + sizeof(hdr);
+  for (size_t n = 0; n < keep; n++) {
+    SessionCacheRecord rec;
+    memcpy(&rec, ptr, sizeof(rec));
+    ptr += sizeof(rec);
+    Entry *e = &_entries[keep - 1 - n];
+    if (_setHost(e, (const char *)ptr, rec.hostLen)) {
+      e->key = rec.key;
+      e->port = rec.port;
+      e->mfln = rec.mfln;
+      e->used = _stamp + keep - n;
+      e->session._session = rec.params;
+    }
+    ptr += rec.hostLen;
+  }
+  _stamp += keep;
+  return true;
+}
+
+bool SessionCache::save(Print& out) const {
+  size_t len = serializedSize();
+  std::unique_ptr<uint8_t[]> buf(new (std::nothrow) uint8_t[len]);
+  if (!buf || !serialize(buf.get(), len)) {
+    return false;
+  }
+  return out.write(buf.get(), len) == len;
+}
+
+bool SessionCache::load(Stream& in) {
+  SessionCacheHeader hdr;
+  if (in.readBytes((char *)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != SESSION_CACHE_MAGIC ||
+      hdr.recordSize != sizeof(SessionCacheRecord) || hdr.length < sizeof(hdr) + sizeof(uint32_t)) {
+    return false;
+  }
+  size_t len = hdr.length;
+  std::unique_ptr<uint8_t[]> buf(new (std::nothrow) uint8_t[len]);
+  if (!buf) {
+    return false;
+  }
+  memcpy(buf.get(), &hdr, sizeof(hdr));
+  size_t rest = len - sizeof(hdr);
+  if (in.readBytes((char *)buf.get() + sizeof(hdr), rest) != rest) {
+    return false;
+  }
+  return deserialize(buf.get(), len);
+}
+
+bool SessionCache::saveToRTC(uint32_t offset) const {
+  size_t len = (serializedSize() + 3) & ~3;
+  std::unique_ptr<uint32_t[]> buf(new (std::nothrow) uint32_t[len / 4]);
+  if (!buf || !serialize((uint8_t *)buf.get(), len)) {
+    return false;
+  }
+  return ESP.rtcUserMemoryWrite(offset, buf.get(), len);
+}
+
+bool SessionCache::loadFromRTC(uint32_t offset) {
+  // RTC user memory is only 512 bytes, read the header first to size things
+  uint32_t hdr[(sizeof(SessionCacheHeader) + 3) / 4];
+  if (!ESP.rtcUserMemoryRead(offset, hdr, sizeof(hdr))) {
+    return false;
+  }
+  SessionCacheHeader h;
+  memcpy(&h, hdr, sizeof(h));
+  if (h.magic != SESSION_CACHE_MAGIC || h.recordSize != sizeof(SessionCacheRecord) ||
+      h.length < sizeof(h) + sizeof(uint32_t) || h.length > 512) {
+    return false;
+  }
+  size_t len = (h.length + 3) & ~3;
+  std::unique_ptr<uint32_t[]> buf(new (std::nothrow) uint32_t[len / 4]);
+  if (!buf || !ESP.rtcUserMemoryRead(offset, buf.get(), len)) {
+    return false;
+  }
+  return deserialize((const uint8_t *)buf.get(), len);
+}
+
+// ----- Server Sessions -----
+
+const br_ssl_session_cache_class ServerSessions::_class = {
+  sizeof(ServerSessions),
+  ServerSessions::_save,
+  ServerSessions::_load
+};
+
+ServerSessions::ServerSessions(uint32_t size) {
+  uint32_t len = size * ENTRY_SIZE;
+  unsigned char *store = (unsigned char *)malloc(len);
+  _init(store, store ? len : 0);
+  _allocated = true;
+}
+
+ServerSessions::ServerSessions(void *store, uint32_t len) {
+  _init(store, store ? len : 0);
+  _allocated = false;
+}
+
+ServerSessions::~ServerSessions() {
+  if (_allocated) {
+    free(_store);
+  }
+}
+
+void ServerSessions::_init(void *store, uint32_t len) {
+  _vtable = &_class;
+  _store = (unsigned char *)store;
+  _len = len - (len % ENTRY_SIZE);
+  _lookups = 0;
+  _hits = 0;
+  _stored = 0;
+  br_ssl_session_cache_lru_init(&_lru, _store, _len);
+}
+
+void ServerSessions::_save(const br_ssl_session_cache_class **ctx, br_ssl_server_context *server_ctx,
+                           const br_ssl_session_parameters *params) {
+  ServerSessions *me = reinterpret_cast<ServerSessions *>(ctx);
+  me->_stored++;
+  me->_lru.vtable->save(&me->_lru.vtable, server_ctx, params);
+}
+
+int ServerSessions::_load(const br_ssl_session_cache_class **ctx, br_ssl_server_context *server_ctx,
+                          br_ssl_session_parameters *params) {
+  ServerSessions *me = reinterpret_cast<ServerSessions *>(ctx);
+  me->_lookups++;
+  int found = me->_lru.vtable->load(&me->_lru.vtable, server_ctx, params);
+  if (found) {
+    me->_hits++;
+  }
+  return found;
+}
+
+// ----- Buffer Pool -----
+
+BufferPool::BufferPool(int count, int recv, int xmit) {
+  // Same limits and protocol overhead as WiFiClientSecure::setBufferSizes()
+  _recv_size = std::max(512, std::min(16384, recv)) + 325;
+  _xmit_size = std::max(512, std::min(16384, xmit)) + 85;
+  _count = std::max(0, std::min(32, count));
+  _storage = std::make_shared<Storage>();
+  _storage->recv = (unsigned char *)malloc(_count * _recv_size);
+  _storage->xmit = (unsigned char *)malloc(_count * _xmit_size);
+  if (!_storage->recv || !_storage->xmit) {
+    free(_storage->recv);
+    free(_storage->xmit);
+    _storage->recv = nullptr;
+    _storage->xmit = nullptr;
+    _count = 0;
+  }
+  _storage->recv_free = _storage->xmit_free = (_count == 32) ? UINT32_MAX : (1UL << _count) - 1;
+  _fallbacks = 0;
+}
+
+BufferPool::~BufferPool() {
+  // Buffers still borrowed hold their own reference to _storage
+}
+
+int BufferPool::available() const {
+  return std::min(__builtin_popcount(_storage->recv_free), __builtin_popcount(_storage->xmit_free));
+}
+
+std::shared_ptr<unsigned char> BufferPool::_acquire(bool recv, int len) {
+  uint32_t *mask = recv ? &_storage->recv_free : &_storage->xmit_free;
+  int size = recv ? _recv_size : _xmit_size;
+  if (len > size || !*mask) {
+    return nullptr;
+  }
+  int idx = __builtin_ctz(*mask);
+  *mask &= ~(1UL << idx);
+  unsigned char *buf = (recv ? _storage->recv : _storage->xmit) + idx * size;
+  std::shared_ptr<Storage> storage = _storage;
+  return std::shared_ptr<unsigned char>(buf, [storage, mask, idx](unsigned char *) {
+    *mask |= 1UL << idx;
+  });
+}
+
 // SHA256 hash for updater
 void HashSHA256::begin() {
   br_sha256_init( &_cc );
@@ -26,6 +26,7 @@
 #include <bearssl/bearssl.h>
 #include <StackThunk.h>
 #include <Updater.h>
+#include <memory>
 
 // Internal opaque structures, not needed by user applications
 namespace brssl {
@@ -135,6 +136,7 @@ class WiFiClientSecure;
 
 class Session {
   friend class WiFiClientSecure;
+  friend class SessionCache;
 
   public:
     Session() { memset(&_session, 0, sizeof(_session)); }
@@ -144,6 +146,158 @@ class Session {
     br_ssl_session_parameters _session;
 };
 
+// Bounded set of Sessions keyed by host and port, least recently used one
+// is recycled when full.  Attach to a WiFiClientSecure (or install as the
+// default for all of them) and connect() will offer the saved session to
+// the server automatically, and remember whether it accepted a smaller
+// fragment length (MFLN).  Contents can be saved to RTC memory or a file
+// to survive deep sleep.
+class SessionCache {
+  friend class WiFiClientSecure;
+
+  public:
+    SessionCache(size_t size = 4);
+    ~SessionCache();
+
+    void clear();
+    // Drop any saved session for the given host:port
+    void remove(const char *host, uint16_t port);
+
+    size_t getSize() const { return _size; }
+    size_t getCount() const;
+
+    // Handshakes done through this cache, full ones vs. resumed sessions
+    uint32_t getFullHandshakes() const { return _full; }
+    uint32_t getResumedHandshakes() const { return _resumed; }
+    void resetStats() { _full = _resumed = 0; }
+
+    // Persistence.  RTC offset is in 4-byte blocks, as ESP.rtcUserMemoryWrite()
+    size_t serializedSize() const;
+    size_t serialize(uint8_t *buf, size_t len) const;
+    bool deserialize(const uint8_t *buf, size_t len);
+    bool save(Print& out) const;
+    bool load(Stream& in);
+    bool saveToRTC(uint32_t offset = 0) const;
+    bool loadFromRTC(uint32_t offset = 0);
+
+    // Disable the copy constructor, we're pointer based
+    SessionCache(const SessionCache& that) = delete;
+
+  private:
+    struct Entry {
+      char *host;     // Lowercased copy of the host name, owned by the entry
+      uint32_t key;   // Hash of host, checked before comparing the names
+      uint16_t port;
+      uint16_t mfln;  // Negotiated fragment length, 0 if unknown
+      uint32_t used;  // LRU stamp, 0 if slot is free
+      Session session;
+    };
+    static constexpr uint16_t MFLN_UNSUPPORTED = 0xffff;
+
+    static uint32_t _hash(const char *host);
+    Entry *_find(const char *host, uint32_t key, uint16_t port);
+    static bool _setHost(Entry *e, const char *host, size_t len);
+    // Returns the Session slot to use for this host:port, recycling the LRU one if needed
+    Session *_get(const char *host, uint16_t port);
+    void _forget(Session *session);
+    static bool _persistable(const Entry *e);
+    // Per host:port fragment length results, for automatic MFLN
+    uint16_t _getMFLN(Session *session);
+    void _setMFLN(Session *session, uint16_t mfln);
+    void _count(bool resumed) { if (resumed) _resumed++; else _full++; }
+
+    Entry *_entries;
+    size_t _size;
+    uint32_t _stamp;
+    uint32_t _full;
+    uint32_t _resumed;
+};
+
+// Server side session cache, shared by all clients accepted from a
+// WiFiServerSecure so browsers opening several connections only pay for
+// one full handshake.  Wraps BearSSL's LRU cache and counts lookups.
+class ServerSessions {
+  public:
+    // Room for `size` sessions, 100 bytes each
+    ServerSessions(uint32_t size);
+    // Use a caller supplied buffer (i.e. static) of `len` bytes
+    ServerSessions(void *store, uint32_t len);
+    ~ServerSessions();
+
+    uint32_t size() const { return _len / ENTRY_SIZE; }
+
+    // Resumption attempts from clients, how many found their session, and
+    // how many new sessions were stored (full handshakes)
+    uint32_t getLookups() const { return _lookups; }
+    uint32_t getHits() const { return _hits; }
+    uint32_t getStored() const { return _stored; }
+    void resetStats() { _lookups = _hits = _stored = 0; }
+
+    // For internal use, nullptr if the storage could not be allocated
+    const br_ssl_session_cache_class **getCache() { return _len ? &_vtable : nullptr; }
+
+    // Disable the copy constructor, we're pointer based
+    ServerSessions(const ServerSessions& that) = delete;
+
+  private:
+    static constexpr uint32_t ENTRY_SIZE = 100; // Fixed by BearSSL
+    void _init(void *store, uint32_t len);
+    static void _save(const br_ssl_session_cache_class **ctx, br_ssl_server_context *server_ctx,
+                      const br_ssl_session_parameters *params);
+    static int _load(const br_ssl_session_cache_class **ctx, br_ssl_server_context *server_ctx,
+                     br_ssl_session_parameters *params);
+    static const br_ssl_session_cache_class _class;
+
+    // Must stay first, BearSSL hands &_vtable back to _save/_load
+    const br_ssl_session_cache_class *_vtable;
+    br_ssl_session_cache_lru _lru;
+    unsigned char *_store;
+    bool _allocated;
+    uint32_t _len;
+    uint32_t _lookups;
+    uint32_t _hits;
+    uint32_t _stored;
+};
+
+// Fixed set of TLS I/O buffers allocated once (i.e. at boot, before the heap
+// fragments) which WiFiClientSecure connections borrow while they are open
+// and give back when freed.  Several connections can then share a bounded
+// amount of heap.  Connections needing more than the pool's buffer sizes,
+// or arriving when it is empty, fall back to regular heap allocations.
+class BufferPool {
+  public:
+    // Sizes are as for WiFiClientSecure::setBufferSizes(), at most 32 buffers
+    BufferPool(int count, int recv = 16384, int xmit = 512);
+    ~BufferPool();
+
+    int size() const { return _count; }
+    int available() const;
+    // Connections which had to allocate from the heap instead
+    uint32_t getFallbacks() const { return _fallbacks; }
+
+    // Disable the copy constructor, we're pointer based
+    BufferPool(const BufferPool& that) = delete;
+
+  private:
+    friend class WiFiClientSecure;
+    // Borrow a buffer of at least len bytes, nullptr if none.  Returned on last reference drop
+    std::shared_ptr<unsigned char> _acquire(bool recv, int len);
+
+    // The memory and free masks, kept alive by borrowed buffers if the pool goes first
+    struct Storage {
+      ~Storage() { free(recv); free(xmit); }
+      unsigned char *recv;
+      unsigned char *xmit;
+      uint32_t recv_free; // Bitmasks of available buffers
+      uint32_t xmit_free;
+    };
+    std::shared_ptr<Storage> _storage;
+    int _count;
+    int _recv_size;
+    int _xmit_size;
+    uint32_t _fallbacks;
+};
+
 // Updater SHA256 hash and signature verification
 class HashSHA256 : public UpdaterHashClass {
   public:
@@ -41,6 +41,28 @@ extern "C" {
 CertStore::~CertStore() {
   free(_indexName);
   free(_dataName);
+  _clearCache();
+  delete[] _cache;
+}
+
+void CertStore::_clearCache() {
+  for (size_t i = 0; _cache && i < _cacheSize; i++) {
+    delete _cache[i].x509;
+    _cache[i].x509 = nullptr;
+    _cache[i].used = 0;
+    _cache[i].refs = 0;
+  }
+}
+
+void CertStore::setCacheSize(size_t size) {
+  _clearCache();
+  delete[] _cache;
+  _cache = nullptr;
+  _cacheSize = size;
+}
+
+static int _compareCertInfo(const void *a, const void *b) {
+  return memcmp(a, b, sizeof(CertStore::CertInfo::sha256));
 }
 
 CertStore::CertInfo CertStore::_preprocessCert(uint32_t length, uint32_t offset, const void *raw) {
@@ -78,6 +100,72 @@ CertStore::CertInfo CertStore::_preprocessCert(uint32_t length, uint32_t offset,
   return ci;
 }
 
+bool CertStore::_setNames(const char *indexFileName, const char *dataFileName) {
+  // In case initCertStore called multiple times, don't leak old filenames
+  free(_indexName);
+  free(_dataName);
+  _indexName = nullptr;
+  _dataName = nullptr;
+  // Anything cached came from the previous store
+  _clearCache();
+
+  // No strdup_P, so manually do it
+  if (indexFileName) {
+    _indexName = (char *)malloc(strlen_P(indexFileName) + 1);
+    if (!_indexName) {
+      return false;
+    }
+    memcpy_P(_indexName, indexFileName, strlen_P(indexFileName) + 1);
+  }
+  _dataName = (char *)malloc(strlen_P(dataFileName) + 1);
+  if (!_dataName) {
+    free(_indexName);
+    _indexName = nullptr;
+    return false;
+  }
+  memcpy_P(_dataName, dataFileName, strlen_P(dataFileName) + 1);
+  return true;
+}
+
+int CertStore::initCertStore(fs::FS &fs, const CertInfo *index, size_t count, const char *dataFileName) {
+  _fs = &fs;
+  _progmemIndex = nullptr;
+  _progmemCount = 0;
+  _sorted = false;
+  if (!_setNames(nullptr, dataFileName)) {
+    return 0;
+  }
+  _progmemIndex = index;
+  _progmemCount = count;
+  return count;
+}
+
+// Sort the index file written by initCertStore so lookups can binary search it.
+// Needs count*40 bytes of RAM for a moment, if that's not there stay with linear scans.
+bool CertStore::_sortIndex(int count) {
+  if (count <= 0) {
+    return true;
+  }
+  size_t len = count * sizeof(CertInfo);
+  std::unique_ptr<CertInfo[]> all(new (std::nothrow) CertInfo[count]);
+  if (!all) {
+    DEBUG_BSSL("CertStore::_sortIndex: OOM, index left unsorted\n");
+    return false;
+  }
+  fs::File index = _fs->open(_indexName, "r");
+  if (!index || index.read((uint8_t *)all.get(), len) != len) {
+    return false;
+  }
+  index.close();
+  qsort(all.get(), count, sizeof(CertInfo), _compareCertInfo);
+  index = _fs->open(_indexName, "w");
+  if (!index || index.write((uint8_t *)all.get(), len) != len) {
+    return false;
+  }
+  index.close();
+  return true;
+}
+
 // The certs.ar file is a UNIX ar format file, concatenating all the 
 // individual certificates into a single blob in a space-efficient way.
 int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *dataFileName) {
@@ -85,21 +173,13 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
   uint32_t offset = 0;
 
   _fs = &fs;
+  _progmemIndex = nullptr;
+  _progmemCount = 0;
+  _sorted = false;
 
-  // In case initCertStore called multiple times, don't leak old filenames
-  free(_indexName);
-  free(_dataName);
-
-  // No strdup_P, so manually do it
-  _indexName = (char *)malloc(strlen_P(indexFileName) + 1);
-  _dataName = (char *)malloc(strlen_P(dataFileName) + 1);
-  if (!_indexName || !_dataName) {
-    free(_indexName);
-    free(_dataName);
+  if (!_setNames(indexFileName, dataFileName)) {
     return 0;
   }
-  memcpy_P(_indexName, indexFileName, strlen_P(indexFileName) + 1);
-  memcpy_P(_dataName, dataFileName, strlen_P(dataFileName) + 1);
 
   fs::File index = _fs->open(_indexName, "w");
   if (!index) {
@@ -164,6 +244,7 @@ int CertStore::initCertStore(fs::FS &fs, const char *indexFileName, const char *
   }
   data.close();
   index.close();
+  _sorted = _sortIndex(count);
   return count;
 }
 
@@ -171,62 +252,162 @@ void CertStore::installCertStore(br_x509_minimal_context *ctx) {
   br_x509_minimal_set_dynamic(ctx, (void*)this, findHashedTA, freeHashedTA);
 }
 
+// Locate the index entry for a hashed DN, binary searching when the index is sorted
+bool CertStore::_findCertInfo(const void *hashed_dn, CertInfo *ci) {
+  if (_progmemIndex) {
+    size_t lo = 0, hi = _progmemCount;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      memcpy_P(ci, &_progmemIndex[mid], sizeof(*ci));
+      int cmp = memcmp(ci->sha256, hashed_dn, sizeof(ci->sha256));
+      if (!cmp) {
+        return true;
+      } else if (cmp < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return false;
+  }
+
+  if (!_indexName) {
+    return false;
+  }
+  fs::File index = _fs->open(_indexName, "r");
+  if (!index) {
+    return false;
+  }
+  bool found = false;
+  if (_sorted) {
+    size_t lo = 0, hi = index.size() / sizeof(*ci);
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (!index.seek(mid * sizeof(*ci), fs::SeekSet) ||
+          index.read((uint8_t *)ci, sizeof(*ci)) != sizeof(*ci)) {
+        break;
+      }
+      int cmp = memcmp(ci->sha256, hashed_dn, sizeof(ci->sha256));
+      if (!cmp) {
+        found = true;
+        break;
+      } else if (cmp < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  } else {
+    while (index.read((uint8_t *)ci, sizeof(*ci)) == sizeof(*ci)) {
+      if (!memcmp(ci->sha256, hashed_dn, sizeof(ci->sha256))) {
+        found = true;
+        break;
+      }
+    }
+  }
+  index.close();
+  return found;
+}
+
+// Read the DER cert for an index entry and decode it into a trust anchor
+X509List *CertStore::_loadCert(const CertInfo &ci) {
+  uint8_t *der = (uint8_t*)malloc(ci.length);
+  if (!der) {
+    return nullptr;
+  }
+  fs::File data = _fs->open(_dataName, "r");
+  if (!data) {
+    free(der);
+    return nullptr;
+  }
+  if (!data.seek(ci.offset, fs::SeekSet)) {
+    data.close();
+    free(der);
+    return nullptr;
+  }
+  if (data.read((uint8_t *)der, ci.length) != ci.length) {
+    free(der);
+    return nullptr;
+  }
+  data.close();
+  X509List *x509 = new (std::nothrow) X509List(der, ci.length);
+  free(der);
+  if (!x509) {
+    DEBUG_BSSL("CertStore::_loadCert: OOM\n");
+    return nullptr;
+  }
+  if (!x509->getCount()) {
+    delete x509;
+    return nullptr;
+  }
+
+  br_x509_trust_anchor *ta = (br_x509_trust_anchor*)x509->getTrustAnchors();
+  memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
+  ta->dn.len = sizeof(ci.sha256);
+  return x509;
+}
+
 const br_x509_trust_anchor *CertStore::findHashedTA(void *ctx, void *hashed_dn, size_t len) {
   CertStore *cs = static_cast<CertStore*>(ctx);
   CertStore::CertInfo ci;
 
-  if (!cs || len != sizeof(ci.sha256) || !cs->_indexName || !cs->_dataName || !cs->_fs) {
+  if (!cs || len != sizeof(ci.sha256) || !cs->_dataName || !cs->_fs) {
     return nullptr;
   }
 
-  fs::File index = cs->_fs->open(cs->_indexName, "r");
-  if (!index) {
-    return nullptr;
+  if (!cs->_cache && cs->_cacheSize) {
+    cs->_cache = new (std::nothrow) CachedTA[cs->_cacheSize];
+    if (cs->_cache) {
+      memset(cs->_cache, 0, cs->_cacheSize * sizeof(CachedTA));
+    }
   }
 
-  while (index.read((uint8_t *)&ci, sizeof(ci)) == sizeof(ci)) {
-    if (!memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256))) {
-      index.close();
-      uint8_t *der = (uint8_t*)malloc(ci.length);
-      if (!der) {
-        return nullptr;
-      }
-      fs::File data = cs->_fs->open(cs->_dataName, "r");
-      if (!data) {
-        free(der);
-        return nullptr;
-      }
-      if (!data.seek(ci.offset, fs::SeekSet)) {
-        data.close();
-        free(der);
-        return nullptr;
-      }
-      if (data.read((uint8_t *)der, ci.length) != ci.length) {
-        free(der);
-        return nullptr;
-      }
-      data.close();
-      cs->_x509 = new (std::nothrow) X509List(der, ci.length);
-      free(der);
-      if (!cs->_x509) {
-        DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
-        return nullptr;
-      }
+  // Recently used anchors are already decoded
+  CachedTA *slot = nullptr;
+  for (size_t i = 0; cs->_cache && i < cs->_cacheSize; i++) {
+    CachedTA *e = &cs->_cache[i];
+    if (e->used && !memcmp(e->sha256, hashed_dn, sizeof(e->sha256))) {
+      e->used = ++cs->_stamp;
+      e->refs++;
+      return e->x509->getTrustAnchors();
+    }
+    // Pick a free entry, else the least recently used one BearSSL isn't holding
+    if (!e->refs && (!slot || (slot->used && e->used < slot->used))) {
+      slot = e;
+    }
+  }
 
-      br_x509_trust_anchor *ta = (br_x509_trust_anchor*)cs->_x509->getTrustAnchors();
-      memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
-      ta->dn.len = sizeof(ci.sha256);
+  if (!cs->_findCertInfo(hashed_dn, &ci)) {
+    return nullptr;
+  }
+  X509List *x509 = cs->_loadCert(ci);
+  if (!x509) {
+    return nullptr;
+  }
 
-      return ta;
-    }
+  if (slot) {
+    delete slot->x509;
+    slot->x509 = x509;
+    memcpy(slot->sha256, ci.sha256, sizeof(slot->sha256));
+    slot->used = ++cs->_stamp;
+    slot->refs = 1;
+  } else {
+    delete cs->_x509;
+    cs->_x509 = x509;
   }
-  index.close();
-  return nullptr;
+  return x509->getTrustAnchors();
 }
 
 void CertStore::freeHashedTA(void *ctx, const br_x509_trust_anchor *ta) {
   CertStore *cs = static_cast<CertStore*>(ctx);
-  (void) ta; // Unused
+  for (size_t i = 0; cs->_cache && i < cs->_cacheSize; i++) {
+    if (cs->_cache[i].x509 && cs->_cache[i].x509->getTrustAnchors() == ta) {
+      if (cs->_cache[i].refs) {
+        cs->_cache[i].refs--; // Stays decoded for the next lookup
+      }
+      return;
+    }
+  }
   delete cs->_x509;
   cs->_x509 = nullptr;
 }
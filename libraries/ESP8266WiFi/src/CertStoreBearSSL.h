@@ -36,8 +36,22 @@ class CertStore {
     CertStore() { };
     ~CertStore();
 
+    // The binary format of the index file, sorted by sha256
+    class CertInfo {
+    public:
+      uint8_t sha256[32];
+      uint32_t offset;
+      uint32_t length;
+    };
+
     // Set the file interface instances, do preprocessing
     int initCertStore(fs::FS &fs, const char *indexFileName, const char *dataFileName);
+    // Use a prebuilt, sorted PROGMEM index (see certs-from-mozilla.py) matching the data file,
+    // no preprocessing or index file needed
+    int initCertStore(fs::FS &fs, const CertInfo *index, size_t count, const char *dataFileName);
+
+    // Number of decoded trust anchors kept in RAM between lookups (~1KB each), 0 to disable
+    void setCacheSize(size_t size);
 
     // Installs the cert store into the X509 decoder (normally via static function callbacks)
     void installCertStore(br_x509_minimal_context *ctx);
@@ -47,20 +61,31 @@ class CertStore {
     char *_indexName = nullptr;
     char *_dataName = nullptr;
     X509List *_x509 = nullptr;
+    bool _sorted = false;
+    const CertInfo *_progmemIndex = nullptr;
+    size_t _progmemCount = 0;
+
+    // Small LRU of decoded trust anchors, BearSSL only holds one at a time
+    struct CachedTA {
+      uint8_t sha256[32];
+      X509List *x509;
+      uint32_t used; // LRU stamp, 0 if free
+      uint16_t refs; // Handed to BearSSL and not yet freed, one per handshake
+    };
+    CachedTA *_cache = nullptr;
+    size_t _cacheSize = 4;
+    uint32_t _stamp = 0;
+    void _clearCache();
 
     // These need to be static as they are callbacks from BearSSL C code
     static const br_x509_trust_anchor *findHashedTA(void *ctx, void *hashed_dn, size_t len);
     static void freeHashedTA(void *ctx, const br_x509_trust_anchor *ta);
 
-    // The binary format of the index file
-    class CertInfo {
-    public:
-      uint8_t sha256[32];
-      uint32_t offset;
-      uint32_t length;
-    };
     static CertInfo _preprocessCert(uint32_t length, uint32_t offset, const void *raw);
-
+    bool _setNames(const char *indexFileName, const char *dataFileName);
+    bool _sortIndex(int count);
+    bool _findCertInfo(const void *hashed_dn, CertInfo *ci);
+    X509List *_loadCert(const CertInfo &ci);
 };
 
 };
@@ -26,6 +26,7 @@
 #include <string.h>
 #include <coredecls.h>
 #include <PolledTimeout.h>
+#include <Schedule.h>
 #include "ESP8266WiFi.h"
 #include "ESP8266WiFiGeneric.h"
 
@@ -596,74 +597,206 @@ bool ESP8266WiFiGenericClass::isSleepLevelMax () {
 
 void wifi_dns_found_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
 
-static bool _dns_lookup_pending = false;
+namespace {
 
-/**
- * Resolve the given hostname to an IP address.
- * @param aHostname     Name to be resolved
- * @param aResult       IPAddress structure to store the returned IP address
- * @return 1 if aIPAddrString was successfully converted to an IP address,
- *          else 0
- */
-int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResult)
+// One pending lookup, owned by lwIP until its callback fires
+struct DNSRequest
 {
-    return hostByName(aHostname, aResult, 10000);
-}
+    String name;
+    uint8_t addrtype;
+    bool done = false;
+    bool abandoned = false; // blocking caller is gone (timeout), callback will delete this request
+    IPAddress result;
+    ESP8266WiFiGenericClass::DNSResultCb cb; // set for asynchronous requests
+};
 
+struct DNSCacheEntry
+{
+    String name;        // empty: free slot
+    uint8_t addrtype;
+    IPAddress ip;       // unset: negative entry
+    uint32_t stampMs;
+    uint32_t lastUse;   // LRU tick
+};
 
-int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms)
+struct DNSCache
 {
-    ip_addr_t addr;
-    aResult = static_cast<uint32_t>(INADDR_NONE);
+    std::unique_ptr<DNSCacheEntry[]> entries;
+    size_t size = 0;
+    uint32_t ttlMs = 0;
+    uint32_t negativeTtlMs = 0;
+    uint32_t tick = 0;
+    DNSCacheStats stats = { 0, 0, 0, 0 };
+};
 
-    if(aResult.fromString(aHostname)) {
-        // Host name is a IP address use it!
-        DEBUG_WIFI_GENERIC("[hostByName] Host: %s is a IP!\n", aHostname);
-        return 1;
+DNSCache _dns_cache;
+
+DNSCacheEntry* _dns_cache_find(const char* name, uint8_t addrtype)
+{
+    for (size_t i = 0; i < _dns_cache.size; i++) {
+        DNSCacheEntry& e = _dns_cache.entries[i];
+        if (e.addrtype != addrtype || !e.name.length() || strcasecmp(e.name.c_str(), name) != 0) {
+            continue;
+        }
+        uint32_t ttl = e.ip.isSet()? _dns_cache.ttlMs: _dns_cache.negativeTtlMs;
+        if (millis() - e.stampMs >= ttl) {
+            // expired
+            e.name = String();
+            return nullptr;
+        }
+        e.lastUse = ++_dns_cache.tick;
+        return &e;
+    }
+    return nullptr;
+}
+
+void _dns_cache_store(const char* name, uint8_t addrtype, const IPAddress& ip)
+{
+    if (!_dns_cache.size || (!ip.isSet() && !_dns_cache.negativeTtlMs)) {
+        return;
     }
 
-    DEBUG_WIFI_GENERIC("[hostByName] request IP for: %s\n", aHostname);
+    // same key, or else free slot, or else least recently used
+    DNSCacheEntry* slot = nullptr;
+    for (size_t i = 0; i < _dns_cache.size; i++) {
+        DNSCacheEntry& e = _dns_cache.entries[i];
+        if (!e.name.length()) {
+            if (!slot || slot->name.length()) {
+                slot = &e;
+            }
+        } else if (e.addrtype == addrtype && strcasecmp(e.name.c_str(), name) == 0) {
+            slot = &e;
+            break;
+        } else if (!slot || (slot->name.length() && e.lastUse < slot->lastUse)) {
+            slot = &e;
+        }
+    }
+
+    if (slot->name.length() && strcasecmp(slot->name.c_str(), name) != 0) {
+        _dns_cache.stats.evictions++;
+    }
+    slot->name = name;
+    slot->addrtype = addrtype;
+    slot->ip = ip;
+    slot->stampMs = millis();
+    slot->lastUse = ++_dns_cache.tick;
+}
+
+err_t _dns_start(DNSRequest* req, ip_addr_t* addr)
+{
 #if LWIP_IPV4 && LWIP_IPV6
-    err_t err = dns_gethostbyname_addrtype(aHostname, &addr, &wifi_dns_found_callback, &aResult,LWIP_DNS_ADDRTYPE_DEFAULT);
+    return dns_gethostbyname_addrtype(req->name.c_str(), addr, &wifi_dns_found_callback, req, req->addrtype);
 #else
-    err_t err = dns_gethostbyname(aHostname, &addr, &wifi_dns_found_callback, &aResult);
+    return dns_gethostbyname(req->name.c_str(), addr, &wifi_dns_found_callback, req);
 #endif
-    if(err == ERR_OK) {
-        aResult = IPAddress(&addr);
-    } else if(err == ERR_INPROGRESS) {
-        _dns_lookup_pending = true;
-        delay(timeout_ms);
-        // will resume on timeout or when wifi_dns_found_callback fires
-        _dns_lookup_pending = false;
-        // will return here when dns_found_callback fires
-        if(aResult.isSet()) {
-            err = ERR_OK;
-        }
+}
+
+// try cache then lwIP, request is complete unless ERR_INPROGRESS is returned
+err_t _dns_lookup(DNSRequest* req)
+{
+    if (req->result.fromString(req->name)) {
+        // Host name is a IP address use it!
+        DEBUG_WIFI_GENERIC("[hostByName] Host: %s is a IP!\n", req->name.c_str());
+        req->done = true;
+        return ERR_OK;
     }
 
-    if(err != 0) {
-        DEBUG_WIFI_GENERIC("[hostByName] Host: %s lookup error: %d!\n", aHostname, (int)err);
-    } else {
-        DEBUG_WIFI_GENERIC("[hostByName] Host: %s IP: %s\n", aHostname, aResult.toString().c_str());
+    if (_dns_cache.size) {
+        DNSCacheEntry* e = _dns_cache_find(req->name.c_str(), req->addrtype);
+        if (e) {
+            if (e->ip.isSet()) {
+                _dns_cache.stats.hits++;
+            } else {
+                _dns_cache.stats.negativeHits++;
+            }
+            DEBUG_WIFI_GENERIC("[hostByName] Host: %s found in cache\n", req->name.c_str());
+            req->result = e->ip;
+            req->done = true;
+            return e->ip.isSet()? ERR_OK: ERR_ARG;
+        }
+        _dns_cache.stats.misses++;
     }
 
-    return (err == ERR_OK) ? 1 : 0;
+    DEBUG_WIFI_GENERIC("[hostByName] request IP for: %s\n", req->name.c_str());
+    ip_addr_t addr;
+    err_t err = _dns_start(req, &addr);
+    if (err == ERR_OK) {
+        req->result = IPAddress(&addr);
+        req->done = true;
+        _dns_cache_store(req->name.c_str(), req->addrtype, req->result);
+    } else if (err != ERR_INPROGRESS) {
+        req->done = true;
+    }
+    return err;
 }
 
-#if LWIP_IPV4 && LWIP_IPV6
-int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, DNSResolveType resolveType)
+// wait until all requests are done or timeout, starting those not started yet
+// (lwIP can only handle a few simultaneous lookups)
+void _dns_wait(DNSRequest** reqs, bool* started, size_t count, uint32_t timeout_ms)
 {
-    ip_addr_t addr;
-    err_t err;
-    aResult = static_cast<uint32_t>(INADDR_NONE);
+    uint32_t start = millis();
+    for (;;) {
+        size_t pending = 0;
+        bool waitingRoom = false;
+        for (size_t i = 0; i < count; i++) {
+            if (!started[i]) {
+                if (_dns_lookup(reqs[i]) == ERR_MEM) {
+                    // no room in lwIP table, will retry
+                    reqs[i]->done = false;
+                    waitingRoom = true;
+                } else {
+                    started[i] = true;
+                }
+            }
+            if (!reqs[i]->done) {
+                pending++;
+            }
+        }
+        uint32_t elapsed = millis() - start;
+        if (!pending || elapsed >= timeout_ms) {
+            return;
+        }
+        // will resume on timeout or when wifi_dns_found_callback fires
+        uint32_t remaining = timeout_ms - elapsed;
+        delay(waitingRoom && remaining > 10? 10: remaining);
+    }
+}
 
-    if(aResult.fromString(aHostname)) {
-        // Host name is a IP address use it!
-        DEBUG_WIFI_GENERIC("[hostByName] Host: %s is a IP!\n", aHostname);
-        return 1;
+// release requests, those still in progress are left to lwIP callback
+void _dns_release(DNSRequest** reqs, const bool* started, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (started[i] && !reqs[i]->done) {
+            reqs[i]->abandoned = true;
+        } else {
+            delete reqs[i];
+        }
     }
+}
+
+} // namespace
+
+/**
+ * Resolve the given hostname to an IP address.
+ * @param aHostname     Name to be resolved
+ * @param aResult       IPAddress structure to store the returned IP address
+ * @return 1 if aIPAddrString was successfully converted to an IP address,
+ *          else 0
+ */
+int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResult)
+{
+    return hostByName(aHostname, aResult, 10000);
+}
+
+
+int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms)
+{
+    return _hostByName(aHostname, aResult, timeout_ms, LWIP_DNS_ADDRTYPE_DEFAULT);
+}
 
-    DEBUG_WIFI_GENERIC("[hostByName] request IP for: %s\n", aHostname);
+#if LWIP_IPV4 && LWIP_IPV6
+int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, DNSResolveType resolveType)
+{
     switch(resolveType)
     {
       // Use selected addrtype
@@ -671,35 +804,142 @@ int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResul
       case DNSResolveType::DNS_AddrType_IPv6:
       case DNSResolveType::DNS_AddrType_IPv4_IPv6:
       case DNSResolveType::DNS_AddrType_IPv6_IPv4:
-         err = dns_gethostbyname_addrtype(aHostname, &addr, &wifi_dns_found_callback, &aResult, (uint8_t) resolveType);
-	 break;
+         return _hostByName(aHostname, aResult, timeout_ms, (uint8_t) resolveType);
       default:
-         err = dns_gethostbyname_addrtype(aHostname, &addr, &wifi_dns_found_callback, &aResult, LWIP_DNS_ADDRTYPE_DEFAULT); // If illegal type, use default.
-	 break;
+         return _hostByName(aHostname, aResult, timeout_ms, LWIP_DNS_ADDRTYPE_DEFAULT); // If illegal type, use default.
     }
+}
+#endif
 
-    if(err == ERR_OK) {
-        aResult = IPAddress(&addr);
-    } else if(err == ERR_INPROGRESS) {
-        _dns_lookup_pending = true;
-        delay(timeout_ms);
-        // will resume on timeout or when wifi_dns_found_callback fires
-        _dns_lookup_pending = false;
-        // will return here when dns_found_callback fires
-        if(aResult.isSet()) {
-            err = ERR_OK;
+int ESP8266WiFiGenericClass::_hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, uint8_t addrtype)
+{
+    aResult = static_cast<uint32_t>(INADDR_NONE);
+
+    // allocated: lwIP may call back after timeout
+    DNSRequest* req = new (std::nothrow) DNSRequest;
+    if (!req) {
+        return 0;
+    }
+    req->name = aHostname;
+    req->addrtype = addrtype;
+
+    bool started = false;
+    _dns_wait(&req, &started, 1, timeout_ms);
+    bool found = req->done && req->result.isSet();
+    if (found) {
+        aResult = req->result;
+        DEBUG_WIFI_GENERIC("[hostByName] Host: %s IP: %s\n", aHostname, aResult.toString().c_str());
+    } else {
+        DEBUG_WIFI_GENERIC("[hostByName] Host: %s lookup error!\n", aHostname);
+    }
+
+    _dns_release(&req, &started, 1);
+
+    return found ? 1 : 0;
+}
+
+/**
+ * Resolve several hostnames at once, lookups are run concurrently.
+ * @param aHostnames    Names to be resolved
+ * @param aResults      IPAddress array to store the returned IP addresses (unset when not found)
+ * @param count         Number of names
+ * @param timeout_ms    Overall timeout
+ * @return number of names successfully resolved
+ */
+int ESP8266WiFiGenericClass::hostsByName(const char* const aHostnames[], IPAddress aResults[], size_t count, uint32_t timeout_ms)
+{
+    std::unique_ptr<DNSRequest*[]> reqs(new (std::nothrow) DNSRequest*[count]);
+    std::unique_ptr<bool[]> started(new (std::nothrow) bool[count]);
+    if (!reqs || !started) {
+        return 0;
+    }
+
+    size_t allocated;
+    for (allocated = 0; allocated < count; allocated++) {
+        DNSRequest* req = new (std::nothrow) DNSRequest;
+        if (!req) {
+            break;
         }
+        req->name = aHostnames[allocated];
+        req->addrtype = LWIP_DNS_ADDRTYPE_DEFAULT;
+        reqs[allocated] = req;
+        started[allocated] = false;
     }
 
-    if(err != 0) {
-        DEBUG_WIFI_GENERIC("[hostByName] Host: %s lookup error: %d!\n", aHostname, (int)err);
-    } else {
-        DEBUG_WIFI_GENERIC("[hostByName] Host: %s IP: %s\n", aHostname, aResult.toString().c_str());
+    if (allocated == count) {
+        _dns_wait(reqs.get(), started.get(), count, timeout_ms);
     }
 
-    return (err == ERR_OK) ? 1 : 0;
+    int found = 0;
+    for (size_t i = 0; i < count; i++) {
+        aResults[i] = (allocated == count && reqs[i]->done)? reqs[i]->result: IPAddress();
+        if (aResults[i].isSet()) {
+            found++;
+        }
+    }
+
+    _dns_release(reqs.get(), started.get(), allocated);
+
+    return found;
+}
+
+/**
+ * Resolve the given hostname without blocking.
+ * @param aHostname     Name to be resolved
+ * @param cb            Called from loop context with the result (unset IPAddress when not found)
+ * @return false if the lookup could not be started
+ */
+bool ESP8266WiFiGenericClass::hostByNameAsync(const char* aHostname, DNSResultCb cb)
+{
+    DNSRequest* req = new (std::nothrow) DNSRequest;
+    if (!req) {
+        return false;
+    }
+    req->name = aHostname;
+    req->addrtype = LWIP_DNS_ADDRTYPE_DEFAULT;
+    req->cb = std::move(cb);
+
+    err_t err = _dns_lookup(req);
+    if (err == ERR_INPROGRESS) {
+        // callback will report and delete
+        return true;
+    }
+    if (err == ERR_MEM) {
+        delete req;
+        return false;
+    }
+    schedule_function([req]() {
+        req->cb(req->name.c_str(), req->result);
+        delete req;
+    });
+    return true;
+}
+
+/**
+ * Enable the DNS result cache
+ * @param entries       Number of hostnames to keep (0 disables and clears the cache)
+ * @param ttl_ms        Lifetime of resolved entries
+ * @param negativeTtl_ms    Lifetime of unresolved entries (0: not cached)
+ */
+void ESP8266WiFiGenericClass::setDNSCache(size_t entries, uint32_t ttl_ms, uint32_t negativeTtl_ms)
+{
+    _dns_cache.entries.reset(entries? new (std::nothrow) DNSCacheEntry[entries]: nullptr);
+    _dns_cache.size = _dns_cache.entries? entries: 0;
+    _dns_cache.ttlMs = ttl_ms;
+    _dns_cache.negativeTtlMs = negativeTtl_ms;
+}
+
+void ESP8266WiFiGenericClass::clearDNSCache()
+{
+    for (size_t i = 0; i < _dns_cache.size; i++) {
+        _dns_cache.entries[i].name = String();
+    }
+}
+
+DNSCacheStats ESP8266WiFiGenericClass::getDNSCacheStats()
+{
+    return _dns_cache.stats;
 }
-#endif
 
 /**
  * DNS callback
@@ -710,13 +950,23 @@ int ESP8266WiFiGenericClass::hostByName(const char* aHostname, IPAddress& aResul
 void wifi_dns_found_callback(const char *name, const ip_addr_t *ipaddr, void *callback_arg)
 {
     (void) name;
-    if (!_dns_lookup_pending) {
-        return;
+    DNSRequest* req = reinterpret_cast<DNSRequest*>(callback_arg);
+    if (ipaddr) {
+        req->result = IPAddress(ipaddr);
     }
-    if(ipaddr) {
-        (*reinterpret_cast<IPAddress*>(callback_arg)) = IPAddress(ipaddr);
+    req->done = true;
+    _dns_cache_store(req->name.c_str(), req->addrtype, req->result);
+
+    if (req->abandoned) {
+        delete req;
+    } else if (req->cb) {
+        schedule_function([req]() {
+            req->cb(req->name.c_str(), req->result);
+            delete req;
+        });
+    } else {
+        esp_schedule(); // break delay in hostByName
     }
-    esp_schedule(); // break delay in hostByName
 }
 
 uint32_t ESP8266WiFiGenericClass::shutdownCRC (const WiFiState* state)
@@ -50,6 +50,14 @@ enum class DNSResolveType: uint8_t
     DNS_AddrType_IPv6_IPv4	// LWIP_DNS_ADDRTYPE_IPV6_IPV4 = 3
 };
 
+struct DNSCacheStats
+{
+    uint32_t hits;          // resolved from cache
+    uint32_t misses;        // not in cache, lwIP was queried
+    uint32_t negativeHits;  // known as unresolvable from cache
+    uint32_t evictions;     // entries dropped to make room
+};
+
 struct WiFiState;
 
 class ESP8266WiFiGenericClass {
@@ -124,9 +132,20 @@ class ESP8266WiFiGenericClass {
 #if LWIP_IPV4 && LWIP_IPV6
         int hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, DNSResolveType resolveType);
 #endif
+        int hostsByName(const char* const aHostnames[], IPAddress aResults[], size_t count, uint32_t timeout_ms = 10000);
+
+        typedef std::function<void(const char* aHostname, const IPAddress& aResult)> DNSResultCb;
+        bool hostByNameAsync(const char* aHostname, DNSResultCb cb);
+
+        static void setDNSCache(size_t entries, uint32_t ttl_ms = 300000, uint32_t negativeTtl_ms = 10000);
+        static void clearDNSCache();
+        static DNSCacheStats getDNSCacheStats();
+
         bool getPersistent();
 
     protected:
+        int _hostByName(const char* aHostname, IPAddress& aResult, uint32_t timeout_ms, uint8_t addrtype);
+
         friend class ESP8266WiFiSTAClass;
         friend class ESP8266WiFiScanClass;
         friend class ESP8266WiFiAPClass;
@@ -25,6 +25,7 @@
 
 #include "PolledTimeout.h"
 #include "ESP8266WiFiMulti.h"
+#include <coredecls.h>
 #include <limits.h>
 #include <string.h>
 
@@ -116,10 +117,41 @@ static wl_status_t waitWiFiConnect(uint32_t connectTimeoutMs)
     return WL_CONNECT_FAILED;
 }
 
+/**
+ * @brief Fast reconnect state stored in RTC user memory
+ */
+struct WifiMultiRTCState {
+    uint32_t crc;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t netmask;
+    uint32_t dns;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t flags;
+    char ssid[33];
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(WifiMultiRTCState) == 64, "RTC state must stay 16 blocks");
+
+//! State layout version, changing it invalidates states saved by older code
+static constexpr uint8_t RTC_STATE_VERSION = 1;
+//! IP configuration is valid
+static constexpr uint8_t RTC_STATE_IP = 0x80;
+
+static uint32_t rtcStateCrc(const WifiMultiRTCState &state)
+{
+    return crc32((const uint8_t *)&state + sizeof(state.crc), sizeof(state) - sizeof(state.crc));
+}
+
 /**
  * @brief Constructor
  */
-ESP8266WiFiMulti::ESP8266WiFiMulti() : _firstRun(true)
+ESP8266WiFiMulti::ESP8266WiFiMulti() : _firstRun(true),
+    _fastReconnect(false), _fastKeepIP(false), _rtcOffset(WIFI_MULTI_RTC_OFFSET),
+    _lastConnectMs(0), _lastConnectFast(false),
+    _fastConnects(0), _fastFailures(0), _scanConnects(0)
 {
 }
 
@@ -172,6 +204,144 @@ bool ESP8266WiFiMulti::existsAP(const char *ssid, const char *passphrase)
     return APlistExists(ssid, passphrase);
 }
 
+/**
+ * @brief Enable connecting to the last used Access Point without scanning
+ * @details
+ *      After each connection made by run(), the SSID, BSSID and channel are
+ *      saved in RTC user memory, which survives reset and deep sleep. The
+ *      first run() after boot connects to that AP directly and only scans if
+ *      it fails. Passphrases are never stored, the SSID must still be in the
+ *      AP list.
+ * @param enable
+ *      Enable or disable fast reconnect
+ * @param keepIP
+ *      Also save the DHCP assigned IP, gateway, netmask and DNS and reuse
+ *      them as static configuration, skipping DHCP. Only use this when the
+ *      DHCP server gives long leases.
+ * @param rtcOffset
+ *      RTC user memory offset in 4-byte blocks, 16 blocks are used
+ */
+void ESP8266WiFiMulti::enableFastReconnect(bool enable, bool keepIP, uint32_t rtcOffset)
+{
+    _fastReconnect = enable;
+    _fastKeepIP = keepIP;
+    _rtcOffset = rtcOffset;
+}
+
+/**
+ * @brief Invalidate the fast reconnect state in RTC user memory
+ */
+void ESP8266WiFiMulti::clearFastReconnect()
+{
+    uint32_t zero[sizeof(WifiMultiRTCState) / 4] = { 0 };
+    ESP.rtcUserMemoryWrite(_rtcOffset, zero, sizeof(zero));
+}
+
+/**
+ * @brief Connect to the Access Point saved in RTC user memory
+ * @param connectTimeoutMs
+ *      WiFi connection timeout in ms
+ * @return
+ *      WiFi status, WL_NO_SSID_AVAIL if there is no usable saved state
+ */
+wl_status_t ESP8266WiFiMulti::fastReconnect(uint32_t connectTimeoutMs)
+{
+    WifiMultiRTCState state;
+
+    if (!ESP.rtcUserMemoryRead(_rtcOffset, (uint32_t *)&state, sizeof(state)) ||
+        (state.crc != rtcStateCrc(state)) || ((state.flags & ~RTC_STATE_IP) != RTC_STATE_VERSION)) {
+        DEBUG_WIFI_MULTI("[WIFIM] No fast reconnect state\n");
+        return WL_NO_SSID_AVAIL;
+    }
+
+    state.ssid[sizeof(state.ssid) - 1] = 0;
+
+    const char *passphrase = NULL;
+    for (auto entry : _APlist) {
+        if (!strcmp(entry.ssid, state.ssid)) {
+            passphrase = entry.passphrase;
+            break;
+        }
+    }
+    if (!passphrase) {
+        DEBUG_WIFI_MULTI("[WIFIM] Fast reconnect SSID %s not in AP list\n", state.ssid);
+        clearFastReconnect();
+        return WL_NO_SSID_AVAIL;
+    }
+
+    bool staticIP = _fastKeepIP && (state.flags & RTC_STATE_IP);
+    if (staticIP) {
+        WiFi.config(IPAddress(state.ip), IPAddress(state.gateway), IPAddress(state.netmask), IPAddress(state.dns));
+    }
+
+    DEBUG_WIFI_MULTI("[WIFIM] Fast reconnect %s CH %d%s\n", state.ssid, state.channel, staticIP ? " static IP" : "");
+
+    // Connect to WiFi, no scan needed with channel and BSSID
+    WiFi.begin(state.ssid, passphrase, state.channel, state.bssid);
+
+    if (waitWiFiConnect(connectTimeoutMs) == WL_CONNECTED) {
+        return WL_CONNECTED;
+    }
+
+    // The AP moved, went away or the lease is gone: forget it and scan
+    _fastFailures++;
+    clearFastReconnect();
+    if (staticIP) {
+        // Back to DHCP
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    }
+
+    return WL_CONNECT_FAILED;
+}
+
+/**
+ * @brief Save the current connection to RTC user memory
+ */
+void ESP8266WiFiMulti::saveFastReconnect()
+{
+    WifiMultiRTCState state;
+
+    memset(&state, 0, sizeof(state));
+    strncpy(state.ssid, WiFi.SSID().c_str(), sizeof(state.ssid) - 1);
+    memcpy(state.bssid, WiFi.BSSID(), sizeof(state.bssid));
+    state.channel = WiFi.channel();
+    state.flags = RTC_STATE_VERSION;
+    if (_fastKeepIP) {
+        state.ip = WiFi.localIP().v4();
+        state.gateway = WiFi.gatewayIP().v4();
+        state.netmask = WiFi.subnetMask().v4();
+        state.dns = WiFi.dnsIP().v4();
+        state.flags |= RTC_STATE_IP;
+    }
+    state.crc = rtcStateCrc(state);
+
+    ESP.rtcUserMemoryWrite(_rtcOffset, (uint32_t *)&state, sizeof(state));
+}
+
+/**
+ * @brief Record connection metrics and remember the AP for fast reconnect
+ * @param startMs
+ *      millis() when run() started connecting
+ * @param fast
+ *      Connected through the fast reconnect path
+ */
+void ESP8266WiFiMulti::connected(uint32_t startMs, bool fast)
+{
+    _lastConnectMs = millis() - startMs;
+    _lastConnectFast = fast;
+    if (fast) {
+        _fastConnects++;
+    } else {
+        _scanConnects++;
+    }
+
+    DEBUG_WIFI_MULTI("[WIFIM] Connected in %u ms (%s)\n", _lastConnectMs, fast ? "fast" : "scan");
+
+    if (_fastReconnect) {
+        saveFastReconnect();
+    }
+}
+
 /**
  * @brief Keep WiFi connected to Access Point with strongest WiFi signal (RSSI)
  * @param connectTimeoutMs
@@ -183,11 +353,19 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
 {
     int8_t scanResult;
     wl_status_t status;
+    uint32_t startMs = millis();
 
     // Fast connect to previous WiFi on startup
     if (_firstRun) {
         _firstRun = false;
 
+        // Connect to the AP remembered in RTC memory
+        if (_fastReconnect && (WiFi.status() != WL_CONNECTED) &&
+            (fastReconnect(connectTimeoutMs) == WL_CONNECTED)) {
+            connected(startMs, true);
+            return WL_CONNECTED;
+        }
+
         // Check if previous WiFi connection saved
         if (strlen(WiFi.SSID().c_str())) {
             DEBUG_WIFI_MULTI("[WIFIM] Connecting saved WiFi\n");
@@ -197,6 +375,9 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
 
             // Wait for status change
             status = waitWiFiConnect(connectTimeoutMs);
+            if (status == WL_CONNECTED) {
+                connected(startMs, false);
+            }
         }
     }
 
@@ -215,7 +396,12 @@ wl_status_t ESP8266WiFiMulti::run(uint32_t connectTimeoutMs)
     }
 
     // Try to connect to multiple WiFi's with strongest signal (RSSI)
-    return connectWiFiMulti(connectTimeoutMs);
+    status = connectWiFiMulti(connectTimeoutMs);
+    if (status == WL_CONNECTED) {
+        connected(startMs, false);
+    }
+
+    return status;
 }
 
 /**
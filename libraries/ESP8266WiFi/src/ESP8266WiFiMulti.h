@@ -50,6 +50,11 @@
 #define WIFI_SCAN_TIMEOUT_MS        5000
 #endif
 
+//! Default RTC user memory offset of the fast reconnect state, in 4-byte blocks (last 64 bytes)
+#ifndef WIFI_MULTI_RTC_OFFSET
+#define WIFI_MULTI_RTC_OFFSET       112
+#endif
+
 struct WifiAPEntry {
     char *ssid;
     char *passphrase;
@@ -70,10 +75,36 @@ public:
 
     void cleanAPlist();
 
+    // Remember the last AP (and optionally the DHCP lease) in RTC user memory
+    // to connect without scanning after reset or deep sleep
+    void enableFastReconnect(bool enable = true, bool keepIP = false, uint32_t rtcOffset = WIFI_MULTI_RTC_OFFSET);
+    void clearFastReconnect();
+
+    // Time taken by the last connection made by run(), and whether it used the fast path.
+    // Other connections (scan or SDK saved configuration) count as scan connects.
+    uint32_t getLastConnectMs() const { return _lastConnectMs; }
+    bool isLastConnectFast() const { return _lastConnectFast; }
+    uint32_t getFastConnects() const { return _fastConnects; }
+    uint32_t getFastConnectFailures() const { return _fastFailures; }
+    uint32_t getScanConnects() const { return _scanConnects; }
+
 private:
     WifiAPlist _APlist;
     bool _firstRun;
 
+    bool _fastReconnect;
+    bool _fastKeepIP;
+    uint32_t _rtcOffset;
+    uint32_t _lastConnectMs;
+    bool _lastConnectFast;
+    uint32_t _fastConnects;
+    uint32_t _fastFailures;
+    uint32_t _scanConnects;
+
+    wl_status_t fastReconnect(uint32_t connectTimeoutMs);
+    void saveFastReconnect();
+    void connected(uint32_t startMs, bool fast);
+
     bool APlistAdd(const char *ssid, const char *passphrase = NULL);
     bool APlistExists(const char *ssid, const char *passphrase = NULL);
     void APlistClean();
@@ -44,7 +44,22 @@ extern "C" void esp_yield();
 // ---------------------------------------------------- Private functions ------------------------------------------------
 // -----------------------------------------------------------------------------------------------------------------------
 
-
+static uint8_t encryptionTypeFromAuthMode(AUTH_MODE authmode) {
+    switch(authmode) {
+        case AUTH_OPEN:
+            return ENC_TYPE_NONE;
+        case AUTH_WEP:
+            return ENC_TYPE_WEP;
+        case AUTH_WPA_PSK:
+            return ENC_TYPE_TKIP;
+        case AUTH_WPA2_PSK:
+            return ENC_TYPE_CCMP;
+        case AUTH_WPA_WPA2_PSK:
+            return ENC_TYPE_AUTO;
+        default:
+            return -1;
+    }
+}
 
 
 // -----------------------------------------------------------------------------------------------------------------------
@@ -60,6 +75,13 @@ void* ESP8266WiFiScanClass::_scanResult = 0;
 
 std::function<void(int)> ESP8266WiFiScanClass::_onComplete;
 
+WiFiScanEntry* ESP8266WiFiScanClass::_scanInto = nullptr;
+size_t ESP8266WiFiScanClass::_scanIntoSize = 0;
+ESP8266WiFiScanClass::ScanFilter ESP8266WiFiScanClass::_scanFilter;
+WiFiScanConfig ESP8266WiFiScanClass::_scanConfig;
+char ESP8266WiFiScanClass::_scanSsid[33];
+uint16_t ESP8266WiFiScanClass::_scanChannels = 0;
+
 /**
  * Start scan WiFi networks available
  * @param async         run in async mode
@@ -83,6 +105,7 @@ int8_t ESP8266WiFiScanClass::scanNetworks(bool async, bool show_hidden, uint8 ch
     }
 
     scanDelete();
+    _scanInto = nullptr;
 
     struct scan_config config;
     memset(&config, 0, sizeof(config));
@@ -116,6 +139,67 @@ void ESP8266WiFiScanClass::scanNetworksAsync(std::function<void(int)> onComplete
     scanNetworks(true, show_hidden);
 }
 
+/**
+ * Scan WiFi networks without allocating: each network reported by the SDK is
+ * passed to filter, and the maxResults strongest accepted ones are kept in
+ * results, sorted by decreasing RSSI. SSID(i), RSSI(i)... do not apply to
+ * these results, scanComplete() returns their count.
+ * @param results       caller owned storage, must stay valid until the scan completes
+ * @param maxResults    size of results
+ * @param config        channels, SSID and dwell times to scan with
+ * @param filter        called for each network found, return false to drop it (nullptr keeps all)
+ * @param onComplete    called with the number of results when the scan is done (async mode)
+ * @param async         return immediately instead of waiting for the scan to complete
+ * @return Number of results kept, WIFI_SCAN_RUNNING in async mode or WIFI_SCAN_FAILED
+ */
+int8_t ESP8266WiFiScanClass::scanNetworksInto(WiFiScanEntry* results, size_t maxResults, const WiFiScanConfig& config,
+                                              ScanFilter filter, std::function<void(int)> onComplete, bool async) {
+    if(ESP8266WiFiScanClass::_scanStarted) {
+        return WIFI_SCAN_RUNNING;
+    }
+
+    ESP8266WiFiScanClass::_scanAsync = async;
+
+    WiFi.enableSTA(true);
+
+    int status = wifi_station_get_connect_status();
+    if(status != STATION_GOT_IP && status != STATION_IDLE) {
+        wifi_station_disconnect();
+    }
+
+    scanDelete();
+
+    _scanInto = results;
+    _scanIntoSize = maxResults;
+    _scanFilter = filter;
+    _onComplete = onComplete;
+    _scanConfig = config;
+    _scanSsid[0] = 0;
+    if(config.ssid) {
+        strncpy(_scanSsid, config.ssid, sizeof(_scanSsid) - 1);
+        _scanSsid[sizeof(_scanSsid) - 1] = 0;
+    }
+    // Channels 1..14, 0 is a single pass over all channels
+    _scanChannels = config.channelMask & 0x7ffe;
+
+    ESP8266WiFiScanClass::_scanComplete = false;
+    ESP8266WiFiScanClass::_scanStarted = true;
+    if(!_scanNextPass()) {
+        ESP8266WiFiScanClass::_scanStarted = false;
+        _scanInto = nullptr;
+        _onComplete = nullptr;
+        return WIFI_SCAN_FAILED;
+    }
+
+    if(ESP8266WiFiScanClass::_scanAsync) {
+        delay(0); // time for the OS to trigger the scan
+        return WIFI_SCAN_RUNNING;
+    }
+
+    esp_yield(); // will resume when the last pass completes
+    return ESP8266WiFiScanClass::_scanCount;
+}
+
 /**
  * called to get the scan state in Async mode
  * @return scan result or status
@@ -142,8 +226,8 @@ void ESP8266WiFiScanClass::scanDelete() {
     if(ESP8266WiFiScanClass::_scanResult) {
         delete[] reinterpret_cast<bss_info*>(ESP8266WiFiScanClass::_scanResult);
         ESP8266WiFiScanClass::_scanResult = 0;
-        ESP8266WiFiScanClass::_scanCount = 0;
     }
+    ESP8266WiFiScanClass::_scanCount = 0;
     _scanComplete = false;
 }
 
@@ -208,20 +292,7 @@ uint8_t ESP8266WiFiScanClass::encryptionType(uint8_t i) {
         return -1;
     }
 
-    switch(it->authmode) {
-        case AUTH_OPEN:
-            return ENC_TYPE_NONE;
-        case AUTH_WEP:
-            return ENC_TYPE_WEP;
-        case AUTH_WPA_PSK:
-            return ENC_TYPE_TKIP;
-        case AUTH_WPA2_PSK:
-            return ENC_TYPE_CCMP;
-        case AUTH_WPA_WPA2_PSK:
-            return ENC_TYPE_AUTO;
-        default:
-            return -1;
-    }
+    return encryptionTypeFromAuthMode(it->authmode);
 }
 
 /**
@@ -294,6 +365,11 @@ bool ESP8266WiFiScanClass::isHidden(uint8_t i) {
  * @param status STATUS
  */
 void ESP8266WiFiScanClass::_scanDone(void* result, int status) {
+    if(ESP8266WiFiScanClass::_scanInto) {
+        _scanDoneInto(result, status);
+        return;
+    }
+
     if(status != OK) {
         ESP8266WiFiScanClass::_scanCount = 0;
         ESP8266WiFiScanClass::_scanResult = 0;
@@ -330,6 +406,86 @@ void ESP8266WiFiScanClass::_scanDone(void* result, int status) {
     }
 }
 
+/**
+ * private
+ * start the scan of the next channel of _scanChannels, or of all channels
+ * @return true if a scan was started
+ */
+bool ESP8266WiFiScanClass::_scanNextPass() {
+    struct scan_config config;
+    memset(&config, 0, sizeof(config));
+    config.ssid = _scanSsid[0] ? reinterpret_cast<uint8*>(_scanSsid) : NULL;
+    config.show_hidden = _scanConfig.showHidden;
+    if(_scanChannels) {
+        config.channel = __builtin_ctz(_scanChannels);
+        _scanChannels &= ~(1 << config.channel);
+    }
+    if(_scanConfig.passive) {
+        config.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+        config.scan_time.passive = _scanConfig.maxDwellMs;
+    } else {
+        config.scan_type = WIFI_SCAN_TYPE_ACTIVE;
+        config.scan_time.active.min = _scanConfig.minDwellMs;
+        config.scan_time.active.max = _scanConfig.maxDwellMs;
+    }
+    return wifi_station_scan(&config, reinterpret_cast<scan_done_cb_t>(&ESP8266WiFiScanClass::_scanDone));
+}
+
+/**
+ * private
+ * scan callback of scanNetworksInto(), keeps the strongest accepted networks
+ * @param result  void *arg
+ * @param status STATUS
+ */
+void ESP8266WiFiScanClass::_scanDoneInto(void* result, int status) {
+    if(status == OK) {
+        for(bss_info* it = reinterpret_cast<bss_info*>(result); it; it = STAILQ_NEXT(it, next)) {
+            WiFiScanEntry entry;
+            memcpy(entry.bssid, it->bssid, sizeof(entry.bssid));
+            memcpy(entry.ssid, it->ssid, sizeof(it->ssid));
+            entry.ssid[32] = 0;
+            entry.channel = it->channel;
+            entry.rssi = it->rssi;
+            entry.encryptionType = encryptionTypeFromAuthMode(it->authmode);
+            entry.isHidden = (it->is_hidden != 0);
+
+            if(_scanFilter && !_scanFilter(entry)) {
+                continue;
+            }
+
+            // Insert sorted by RSSI, dropping the weakest when full
+            size_t i = _scanCount;
+            if(i == _scanIntoSize) {
+                if(!i || _scanInto[i - 1].rssi >= entry.rssi) {
+                    continue;
+                }
+                --i;
+            } else {
+                ++_scanCount;
+            }
+            for(; i > 0 && _scanInto[i - 1].rssi < entry.rssi; --i) {
+                _scanInto[i] = _scanInto[i - 1];
+            }
+            _scanInto[i] = entry;
+        }
+    }
+
+    // Next channel, if any
+    if(_scanChannels && _scanNextPass()) {
+        return;
+    }
+
+    ESP8266WiFiScanClass::_scanStarted = false;
+    ESP8266WiFiScanClass::_scanComplete = true;
+
+    if(!ESP8266WiFiScanClass::_scanAsync) {
+        esp_schedule(); // resume scanNetworksInto
+    } else if (ESP8266WiFiScanClass::_onComplete) {
+        ESP8266WiFiScanClass::_onComplete(ESP8266WiFiScanClass::_scanCount);
+        ESP8266WiFiScanClass::_onComplete = nullptr;
+    }
+}
+
 /**
  *
  * @param i specify from which network item want to get the information
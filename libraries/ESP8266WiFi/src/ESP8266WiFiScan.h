@@ -26,6 +26,25 @@
 #include "ESP8266WiFiType.h"
 #include "ESP8266WiFiGeneric.h"
 
+// One network found by scanNetworksInto(), kept in caller provided storage
+struct WiFiScanEntry {
+    uint8_t bssid[6];
+    char ssid[33];
+    uint8_t channel;
+    int8_t rssi;
+    uint8_t encryptionType;
+    bool isHidden;
+};
+
+struct WiFiScanConfig {
+    uint16_t channelMask = 0;   // bit n scans channel n (1..14), one pass per channel; 0 scans all channels in one pass
+    const char* ssid = nullptr; // only report this SSID
+    bool showHidden = false;
+    bool passive = false;       // listen for beacons instead of sending probe requests
+    uint16_t minDwellMs = 0;    // active scan time per channel, 0 for SDK defaults
+    uint16_t maxDwellMs = 0;    // (also passive scan time per channel)
+};
+
 class ESP8266WiFiScanClass {
 
         // ----------------------------------------------------------------------------------------------
@@ -37,6 +56,11 @@ class ESP8266WiFiScanClass {
         int8_t scanNetworks(bool async = false, bool show_hidden = false, uint8 channel = 0, uint8* ssid = NULL);
         void scanNetworksAsync(std::function<void(int)> onComplete, bool show_hidden = false);
 
+        // Return false to drop a network. Called from the SDK scan callback: keep it short, no delay()/yield()
+        typedef std::function<bool(const WiFiScanEntry&)> ScanFilter;
+        int8_t scanNetworksInto(WiFiScanEntry* results, size_t maxResults, const WiFiScanConfig& config = WiFiScanConfig(),
+                                ScanFilter filter = nullptr, std::function<void(int)> onComplete = nullptr, bool async = false);
+
         int8_t scanComplete();
         void scanDelete();
 
@@ -62,7 +86,16 @@ class ESP8266WiFiScanClass {
 
         static std::function<void(int)> _onComplete;
 
+        static WiFiScanEntry* _scanInto;
+        static size_t _scanIntoSize;
+        static ScanFilter _scanFilter;
+        static WiFiScanConfig _scanConfig;
+        static char _scanSsid[33];
+        static uint16_t _scanChannels;
+
         static void _scanDone(void* result, int status);
+        static void _scanDoneInto(void* result, int status);
+        static bool _scanNextPass();
         static void * _getScanInfoByIndex(int i);
 
 };
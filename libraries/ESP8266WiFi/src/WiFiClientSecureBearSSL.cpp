@@ -82,11 +82,13 @@ void WiFiClientSecure::_clear() {
   _now = 0; // You can override or ensure time() is correct w/configTime
   _ta = nullptr;
   setBufferSizes(16384, 512); // Minimum safe
+  _mfln_auto = -1;
   _handshake_done = false;
   _recvapp_buf = nullptr;
   _recvapp_len = 0;
   _oom_err = false;
   _session = nullptr;
+  _cachedSession = nullptr;
   _cipher_list = nullptr;
   _cipher_cnt = 0;
 }
@@ -104,6 +106,8 @@ WiFiClientSecure::WiFiClientSecure() : WiFiClient() {
   _clear();
   _clearAuthenticationSettings();
   _certStore = nullptr; // Don't want to remove cert store on a clear, should be long lived
+  _sessionCache = nullptr; // Same for the session cache
+  _bufferPool = nullptr; // And the buffer pool
   _sk = nullptr;
   stack_thunk_add_ref();
 }
@@ -125,15 +129,18 @@ WiFiClientSecure::~WiFiClientSecure() {
 
 WiFiClientSecure::WiFiClientSecure(ClientContext* client,
                                      const X509List *chain, const PrivateKey *sk,
-                                     int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta) {
+                                     int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta,
+                                     ServerSessions *cache) {
   _clear();
   _clearAuthenticationSettings();
+  _sessionCache = nullptr;
+  _bufferPool = nullptr;
   stack_thunk_add_ref();
   _iobuf_in_size = iobuf_in_size;
   _iobuf_out_size = iobuf_out_size;
   _client = client;
   _client->ref();
-  if (!_connectSSLServerRSA(chain, sk, client_CA_ta)) {
+  if (!_connectSSLServerRSA(chain, sk, client_CA_ta, cache)) {
     _client->unref();
     _client = nullptr;
     _clear();
@@ -143,15 +150,18 @@ WiFiClientSecure::WiFiClientSecure(ClientContext* client,
 WiFiClientSecure::WiFiClientSecure(ClientContext *client,
                                      const X509List *chain,
                                      unsigned cert_issuer_key_type, const PrivateKey *sk,
-                                     int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta) {
+                                     int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta,
+                                     ServerSessions *cache) {
   _clear();
   _clearAuthenticationSettings();
+  _sessionCache = nullptr;
+  _bufferPool = nullptr;
   stack_thunk_add_ref();
   _iobuf_in_size = iobuf_in_size;
   _iobuf_out_size = iobuf_out_size;
   _client = client;
   _client->ref();
-  if (!_connectSSLServerEC(chain, cert_issuer_key_type, sk, client_CA_ta)) {
+  if (!_connectSSLServerEC(chain, cert_issuer_key_type, sk, client_CA_ta, cache)) {
     _client->unref();
     _client = nullptr;
     _clear();
@@ -185,6 +195,19 @@ void WiFiClientSecure::setBufferSizes(int recv, int xmit) {
   xmit += MAX_OUT_OVERHEAD;
   _iobuf_in_size = recv;
   _iobuf_out_size = xmit;
+  // Explicit sizes win over automatic MFLN
+  _mfln_auto = 0;
+}
+
+void WiFiClientSecure::setAutoMFLN(uint16_t len) {
+  // Only powers of two from 512 to 4096 can be negotiated
+  _mfln_auto = 0;
+  for (int l = 4096; l >= 512; l >>= 1) {
+    if (len >= l) {
+      _mfln_auto = l;
+      break;
+    }
+  }
 }
 
 bool WiFiClientSecure::stop(unsigned int maxWaitMs) {
@@ -204,11 +227,18 @@ bool WiFiClientSecure::flush(unsigned int maxWaitMs) {
   return WiFiClient::flush(maxWaitMs);
 }
 
-int WiFiClientSecure::connect(IPAddress ip, uint16_t port) {
-  if (!WiFiClient::connect(ip, port)) {
-    return 0;
+SessionCache *WiFiClientSecure::_defaultSessionCache = nullptr;
+
+Session *WiFiClientSecure::_sessionFromCache(const char *host, uint16_t port) {
+  SessionCache *cache = _sessionCache ? _sessionCache : _defaultSessionCache;
+  if (_session || !cache) {
+    return nullptr;
   }
-  return _connectSSL(nullptr);
+  return cache->_get(host, port);
+}
+
+int WiFiClientSecure::connect(IPAddress ip, uint16_t port) {
+  return _connectTLS(ip, port, nullptr, ip.toString().c_str());
 }
 
 int WiFiClientSecure::connect(const char* name, uint16_t port) {
@@ -217,17 +247,79 @@ int WiFiClientSecure::connect(const char* name, uint16_t port) {
     DEBUG_BSSL("connect: Name lookup failure\n");
     return 0;
   }
-  if (!WiFiClient::connect(remote_addr, port)) {
-    DEBUG_BSSL("connect: Unable to connect TCP socket\n");
-    return 0;
-  }
-  return _connectSSL(name);
+  return _connectTLS(remote_addr, port, name, name);
 }
 
 int WiFiClientSecure::connect(const String& host, uint16_t port) {
   return connect(host.c_str(), port);
 }
 
+BufferPool *WiFiClientSecure::_defaultBufferPool = nullptr;
+
+bool WiFiClientSecure::_allocBuffers() {
+  BufferPool *pool = _bufferPool ? _bufferPool : _defaultBufferPool;
+  _iobuf_in = nullptr;
+  _iobuf_out = nullptr;
+  if (pool) {
+    _iobuf_in = pool->_acquire(true, _iobuf_in_size);
+    _iobuf_out = pool->_acquire(false, _iobuf_out_size);
+    if (!_iobuf_in || !_iobuf_out) {
+      pool->_fallbacks++;
+      DEBUG_BSSL("_allocBuffers: pool exhausted or too small, using heap\n");
+    }
+  }
+  if (!_iobuf_in) {
+    _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
+  }
+  if (!_iobuf_out) {
+    _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
+  }
+  return _iobuf_in && _iobuf_out;
+}
+
+bool WiFiClientSecure::_connectTLS(IPAddress ip, uint16_t port, const char *hostName, const char *key) {
+  if (!WiFiClient::connect(ip, port)) {
+    DEBUG_BSSL("connect: Unable to connect TCP socket\n");
+    return false;
+  }
+  SessionCache *cache = _sessionCache ? _sessionCache : _defaultSessionCache;
+  Session *slot = _sessionFromCache(key, port);
+  int mfln = (_mfln_auto < 0) ? (cache ? 4096 : 0) : _mfln_auto;
+  if (mfln && slot && cache->_getMFLN(slot) == SessionCache::MFLN_UNSUPPORTED) {
+    mfln = 0; // Known not to work, don't bother
+  }
+  if (!mfln) {
+    _cachedSession = slot;
+    return _connectSSL(hostName);
+  }
+
+  // A receive buffer smaller than 16K makes BearSSL ask for MFLN in the ClientHello
+  int full_in_size = _iobuf_in_size;
+  _iobuf_in_size = mfln + 325;
+  _cachedSession = slot;
+  bool ret = _connectSSL(hostName);
+  bool negotiated = ret && br_ssl_engine_get_mfln_negotiated(_eng);
+  bool retry = (ret && !negotiated) || (!ret && getLastSSLError() == BR_ERR_TOO_LARGE);
+  _iobuf_in_size = full_in_size;
+  if (slot && (negotiated || retry)) {
+    cache->_setMFLN(slot, negotiated ? mfln : SessionCache::MFLN_UNSUPPORTED);
+  }
+  if (retry) {
+    // Server ignored the request, so it may send full 16K records.  Reconnect with room
+    // for them, resuming the session just made if there was one
+    DEBUG_BSSL("connect: MFLN %d refused, reconnecting with full buffers\n", mfln);
+    WiFiClient::stop();
+    _freeSSL();
+    if (!WiFiClient::connect(ip, port)) {
+      DEBUG_BSSL("connect: Unable to connect TCP socket\n");
+      return false;
+    }
+    _cachedSession = slot;
+    ret = _connectSSL(hostName);
+  }
+  return ret;
+}
+
 void WiFiClientSecure::_freeSSL() {
   // These are smart pointers and will free if refcnt==0
   _sc = nullptr;
@@ -1060,8 +1152,7 @@ bool WiFiClientSecure::_connectSSL(const char* hostName) {
 
   _sc = std::make_shared<br_ssl_client_context>();
   _eng = &_sc->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
-  _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
-  _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
+  _allocBuffers();
 
   if (!_sc || !_iobuf_in || !_iobuf_out) {
     _freeSSL(); // Frees _sc, _iobuf*
@@ -1101,18 +1192,41 @@ bool WiFiClientSecure::_connectSSL(const char* hostName) {
 #endif
   }
 
-  // Restore session from the storage spot, if present
-  if (_session) {
-    br_ssl_engine_set_session_parameters(_eng, _session->getSession());
+  // Restore session from the storage spot or the cache, if present
+  Session *session = _session ? _session : _cachedSession;
+  uint8_t offered_id[32];
+  size_t offered_id_len = 0;
+  if (session) {
+    br_ssl_engine_set_session_parameters(_eng, session->getSession());
+    offered_id_len = session->getSession()->session_id_len;
+    memcpy(offered_id, session->getSession()->session_id, sizeof(offered_id));
   }
 
-  if (!br_ssl_client_reset(_sc.get(), hostName, _session?1:0)) {
+  if (!br_ssl_client_reset(_sc.get(), hostName, session?1:0)) {
     _freeSSL();
+    _cachedSession = nullptr;
     DEBUG_BSSL("_connectSSL: Can't reset client\n");
     return false;
   }
 
   auto ret = _wait_for_handshake();
+
+  // Save the cached session right away, the client may never be stop()ed
+  if (_cachedSession) {
+    SessionCache *cache = _sessionCache ? _sessionCache : _defaultSessionCache;
+    if (ret) {
+      br_ssl_session_parameters *params = _cachedSession->getSession();
+      br_ssl_engine_get_session_parameters(_eng, params);
+      // Server echoes our session ID back only when it accepted to resume
+      bool resumed = offered_id_len && (params->session_id_len == offered_id_len) &&
+                     !memcmp(params->session_id, offered_id, offered_id_len);
+      cache->_count(resumed);
+      DEBUG_BSSL("_connectSSL: %s handshake\n", resumed ? "resumed" : "full");
+    } else {
+      cache->_forget(_cachedSession);
+    }
+    _cachedSession = nullptr;
+  }
 #ifdef DEBUG_ESP_SSL
   if (!ret) {
     char err[256];
@@ -1171,13 +1285,12 @@ bool WiFiClientSecure::_installServerX509Validator(const X509List *client_CA_ta)
 // Called by WiFiServerBearSSL when an RSA cert/key is specified.
 bool WiFiClientSecure::_connectSSLServerRSA(const X509List *chain,
     const PrivateKey *sk,
-    const X509List *client_CA_ta) {
+    const X509List *client_CA_ta, ServerSessions *cache) {
   _freeSSL();
   _oom_err = false;
   _sc_svr = std::make_shared<br_ssl_server_context>();
   _eng = &_sc_svr->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
-  _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
-  _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
+  _allocBuffers();
 
   if (!_sc_svr || !_iobuf_in || !_iobuf_out) {
     _freeSSL();
@@ -1195,6 +1308,9 @@ bool WiFiClientSecure::_connectSSLServerRSA(const X509List *chain,
     DEBUG_BSSL("_connectSSLServerRSA: Can't install serverX509check\n");
     return false;
   }
+  if (cache && cache->getCache()) {
+    br_ssl_server_set_cache(_sc_svr.get(), cache->getCache());
+  }
   if (!br_ssl_server_reset(_sc_svr.get())) {
     _freeSSL();
     DEBUG_BSSL("_connectSSLServerRSA: Can't reset server ctx\n");
@@ -1207,14 +1323,13 @@ bool WiFiClientSecure::_connectSSLServerRSA(const X509List *chain,
 // Called by WiFiServerBearSSL when an elliptic curve cert/key is specified.
 bool WiFiClientSecure::_connectSSLServerEC(const X509List *chain,
     unsigned cert_issuer_key_type, const PrivateKey *sk,
-    const X509List *client_CA_ta) {
+    const X509List *client_CA_ta, ServerSessions *cache) {
 #ifndef BEARSSL_SSL_BASIC
   _freeSSL();
   _oom_err = false;
   _sc_svr = std::make_shared<br_ssl_server_context>();
   _eng = &_sc_svr->eng; // Allocation/deallocation taken care of by the _sc shared_ptr
-  _iobuf_in = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_in_size], std::default_delete<unsigned char[]>());
-  _iobuf_out = std::shared_ptr<unsigned char>(new (std::nothrow) unsigned char[_iobuf_out_size], std::default_delete<unsigned char[]>());
+  _allocBuffers();
 
   if (!_sc_svr || !_iobuf_in || !_iobuf_out) {
     _freeSSL();
@@ -1232,6 +1347,9 @@ bool WiFiClientSecure::_connectSSLServerEC(const X509List *chain,
     DEBUG_BSSL("_connectSSLServerEC: Can't install serverX509check\n");
     return false;
   }
+  if (cache && cache->getCache()) {
+    br_ssl_server_set_cache(_sc_svr.get(), cache->getCache());
+  }
   if (!br_ssl_server_reset(_sc_svr.get())) {
     _freeSSL();
     DEBUG_BSSL("_connectSSLServerEC: Can't reset server ctx\n");
@@ -1244,6 +1362,7 @@ bool WiFiClientSecure::_connectSSLServerEC(const X509List *chain,
   (void) cert_issuer_key_type;
   (void) sk;
   (void) client_CA_ta;
+  (void) cache;
   DEBUG_BSSL("_connectSSLServerEC: Attempting to use EC cert in minimal cipher mode (no EC)\n");
   return false;
 #endif
@@ -65,6 +65,10 @@ class WiFiClientSecure : public WiFiClient {
 
     // Allow sessions to be saved/restored automatically to a memory area
     void setSession(Session *session) { _session = session; }
+    // Save and offer sessions per host:port automatically.  An explicit setSession() takes precedence
+    void setSessionCache(SessionCache *cache) { _sessionCache = cache; }
+    // Cache used by all clients which haven't been given their own
+    static void setDefaultSessionCache(SessionCache *cache) { _defaultSessionCache = cache; }
 
     // Don't validate the chain, just accept whatever is given.  VERY INSECURE!
     void setInsecure() {
@@ -107,6 +111,16 @@ class WiFiClientSecure : public WiFiClient {
     // Sets the requested buffer size for transmit and receive
     void setBufferSizes(int recv, int xmit);
 
+    // Borrow the I/O buffers from a preallocated pool while connected, see BufferPool
+    void setBufferPool(BufferPool *pool) { _bufferPool = pool; }
+    // Pool used by all clients which haven't been given their own
+    static void setDefaultBufferPool(BufferPool *pool) { _defaultBufferPool = pool; }
+
+    // Ask for MFLN of len (512..4096) in every handshake and size the receive buffer to it,
+    // reconnecting with full size buffers to servers that refuse.  0 disables.  On by default
+    // (4096) when a SessionCache remembers the per-host results and setBufferSizes() wasn't used
+    void setAutoMFLN(uint16_t len);
+
     // Returns whether MFLN negotiation for the above buffer sizes succeeded (after connection)
     int getMFLNStatus() {
       return connected() && br_ssl_engine_get_mfln_negotiated(_eng);
@@ -149,6 +163,9 @@ class WiFiClientSecure : public WiFiClient {
     std::shared_ptr<br_x509_knownkey_context> _x509_knownkey;
     std::shared_ptr<unsigned char> _iobuf_in;
     std::shared_ptr<unsigned char> _iobuf_out;
+    BufferPool *_bufferPool;
+    static BufferPool *_defaultBufferPool;
+    bool _allocBuffers(); // From the pool if possible, else the heap
     time_t _now;
     const X509List *_ta;
     CertStore *_certStore;
@@ -160,6 +177,14 @@ class WiFiClientSecure : public WiFiClient {
     // Optional storage space pointer for session parameters
     // Will be used on connect and updated on close
     Session *_session;
+    // Optional host:port keyed cache, and the slot from it used by the current connect()
+    SessionCache *_sessionCache;
+    Session *_cachedSession;
+    static SessionCache *_defaultSessionCache;
+    Session *_sessionFromCache(const char *host, uint16_t port);
+    int _mfln_auto; // Fragment length to request, 0 off, -1 only if a session cache is present
+    // TCP connect and handshake, with automatic MFLN if enabled.  key names the cache entry
+    bool _connectTLS(IPAddress ip, uint16_t port, const char *hostName, const char *key);
 
     bool _use_insecure;
     bool _use_fingerprint;
@@ -190,15 +215,17 @@ class WiFiClientSecure : public WiFiClient {
     // Methods for handling server.available() call which returns a client connection.
     friend class WiFiServerSecure; // Server needs to access these constructors
     WiFiClientSecure(ClientContext *client, const X509List *chain, unsigned cert_issuer_key_type,
-                      const PrivateKey *sk, int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta);
+                      const PrivateKey *sk, int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta,
+                      ServerSessions *cache);
     WiFiClientSecure(ClientContext* client, const X509List *chain, const PrivateKey *sk,
-                      int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta);
+                      int iobuf_in_size, int iobuf_out_size, const X509List *client_CA_ta, ServerSessions *cache);
 
     // RSA keyed server
-    bool _connectSSLServerRSA(const X509List *chain, const PrivateKey *sk, const X509List *client_CA_ta);
+    bool _connectSSLServerRSA(const X509List *chain, const PrivateKey *sk, const X509List *client_CA_ta,
+                              ServerSessions *cache);
     // EC keyed server
     bool _connectSSLServerEC(const X509List *chain, unsigned cert_issuer_key_type, const PrivateKey *sk,
-                             const X509List *client_CA_ta);
+                             const X509List *client_CA_ta, ServerSessions *cache);
 
     // X.509 validators differ from server to client
     bool _installClientX509Validator(); // Set up X509 validator for a client conn.
@@ -55,6 +55,12 @@ class WiFiServerSecure : public WiFiServer {
       _client_CA_ta = client_CA_ta;
     }
 
+    // Let clients resume earlier TLS sessions instead of doing a full handshake.
+    // Shared by all accepted clients; caller needs to preserve it for the life of the server.
+    void setCache(ServerSessions *cache) {
+      _cache = cache;
+    }
+
     // If awaiting connection available and authenticated (i.e. client cert), return it.
     WiFiClientSecure available(uint8_t* status = NULL);
 
@@ -69,6 +75,7 @@ class WiFiServerSecure : public WiFiServer {
     int _iobuf_in_size = BR_SSL_BUFSIZE_INPUT;
     int _iobuf_out_size = 837;
     const X509List *_client_CA_ta = nullptr;
+    ServerSessions *_cache = nullptr;
 
 };
 
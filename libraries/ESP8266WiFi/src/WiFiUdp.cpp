@@ -189,6 +189,28 @@ size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
     return _ctx->append(reinterpret_cast<const char*>(buffer), size);
 }
 
+void WiFiUDP::setTxPool(uint8_t depth)
+{
+    if (_ctx)
+        _ctx->setTxPool(depth);
+}
+
+int WiFiUDP::queuePacket()
+{
+    if (!_ctx)
+        return 0;
+
+    return (_ctx->queue()) ? 1 : 0;
+}
+
+int WiFiUDP::sendQueued()
+{
+    if (!_ctx)
+        return 0;
+
+    return _ctx->sendQueued();
+}
+
 int WiFiUDP::parsePacket()
 {
     if (!_ctx)
@@ -263,6 +285,20 @@ uint16_t WiFiUDP::localPort() const
     return _ctx->getLocalPort();
 }
 
+void WiFiUDP::setRxQueueMax(uint8_t packets)
+{
+    if (_ctx)
+        _ctx->setRxQueueMax(packets);
+}
+
+uint32_t WiFiUDP::rxDropped() const
+{
+    if (!_ctx)
+        return 0;
+
+    return _ctx->rxDropped();
+}
+
 void WiFiUDP::stopAll()
 {
     for (WiFiUDP* it = _s_first; it; it = it->_next) {
@@ -77,6 +77,20 @@ public:
   
   using Print::write;
 
+  // Batched sending
+  // (the following functions are to be called after begin() or beginPacket())
+
+  // Keep up to 'depth' (max 4) transmit buffers for reuse by next packets
+  // instead of allocating them for each packet (0 = disabled, default)
+  void setTxPool(uint8_t depth);
+  // Finish off this packet and queue it for a later sendQueued()
+  // Destination is the one given to the last beginPacket()
+  // Returns 1 if the packet was queued, 0 if the queue (8 packets) is full or on error
+  int queuePacket();
+  // Send all queued packets
+  // Returns the number of packets sent successfully
+  int sendQueued();
+
   // Start processing the next available incoming packet
   // Returns the size of the packet in bytes, or 0 if no packets are available
   int parsePacket() override;
@@ -104,6 +118,12 @@ public:
   // Return the local port for outgoing packets
   uint16_t localPort() const;
 
+  // Maximum number of received packets kept until read, including
+  // the current one (default 4), extra packets are dropped
+  void setRxQueueMax(uint8_t packets);
+  // Number of received packets dropped because the queue was full or out of memory
+  uint32_t rxDropped() const;
+
   static void stopAll();
   static void stopAllExcept(WiFiUDP * exC);
 
@@ -52,6 +52,12 @@ public:
     , _tx_buf_head(0)
     , _tx_buf_cur(0)
     , _tx_buf_offset(0)
+    , _tx_pool_depth(0)
+    , _tx_pool_count(0)
+    , _tx_queue_count(0)
+    , _rx_count(0)
+    , _rx_max(rxBufMaxDepth)
+    , _rx_dropped(0)
     {
         _pcb = udp_new();
 #ifdef LWIP_MAYBE_XCC
@@ -77,6 +83,10 @@ public:
             _rx_buf_offset = 0;
             _rx_buf_size = 0;
         }
+        for (uint8_t i = 0; i < _tx_queue_count; i++)
+            pbuf_free(_tx_queue[i].buf.pb);
+        _tx_queue_count = 0;
+        setTxPool(0);
     }
 
     void ref()
@@ -225,6 +235,21 @@ public:
         _rx_buf_offset = pos;
     }
 
+    /*
+     * Maximum number of received packets held in the rx chain,
+     * including the one currently being read.
+     * Packets arriving beyond this limit are dropped and counted.
+     */
+    void setRxQueueMax(int packets)
+    {
+        _rx_max = packets > 0 ? packets : 1;
+    }
+
+    uint32_t rxDropped() const
+    {
+        return _rx_dropped;
+    }
+
     bool isValidOffset(const size_t pos) const {
         return (pos <= _rx_buf_size);
     }
@@ -300,7 +325,10 @@ public:
             // ref'ing it to prevent release from the below pbuf_free(deleteme)
             // (ref counter prevents release and will be decreased by pbuf_free)
             pbuf_ref(_rx_buf);
+            --_rx_count;
         }
+        else
+            _rx_count = 0;
 
         // release in chain previous data, and if any:
         // current helper, but not start of current data
@@ -393,6 +421,13 @@ public:
 
     void cancelBuffer ()
     {
+        if (_tx_pool_depth && _tx_buf_head && _tx_buf_head->tot_len <= txPoolMaxSize)
+        {
+            // tx pool enabled: keep the staging chain for next packet
+            _tx_buf_cur = _tx_buf_head;
+            _tx_buf_offset = 0;
+            return;
+        }
         if (_tx_buf_head)
             pbuf_free(_tx_buf_head);
         _tx_buf_head = 0;
@@ -417,26 +452,171 @@ public:
         return err == ERR_OK;
     }
 
+    /*
+     * Keep up to 'depth' sent pbufs for reuse by next packets instead of
+     * allocating and releasing one per packet (0 = disabled, default).
+     * The append() staging buffer is also kept between packets when enabled.
+     */
+    void setTxPool(int depth)
+    {
+        if (depth < 0)
+            depth = 0;
+        else if (depth > txPoolMaxDepth)
+            depth = txPoolMaxDepth;
+        _tx_pool_depth = depth;
+        while (_tx_pool_count > _tx_pool_depth)
+            pbuf_free(_tx_pool[--_tx_pool_count].pb);
+    }
+
+    /*
+     * Finish the current packet and queue it instead of sending it.
+     * Destination defaults to the connect()ed one.
+     * Returns false and discards the packet when the queue is full.
+     */
+    bool queue(const ip_addr_t* addr = 0, uint16_t port = 0)
+    {
+        TxBuf tx = { nullptr, nullptr, 0 };
+        if (_tx_queue_count < txQueueMaxDepth)
+            tx = _txCopy();
+        cancelBuffer();
+        if (!tx.pb)
+        {
+            DEBUGV(":uqf %d\r\n", _tx_queue_count);
+            return false;
+        }
+
+        TxQueued& q = _tx_queue[_tx_queue_count++];
+        q.buf = tx;
+        if (addr)
+        {
+            ip_addr_copy(q.addr, *addr);
+            q.port = port;
+        }
+        else
+        {
+            ip_addr_copy(q.addr, _pcb->remote_ip);
+            q.port = _pcb->remote_port;
+        }
+        return true;
+    }
+
+    size_t queued() const
+    {
+        return _tx_queue_count;
+    }
+
+    /*
+     * Send all queued packets in a row, empty the queue.
+     * Returns the number of packets successfully sent.
+     */
+    size_t sendQueued()
+    {
+        size_t sent = 0;
+        for (uint8_t i = 0; i < _tx_queue_count; i++)
+        {
+            TxQueued& q = _tx_queue[i];
+            err_t err = udp_sendto(_pcb, q.buf.pb, &q.addr, q.port);
+            if (err == ERR_OK)
+                sent++;
+            else
+                DEBUGV(":usq rc=%d\r\n", (int) err);
+            _txRelease(q.buf);
+        }
+        _tx_queue_count = 0;
+        return sent;
+    }
+
 private:
 
-    err_t trySend(const ip_addr_t* addr, uint16_t port, bool keepBufferOnError)
+    // tx pbuf handed to lwIP, along with what is needed to reuse it
+    struct TxBuf
+    {
+        pbuf* pb;
+        void* payload;      // payload pointer as allocated (lwIP moves it while prepending headers)
+        u16_t capacity;     // allocated payload size
+    };
+
+    struct TxQueued
+    {
+        TxBuf buf;
+        ip_addr_t addr;
+        u16_t port;
+    };
+
+    TxBuf _txAcquire(size_t size)
+    {
+        TxBuf ret = { nullptr, nullptr, 0 };
+        int best = -1;
+        // pick the smallest pooled pbuf large enough that nobody else (ARP
+        // queue, fragmentation, driver) is still referencing
+        for (int i = 0; i < _tx_pool_count; i++)
+            if (_tx_pool[i].pb->ref == 1 && _tx_pool[i].capacity >= size && (best < 0 || _tx_pool[i].capacity < _tx_pool[best].capacity))
+                best = i;
+
+        if (best >= 0)
+        {
+            ret = _tx_pool[best];
+            _tx_pool[best] = _tx_pool[--_tx_pool_count];
+            ret.pb->payload = ret.payload;
+            ret.pb->len = ret.pb->tot_len = size;
+        }
+        else if ((ret.pb = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM)))
+        {
+            ret.payload = ret.pb->payload;
+            ret.capacity = size;
+        }
+        return ret;
+    }
+
+    void _txRelease(TxBuf& tx)
+    {
+        // lwIP and the driver usually still hold the pbuf right after
+        // sending, it is kept anyway and _txAcquire() waits for them
+        if (tx.capacity <= txPoolMaxSize && _tx_pool_depth)
+        {
+            if (_tx_pool_count < _tx_pool_depth)
+            {
+                _tx_pool[_tx_pool_count++] = tx;
+                tx.pb = nullptr;
+                return;
+            }
+            // pool is full: keep the larger one
+            int smallest = 0;
+            for (int i = 1; i < _tx_pool_count; i++)
+                if (_tx_pool[i].capacity < _tx_pool[smallest].capacity)
+                    smallest = i;
+            if (_tx_pool[smallest].capacity < tx.capacity)
+                std::swap(_tx_pool[smallest], tx);
+        }
+        pbuf_free(tx.pb);
+        tx.pb = nullptr;
+    }
+
+    // copy staged data into a single pbuf ready for udp_sendto()
+    TxBuf _txCopy()
     {
         size_t data_size = _tx_buf_offset;
-        pbuf* tx_copy = pbuf_alloc(PBUF_TRANSPORT, data_size, PBUF_RAM);
-        if (tx_copy) {
-            uint8_t* dst = reinterpret_cast<uint8_t*>(tx_copy->payload);
-            for (pbuf* p = _tx_buf_head; p; p = p->next) {
+        TxBuf tx = _txAcquire(data_size);
+        if (tx.pb) {
+            uint8_t* dst = reinterpret_cast<uint8_t*>(tx.pb->payload);
+            for (pbuf* p = _tx_buf_head; p && data_size; p = p->next) {
                 size_t will_copy = (data_size < p->len) ? data_size : p->len;
                 memcpy(dst, p->payload, will_copy);
                 dst += will_copy;
                 data_size -= will_copy;
             }
         }
+        return tx;
+    }
+
+    err_t trySend(const ip_addr_t* addr, uint16_t port, bool keepBufferOnError)
+    {
+        TxBuf tx = _txCopy();
 
         if (!keepBufferOnError)
             cancelBuffer();
 
-        if (!tx_copy){
+        if (!tx.pb){
             DEBUGV("failed pbuf_alloc");
             return ERR_MEM;
         }
@@ -446,12 +626,12 @@ private:
             port = _pcb->remote_port;
         }
 
-        err_t err = udp_sendto(_pcb, tx_copy, addr, port);
+        err_t err = udp_sendto(_pcb, tx.pb, addr, port);
         if (err != ERR_OK) {
             DEBUGV(":ust rc=%d\r\n", (int) err);
         }
 
-        pbuf_free(tx_copy);
+        _txRelease(tx);
 
         if (err == ERR_OK)
             cancelBuffer(); // no error: get rid of buffer
@@ -513,19 +693,14 @@ private:
             const ip_addr_t *srcaddr, u16_t srcport)
     {
         (void) upcb;
-        // check receive pbuf chain depth
-        // optimization path: cache the pbuf chain length
+        // check receive queue depth
+        if (_rx_buf && _rx_count >= _rx_max)
         {
-            pbuf* p;
-            int count = 0;
-            for (p = _rx_buf; p && ++count < rxBufMaxDepth*2; p = p->next);
-            if (p)
-            {
-                // pbuf chain too deep, dropping
-                pbuf_free(pb);
-                DEBUGV(":udr\r\n");
-                return;
-            }
+            // too many packets waiting, dropping
+            pbuf_free(pb);
+            ++_rx_dropped;
+            DEBUGV(":udr\r\n");
+            return;
         }
 
         // chain this helper pbuf first
@@ -550,6 +725,7 @@ private:
             {
                 // memory issue - discard received data
                 pbuf_free(pb);
+                ++_rx_dropped;
                 return;
             }
             // construct in place
@@ -561,6 +737,7 @@ private:
             // now chain the new data pbuf
             DEBUGV(":urch %d, %d\r\n", _rx_buf->tot_len, pb->tot_len);
             pbuf_cat(_rx_buf, pb);
+            ++_rx_count;
         }
         else
         {
@@ -574,6 +751,7 @@ private:
             _rx_buf = pb;
             _rx_buf_offset = 0;
             _rx_buf_size = pb->tot_len;
+            _rx_count = 1;
         }
 
         if (_on_rx) {
@@ -599,6 +777,20 @@ private:
     pbuf* _tx_buf_head;
     pbuf* _tx_buf_cur;
     size_t _tx_buf_offset;
+    // tx pool and queue limits
+    static constexpr int txPoolMaxDepth = 4;
+    static constexpr int txQueueMaxDepth = 8;
+    // biggest pooled buffer (unfragmented UDP payload over ethernet)
+    static constexpr size_t txPoolMaxSize = 1472;
+
+    TxBuf _tx_pool[txPoolMaxDepth];
+    uint8_t _tx_pool_depth;
+    uint8_t _tx_pool_count;
+    TxQueued _tx_queue[txQueueMaxDepth];
+    uint8_t _tx_queue_count;
+    int _rx_count;
+    int _rx_max;
+    uint32_t _rx_dropped;
     rxhandler_t _on_rx;
 #ifdef LWIP_MAYBE_XCC
     uint16_t _mcast_ttl;
@@ -22,12 +22,19 @@
 #include <WiFiClient.h> 
 #include <WiFiServer.h>
 #include <assert.h>
+#include <algorithm>
 
 #include "ESP8266WiFiMesh.h"
 #include "TypeConversionFunctions.h"
 
 #define SERVER_IP_ADDR      "192.168.4.1"
 
+// Binary frames: marker byte (never the first byte of a String request), frame type, 16 bit little endian payload length, payload.
+#define FRAME_MARKER        0x00
+#define FRAME_REQUEST       0x01
+#define FRAME_RESPONSE      0x02
+#define FRAME_HEADER_LENGTH 4
+
 const IPAddress ESP8266WiFiMesh::emptyIP = IPAddress();
 const uint32_t ESP8266WiFiMesh::lwipVersion203Signature[3] {2,0,3};
 
@@ -157,6 +164,9 @@ void ESP8266WiFiMesh::deactivateAP()
 {
   if(isAPController())
   {
+    for(ServerSession &session : _serverSessions)
+      session.client.stop();
+    _serverSessions.clear();
     _server.stop();
     WiFi.softAPdisconnect();
     WiFi.mode(WIFI_STA);
@@ -244,6 +254,24 @@ void ESP8266WiFiMesh::setScanHidden(bool scanHidden)
   _scanHidden = scanHidden;
 }
 
+void ESP8266WiFiMesh::setBinaryRequestHandler(ESP8266WiFiMesh::binaryRequestHandlerType binaryRequestHandler) {_binaryRequestHandler = binaryRequestHandler;}
+ESP8266WiFiMesh::binaryRequestHandlerType ESP8266WiFiMesh::getBinaryRequestHandler() {return _binaryRequestHandler;}
+
+void ESP8266WiFiMesh::setBinaryResponseHandler(ESP8266WiFiMesh::binaryResponseHandlerType binaryResponseHandler) {_binaryResponseHandler = binaryResponseHandler;}
+ESP8266WiFiMesh::binaryResponseHandlerType ESP8266WiFiMesh::getBinaryResponseHandler() {return _binaryResponseHandler;}
+
+void ESP8266WiFiMesh::setMaxFrameLength(uint16_t maxFrameLength)
+{
+  _maxFrameLength = maxFrameLength;
+  _frameBuffer.clear(); // Reallocated with the new size on next use
+  _frameBuffer.shrink_to_fit();
+}
+
+uint16_t ESP8266WiFiMesh::getMaxFrameLength() {return _maxFrameLength;}
+
+void ESP8266WiFiMesh::setSessionTimeout(uint32_t sessionTimeoutMs) {_sessionTimeoutMs = sessionTimeoutMs;}
+uint32_t ESP8266WiFiMesh::getSessionTimeout() {return _sessionTimeoutMs;}
+
 bool ESP8266WiFiMesh::getScanHidden() {return _scanHidden;}
 
 void ESP8266WiFiMesh::setAPHidden(bool apHidden)
@@ -381,6 +409,153 @@ transmission_status_t ESP8266WiFiMesh::exchangeInfo(WiFiClient &currClient)
   return _responseHandler(response, *this);
 }
 
+/**
+ * The address of the node server, which is the gateway of the AP we are connected to.
+ */
+IPAddress ESP8266WiFiMesh::serverIP()
+{
+  IPAddress gatewayIP = WiFi.gatewayIP();
+  if(gatewayIP.isSet())
+    return gatewayIP;
+
+  IPAddress defaultIP;
+  defaultIP.fromString(SERVER_IP_ADDR);
+  return defaultIP;
+}
+
+/**
+ * Make sure the frame buffer can hold one received payload followed by one response frame.
+ */
+bool ESP8266WiFiMesh::allocateFrameBuffer()
+{
+  if(_frameBuffer.empty())
+    _frameBuffer.resize(2 * _maxFrameLength + FRAME_HEADER_LENGTH);
+
+  return !_frameBuffer.empty();
+}
+
+static void writeFrameHeader(uint8_t *frame, uint8_t frameType, size_t length)
+{
+  frame[0] = FRAME_MARKER;
+  frame[1] = frameType;
+  frame[2] = (uint8_t)length;
+  frame[3] = (uint8_t)(length >> 8);
+}
+
+/**
+ * Read exactly length bytes, in as few reads as the received data allows.
+ *
+ * @returns: True if all bytes were read, false if the client disconnected or nothing was received for maxWait ms.
+ */
+static bool readFully(WiFiClient &currClient, uint8_t *data, size_t length, uint32_t maxWait)
+{
+  uint32_t lastReceived = millis();
+  while(length > 0)
+  {
+    int received = currClient.available() ? currClient.read(data, length) : 0;
+    if(received > 0)
+    {
+      data += received;
+      length -= received;
+      lastReceived = millis();
+    }
+    else
+    {
+      uint32_t waitingTime = millis() - lastReceived;
+      if(!currClient.connected() || waitingTime >= maxWait)
+        return false;
+      yield();
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Read one frame of the given type into the start of the frame buffer.
+ *
+ * @param length Set to the payload length of the frame.
+ * @returns: True if a complete frame was read, false on timeout or if the frame is malformed or too long.
+ */
+bool ESP8266WiFiMesh::readFrame(WiFiClient &currClient, uint8_t frameType, size_t &length, uint32_t maxWait)
+{
+  uint8_t header[FRAME_HEADER_LENGTH];
+
+  if(!readFully(currClient, header, FRAME_HEADER_LENGTH, maxWait) || header[0] != FRAME_MARKER || header[1] != frameType)
+    return false;
+
+  length = header[2] | (header[3] << 8);
+  if(length > _maxFrameLength)
+  {
+    verboseModePrint(F("Frame too long!"));
+    return false;
+  }
+
+  return readFully(currClient, _frameBuffer.data(), length, maxWait);
+}
+
+/**
+ * Send all the current binary messages, then read back one response per message
+ * and pass each to the user-supplied binaryResponseHandler.
+ *
+ * @param currClient The client to which the messages should be transmitted.
+ * @param responseCount Set to the number of responses received.
+ * @returns: A status code based on the outcome of the exchange. The lowest status returned by the binaryResponseHandler wins.
+ *
+ */
+transmission_status_t ESP8266WiFiMesh::exchangeBinary(WiFiClient &currClient, size_t &responseCount)
+{
+  verboseModePrint("Transmitting binary");
+
+  responseCount = 0;
+
+  // Pack as many frames as fit in the frame buffer into each write, so that small messages share TCP segments.
+  uint8_t *frames = _frameBuffer.data();
+  size_t framesLength = 0;
+
+  for(size_t i = 0; i < _binaryMessageCount; ++i)
+  {
+    size_t frameLength = FRAME_HEADER_LENGTH + _binaryMessages[i].length;
+
+    if(framesLength + frameLength > _frameBuffer.size())
+    {
+      if(currClient.write(frames, framesLength) != framesLength)
+        return TS_CONNECTION_FAILED;
+      framesLength = 0;
+    }
+
+    writeFrameHeader(frames + framesLength, FRAME_REQUEST, _binaryMessages[i].length);
+    memcpy(frames + framesLength + FRAME_HEADER_LENGTH, _binaryMessages[i].data, _binaryMessages[i].length);
+    framesLength += frameLength;
+  }
+
+  if(currClient.write(frames, framesLength) != framesLength)
+    return TS_CONNECTION_FAILED;
+  yield();
+
+  transmission_status_t transmissionOutcome = TS_TRANSMISSION_COMPLETE;
+
+  for(size_t i = 0; i < _binaryMessageCount; ++i)
+  {
+    size_t responseLength = 0;
+    if(!readFrame(currClient, FRAME_RESPONSE, responseLength, _stationModeTimeoutMs))
+    {
+      verboseModePrint(F("No response!"));
+      return TS_TRANSMISSION_FAILED;
+    }
+    ++responseCount;
+
+    if(_binaryResponseHandler)
+    {
+      transmission_status_t responseOutcome = _binaryResponseHandler(_frameBuffer.data(), responseLength, *this);
+      if(responseOutcome < transmissionOutcome)
+        transmissionOutcome = responseOutcome;
+    }
+  }
+
+  return transmissionOutcome;
+}
+
 /**
  * Handle data transfer process with a connected AP.
  *
@@ -408,11 +583,53 @@ transmission_status_t ESP8266WiFiMesh::attemptDataTransfer()
  */
 transmission_status_t ESP8266WiFiMesh::attemptDataTransferKernel()
 {
+  if(_binaryMessages)
+  {
+    // Reuse the TCP session to this node if it is still open. The node may have closed it in the meantime,
+    // so retry once on a new connection as long as no response has been received yet.
+    uint32_t sessionIdleTime = millis() - _sessionLastUsed;
+    bool reuseSession = _sessionClient.connected() && _sessionSSID == lastSSID && sessionIdleTime < _sessionTimeoutMs;
+    transmission_status_t transmissionOutcome = TS_CONNECTION_FAILED;
+
+    for(int attempt = reuseSession ? 0 : 1; attempt < 2; ++attempt)
+    {
+      if(attempt == 1)
+      {
+        _sessionClient.stop();
+        _sessionClient.setTimeout(_stationModeTimeoutMs);
+
+        if (!_sessionClient.connect(serverIP(), _serverPort))
+        {
+          fullStop(_sessionClient);
+          verboseModePrint(F("Server unavailable"));
+          return TS_CONNECTION_FAILED;
+        }
+        _sessionClient.setNoDelay(true); // Frames are small and written whole, Nagle would only delay them
+        _sessionSSID = lastSSID;
+      }
+
+      size_t responseCount = 0;
+      transmissionOutcome = exchangeBinary(_sessionClient, responseCount);
+      if(transmissionOutcome > 0 || responseCount > 0)
+        break;
+    }
+
+    _sessionLastUsed = millis();
+    if(transmissionOutcome <= 0 || _sessionTimeoutMs == 0)
+    {
+      verboseModePrint(F("Binary session closed."));
+      _sessionClient.stop();
+      yield();
+    }
+
+    return transmissionOutcome;
+  }
+
   WiFiClient currClient;
   currClient.setTimeout(_stationModeTimeoutMs);
 
   /* Connect to the node's server */
-  if (!currClient.connect(SERVER_IP_ADDR, _serverPort)) 
+  if (!currClient.connect(serverIP(), _serverPort)) 
   {
     fullStop(currClient);
     verboseModePrint(F("Server unavailable"));
@@ -527,34 +744,53 @@ void ESP8266WiFiMesh::attemptTransmission(const String &message, bool concluding
   {
     transmission_status_t transmissionResult = attemptDataTransfer();
     latestTransmissionOutcomes.push_back(TransmissionResult(connectionQueue.back(), transmissionResult));
+    recordTransmission(lastSSID, transmissionResult);
   }
   else
   {
-    if(!noScan)
+    uint32_t scanAge = millis() - _lastScanTime;
+    
+    if(!noScan && _scanCacheValid && scanAge < _scanCacheTimeoutMs && !scanAllWiFiChannels)
+    {
+      verboseModePrint(F("Using cached scan... "), false);
+      connectionQueue = _cachedConnectionQueue;
+    }
+    else if(!noScan)
     {
       verboseModePrint(F("Scanning... "), false);
       
       /* Scan for APs */
       connectionQueue.clear();
 
+      // A background scan started by refreshNeighbours is on its way, so use it instead of starting another one.
+      int n = WIFI_SCAN_FAILED;
+      if(_refreshScanActive && !scanAllWiFiChannels)
+      {
+        while((n = WiFi.scanComplete()) == WIFI_SCAN_RUNNING)
+          delay(1);
+      }
+      _refreshScanActive = false;
+
       // If scanAllWiFiChannels is true or Arduino core for ESP8266 version < 2.4.2 scanning will cause the WiFi radio to cycle through all WiFi channels.
       // This means existing WiFi connections are likely to break or work poorly if done frequently.
-      int n = 0;
-      #ifdef ENABLE_WIFI_SCAN_OPTIMIZATION
-      if(scanAllWiFiChannels)
+      if(n < 0)
       {
+        #ifdef ENABLE_WIFI_SCAN_OPTIMIZATION
+        if(scanAllWiFiChannels)
+        {
+          n = WiFi.scanNetworks(false, _scanHidden);
+        }
+        else
+        {
+          // Scan function argument overview: scanNetworks(bool async = false, bool show_hidden = false, uint8 channel = 0, uint8* ssid = NULL)
+          n = WiFi.scanNetworks(false, _scanHidden, _meshWiFiChannel);
+        }
+        #else
         n = WiFi.scanNetworks(false, _scanHidden);
+        #endif
       }
-      else
-      {
-        // Scan function argument overview: scanNetworks(bool async = false, bool show_hidden = false, uint8 channel = 0, uint8* ssid = NULL)
-        n = WiFi.scanNetworks(false, _scanHidden, _meshWiFiChannel);
-      }
-      #else
-      n = WiFi.scanNetworks(false, _scanHidden);
-      #endif
       
-      _networkFilter(n, *this); // Update the connectionQueue.
+      processScanResults(n); // Update the neighbour table and the connectionQueue.
     }
     
     for(NetworkInfo &currentNetwork : connectionQueue)
@@ -595,7 +831,8 @@ void ESP8266WiFiMesh::attemptTransmission(const String &message, bool concluding
 
       transmission_status_t transmissionResult = connectToNode(currentSSID, currentWiFiChannel, currentBSSID);
 
-      latestTransmissionOutcomes.push_back(TransmissionResult{.origin = currentNetwork, .transmissionStatus = transmissionResult});
+      latestTransmissionOutcomes.push_back(TransmissionResult(currentNetwork, transmissionResult));
+      recordTransmission(currentSSID, transmissionResult);
     }
   }
 
@@ -613,6 +850,83 @@ void ESP8266WiFiMesh::attemptTransmission(const String &message, bool concluding
   }
 }
 
+void ESP8266WiFiMesh::attemptBinaryTransmission(const BinaryMessage *messages, size_t messageCount, bool concludingDisconnect, bool initialDisconnect, bool noScan, bool scanAllWiFiChannels)
+{
+  latestTransmissionOutcomes.clear();
+
+  if(messageCount == 0 || !allocateFrameBuffer())
+    return;
+
+  for(size_t i = 0; i < messageCount; ++i)
+  {
+    if(messages[i].length > _maxFrameLength)
+    {
+      verboseModePrint(F("Binary message too long!"));
+      return;
+    }
+  }
+
+  if(initialDisconnect)
+    _sessionClient.stop();
+
+  _binaryMessages = messages;
+  _binaryMessageCount = messageCount;
+  attemptTransmission(getMessage(), concludingDisconnect, initialDisconnect, noScan, scanAllWiFiChannels);
+  _binaryMessages = nullptr;
+  _binaryMessageCount = 0;
+
+  if(concludingDisconnect)
+    _sessionClient.stop();
+}
+
+void ESP8266WiFiMesh::attemptBinaryTransmission(const uint8_t *data, size_t length, bool concludingDisconnect, bool initialDisconnect, bool noScan, bool scanAllWiFiChannels)
+{
+  BinaryMessage message = {data, length};
+  attemptBinaryTransmission(&message, 1, concludingDisconnect, initialDisconnect, noScan, scanAllWiFiChannels);
+}
+
+void ESP8266WiFiMesh::closeSessions()
+{
+  _sessionClient.stop();
+
+  for(ServerSession &session : _serverSessions)
+    session.client.stop();
+  _serverSessions.clear();
+}
+
+/**
+ * Answer all binary request frames currently received from a client.
+ *
+ * @returns: True if the client can be kept for further requests, false if it should be closed.
+ */
+bool ESP8266WiFiMesh::serveBinaryFrames(WiFiClient &currClient)
+{
+  if(!allocateFrameBuffer())
+    return false;
+
+  // The response frame is built after the request payload so that it can be sent with a single write.
+  uint8_t *responseFrame = _frameBuffer.data() + _maxFrameLength;
+
+  while(currClient.available())
+  {
+    size_t requestLength = 0;
+    if(!readFrame(currClient, FRAME_REQUEST, requestLength, _apModeTimeoutMs))
+      return false;
+
+    size_t responseLength = 0;
+    if(_binaryRequestHandler)
+      responseLength = std::min(_binaryRequestHandler(_frameBuffer.data(), requestLength, responseFrame + FRAME_HEADER_LENGTH, _maxFrameLength, *this), (size_t)_maxFrameLength);
+
+    writeFrameHeader(responseFrame, FRAME_RESPONSE, responseLength);
+
+    if(currClient.write(responseFrame, FRAME_HEADER_LENGTH + responseLength) != FRAME_HEADER_LENGTH + responseLength)
+      return false;
+    yield();
+  }
+
+  return true;
+}
+
 void ESP8266WiFiMesh::acceptRequest()
 {
   ////////////////////////////<DEPRECATED> TODO: REMOVE IN 2.5.0////////////////////////////
@@ -641,6 +955,31 @@ void ESP8266WiFiMesh::acceptRequest()
   else
   {
   ////////////////////////////</DEPRECATED> TODO: REMOVE IN 2.5.0////////////////////////////
+    /* Serve binary sessions kept open from earlier requests */
+    for(auto session = _serverSessions.begin(); session != _serverSessions.end(); )
+    {
+      uint32_t sessionIdleTime = millis() - session->lastUsed;
+
+      if(session->client.available())
+      {
+        if(serveBinaryFrames(session->client))
+        {
+          session->lastUsed = millis();
+          sessionIdleTime = 0;
+        }
+        else
+          session->client.stop();
+      }
+
+      if(!session->client.connected() || sessionIdleTime >= _sessionTimeoutMs)
+      {
+        session->client.stop();
+        session = _serverSessions.erase(session);
+      }
+      else
+        ++session;
+    }
+
     while (true) {
       WiFiClient _client = _server.available();
       
@@ -651,6 +990,18 @@ void ESP8266WiFiMesh::acceptRequest()
         continue;
       }
 
+      if (_client.peek() == FRAME_MARKER)
+      {
+        verboseModePrint("Responding binary");
+        _client.setNoDelay(true);
+        if(serveBinaryFrames(_client) && _client.connected() && _sessionTimeoutMs > 0 && _serverSessions.size() < _maxAPStations)
+          _serverSessions.push_back(ServerSession{_client, (uint32_t)millis()});
+        else
+          _client.stop();
+
+        continue;
+      }
+
       /* Read in request and pass it to the supplied requestHandler */
       String request = _client.readStringUntil('\r');
       yield();
@@ -669,3 +1020,211 @@ void ESP8266WiFiMesh::acceptRequest()
     }
   }
 }
+
+const std::vector<NeighbourInfo> &ESP8266WiFiMesh::getNeighbours() {return _neighbours;}
+
+const NeighbourInfo *ESP8266WiFiMesh::getNeighbour(const String &nodeID) {return findNeighbour(nodeID);}
+
+NeighbourInfo *ESP8266WiFiMesh::findNeighbour(const String &nodeID)
+{
+  for(NeighbourInfo &neighbour : _neighbours)
+    if(neighbour.nodeID == nodeID)
+      return &neighbour;
+
+  return nullptr;
+}
+
+void ESP8266WiFiMesh::clearNeighbours()
+{
+  _neighbours.clear();
+  _cachedConnectionQueue.clear();
+  _scanCacheValid = false;
+}
+
+void ESP8266WiFiMesh::setNeighbourMaxAge(uint32_t neighbourMaxAgeMs) {_neighbourMaxAgeMs = neighbourMaxAgeMs;}
+uint32_t ESP8266WiFiMesh::getNeighbourMaxAge() {return _neighbourMaxAgeMs;}
+
+void ESP8266WiFiMesh::setScanCacheTimeout(uint32_t scanCacheTimeoutMs) {_scanCacheTimeoutMs = scanCacheTimeoutMs;}
+uint32_t ESP8266WiFiMesh::getScanCacheTimeout() {return _scanCacheTimeoutMs;}
+
+bool ESP8266WiFiMesh::isFresh(const NeighbourInfo &neighbour)
+{
+  uint32_t age = millis() - neighbour.lastSeen;
+  return age < _neighbourMaxAgeMs;
+}
+
+/**
+ * Find the neighbour table entry of a mesh node from its SSID.
+ *
+ * @param add Add an entry for the node if there is none yet, dropping the least recently seen neighbour if the table is full.
+ * @returns: The entry, or nullptr if the SSID does not belong to another node of this mesh or if it is not in the table and add is false.
+ */
+NeighbourInfo *ESP8266WiFiMesh::neighbourFromSSID(const String &SSID, bool add)
+{
+  if(!SSID.startsWith(_meshName) || SSID == _SSID)
+    return nullptr;
+
+  String nodeID = SSID.substring(_meshName.length());
+  if(NeighbourInfo *neighbour = findNeighbour(nodeID))
+    return neighbour;
+
+  if(!add)
+    return nullptr;
+
+  if(_neighbours.size() >= MESH_MAX_NEIGHBOURS)
+  {
+    // Drop the least recently seen neighbour, or the weakest one among those seen in the same scan.
+    auto dropped = _neighbours.begin();
+    for(auto neighbour = _neighbours.begin(); neighbour != _neighbours.end(); ++neighbour)
+    {
+      uint32_t age = millis() - neighbour->lastSeen;
+      uint32_t droppedAge = millis() - dropped->lastSeen;
+      if(age > droppedAge || (age == droppedAge && neighbour->RSSI < dropped->RSSI))
+        dropped = neighbour;
+    }
+    _neighbours.erase(dropped);
+  }
+
+  _neighbours.push_back(NeighbourInfo(nodeID, SSID));
+  return &_neighbours.back();
+}
+
+void ESP8266WiFiMesh::recordTransmission(const String &SSID, transmission_status_t transmissionStatus)
+{
+  // A failed connection means the cached BSSID or channel may be stale, or the node is gone.
+  if(transmissionStatus == TS_CONNECTION_FAILED)
+    _scanCacheValid = false;
+
+  if(NeighbourInfo *neighbour = neighbourFromSSID(SSID, false))
+  {
+    bool success = transmissionStatus == TS_TRANSMISSION_COMPLETE;
+    neighbour->recordTransmission(success);
+    if(success)
+      neighbour->lastSeen = millis();
+  }
+}
+
+/**
+ * Update the neighbour table from the scan results, then let the networkFilter fill the connectionQueue and cache it.
+ */
+void ESP8266WiFiMesh::processScanResults(int networkCount)
+{
+  for(int networkIndex = 0; networkIndex < networkCount; ++networkIndex)
+  {
+    if(NeighbourInfo *neighbour = neighbourFromSSID(WiFi.SSID(networkIndex), true))
+    {
+      memcpy(neighbour->BSSID, WiFi.BSSID(networkIndex), sizeof neighbour->BSSID);
+      neighbour->wifiChannel = WiFi.channel(networkIndex);
+      neighbour->RSSI = WiFi.RSSI(networkIndex);
+      neighbour->lastSeen = millis();
+    }
+  }
+
+  connectionQueue.clear();
+  _networkFilter(networkCount, *this); // Update the connectionQueue.
+
+  // Network indices are only valid until the next scan, so resolve them before caching the queue.
+  for(NetworkInfo &network : connectionQueue)
+  {
+    if(network.SSID.isEmpty() && network.networkIndex >= 0 && network.networkIndex < networkCount)
+    {
+      network.SSID = WiFi.SSID(network.networkIndex);
+      network.wifiChannel = WiFi.channel(network.networkIndex);
+      network.copyBSSID(WiFi.BSSID(network.networkIndex));
+    }
+  }
+
+  _cachedConnectionQueue = connectionQueue;
+  _lastScanTime = millis();
+  _scanCacheValid = networkCount >= 0;
+}
+
+void ESP8266WiFiMesh::refreshNeighbours()
+{
+  if(_refreshScanActive)
+  {
+    int n = WiFi.scanComplete();
+    if(n == WIFI_SCAN_RUNNING)
+      return;
+
+    _refreshScanActive = false;
+    if(n >= 0)
+    {
+      verboseModePrint(F("Neighbours refreshed."));
+      processScanResults(n);
+    }
+    return;
+  }
+
+  uint32_t scanAge = millis() - _lastScanTime;
+  if(_scanCacheTimeoutMs == 0 || (_scanCacheValid && scanAge < _scanCacheTimeoutMs / 2))
+    return;
+
+  #ifdef ENABLE_WIFI_SCAN_OPTIMIZATION
+  int n = WiFi.scanNetworks(true, _scanHidden, _meshWiFiChannel);
+  #else
+  int n = WiFi.scanNetworks(true, _scanHidden);
+  #endif
+  _refreshScanActive = n == WIFI_SCAN_RUNNING;
+}
+
+String ESP8266WiFiMesh::getNeighbourAdvertisement()
+{
+  String advertisement;
+
+  for(const NeighbourInfo &neighbour : _neighbours)
+  {
+    if(isFresh(neighbour))
+    {
+      if(!advertisement.isEmpty())
+        advertisement += ',';
+      advertisement += neighbour.nodeID;
+    }
+  }
+
+  return advertisement;
+}
+
+void ESP8266WiFiMesh::setAdvertisedNeighbours(const String &nodeID, const String &advertisement)
+{
+  NeighbourInfo *neighbour = findNeighbour(nodeID);
+  if(!neighbour)
+    return;
+
+  neighbour->advertisedNeighbours.clear();
+  
+  int start = 0;
+  while(start < (int)advertisement.length())
+  {
+    int end = advertisement.indexOf(',', start);
+    if(end < 0)
+      end = advertisement.length();
+
+    if(end > start)
+      neighbour->advertisedNeighbours.push_back(advertisement.substring(start, end));
+    start = end + 1;
+  }
+
+  neighbour->lastAdvertised = millis();
+}
+
+String ESP8266WiFiMesh::getNextHop(const String &targetNodeID)
+{
+  const NeighbourInfo *target = findNeighbour(targetNodeID);
+  if(target && isFresh(*target))
+    return target->nodeID;
+
+  const NeighbourInfo *nextHop = nullptr;
+
+  for(const NeighbourInfo &neighbour : _neighbours)
+  {
+    if(!isFresh(neighbour) || !neighbour.advertises(targetNodeID))
+      continue;
+
+    if(!nextHop || neighbour.successRate() > nextHop->successRate() || 
+       (neighbour.successRate() == nextHop->successRate() && neighbour.RSSI > nextHop->RSSI))
+      nextHop = &neighbour;
+  }
+
+  return nextHop ? nextHop->nodeID : String();
+}
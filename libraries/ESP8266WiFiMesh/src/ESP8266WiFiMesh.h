@@ -27,12 +27,18 @@
 #include <vector>
 #include "NetworkInfo.h"
 #include "TransmissionResult.h"
+#include "NeighbourInfo.h"
 
 #define ENABLE_STATIC_IP_OPTIMIZATION // Requires Arduino core for ESP8266 version 2.4.2 or higher and lwIP2 (lwIP can be changed in "Tools" menu of Arduino IDE).
 #define ENABLE_WIFI_SCAN_OPTIMIZATION // Requires Arduino core for ESP8266 version 2.4.2 or higher. Scan time should go from about 2100 ms to around 60 ms if channel 1 (standard) is used.
 
 const String WIFI_MESH_EMPTY_STRING = "";
 
+const uint16_t MESH_DEFAULT_MAX_FRAME_LENGTH = 1024;
+const uint32_t MESH_DEFAULT_SESSION_TIMEOUT_MS = 10000;
+const uint32_t MESH_DEFAULT_NEIGHBOUR_MAX_AGE_MS = 60000;
+const uint8_t MESH_MAX_NEIGHBOURS = 16;
+
 class ESP8266WiFiMesh {
 
 private:
@@ -69,6 +75,55 @@ private:
   responseHandlerType _responseHandler;
   networkFilterType _networkFilter;
 
+public:
+  /**
+   * A binary message given to attemptBinaryTransmission. The data is not copied and must stay valid during the call.
+   */
+  struct BinaryMessage
+  {
+    const uint8_t *data;
+    size_t length;
+  };
+
+  /**
+   * Handles one binary request: read requestLength bytes at request and write up to maxResponseLength bytes at response.
+   * Returns the response length, 0 for an empty response.
+   */
+  typedef std::function<size_t(const uint8_t *request, size_t requestLength, uint8_t *response, size_t maxResponseLength, ESP8266WiFiMesh &meshInstance)> binaryRequestHandlerType;
+  typedef std::function<transmission_status_t(const uint8_t *response, size_t responseLength, ESP8266WiFiMesh &meshInstance)> binaryResponseHandlerType;
+
+private:
+  binaryRequestHandlerType _binaryRequestHandler;
+  binaryResponseHandlerType _binaryResponseHandler;
+  const BinaryMessage *_binaryMessages = nullptr; // Only set during attemptBinaryTransmission
+  size_t _binaryMessageCount = 0;
+  uint16_t _maxFrameLength = MESH_DEFAULT_MAX_FRAME_LENGTH;
+  std::vector<uint8_t> _frameBuffer; // Received payload, then response frame
+  uint32_t _sessionTimeoutMs = MESH_DEFAULT_SESSION_TIMEOUT_MS;
+
+  // TCP session kept open to the AP we are connected to
+  WiFiClient _sessionClient;
+  String _sessionSSID;
+  uint32_t _sessionLastUsed = 0;
+
+  // TCP sessions kept open by stations that sent binary frames
+  struct ServerSession
+  {
+    WiFiClient client;
+    uint32_t lastUsed;
+  };
+  std::vector<ServerSession> _serverSessions;
+
+  std::vector<NeighbourInfo> _neighbours;
+  uint32_t _neighbourMaxAgeMs = MESH_DEFAULT_NEIGHBOUR_MAX_AGE_MS;
+
+  // connectionQueue produced by networkFilter after the latest scan, with SSID, channel and BSSID filled in
+  std::vector<NetworkInfo> _cachedConnectionQueue;
+  uint32_t _scanCacheTimeoutMs = 0;
+  uint32_t _lastScanTime = 0;
+  bool _scanCacheValid = false;
+  bool _refreshScanActive = false;
+
   void updateNetworkNames(const String &newMeshName = WIFI_MESH_EMPTY_STRING, const String &newNodeID = WIFI_MESH_EMPTY_STRING);
   void verboseModePrint(const String &stringToPrint, bool newline = true);
   void fullStop(WiFiClient &currClient);
@@ -80,6 +135,16 @@ private:
   transmission_status_t attemptDataTransferKernel();
   void storeLwipVersion();
   bool atLeastLwipVersion(const uint32_t minLwipVersion[3]);
+  IPAddress serverIP();
+  bool allocateFrameBuffer();
+  bool readFrame(WiFiClient &currClient, uint8_t frameType, size_t &length, uint32_t maxWait);
+  transmission_status_t exchangeBinary(WiFiClient &currClient, size_t &responseCount);
+  bool serveBinaryFrames(WiFiClient &currClient);
+  void processScanResults(int networkCount);
+  NeighbourInfo *findNeighbour(const String &nodeID);
+  NeighbourInfo *neighbourFromSSID(const String &SSID, bool add);
+  void recordTransmission(const String &SSID, transmission_status_t transmissionStatus);
+  bool isFresh(const NeighbourInfo &neighbour);
   
   
   
@@ -280,8 +345,29 @@ public:
    */
   void attemptTransmission(const String &message, bool concludingDisconnect = true, bool initialDisconnect = false, bool noScan = false, bool scanAllWiFiChannels = false);
 
+  /**
+   * Send binary messages to other nodes, like attemptTransmission but without String conversions.
+   * Each message is sent as a length-prefixed frame. All messages are written before the responses are read,
+   * and each response frame is passed to the binaryResponseHandler in order.
+   * The TCP session to the node is kept open for getSessionTimeout() ms, so that the next transmission to the same node
+   * needs neither a new AP connection nor a new TCP connection as long as concludingDisconnect is false.
+   *
+   * @param messages The messages to send. Each must be at most getMaxFrameLength() bytes long.
+   * @param messageCount The number of messages.
+   * The other parameters are as for attemptTransmission, except that concludingDisconnect defaults to false.
+   */
+  void attemptBinaryTransmission(const BinaryMessage *messages, size_t messageCount, bool concludingDisconnect = false, bool initialDisconnect = false, bool noScan = false, bool scanAllWiFiChannels = false);
+  void attemptBinaryTransmission(const uint8_t *data, size_t length, bool concludingDisconnect = false, bool initialDisconnect = false, bool noScan = false, bool scanAllWiFiChannels = false);
+
+  /**
+   * Close the TCP sessions kept open for binary transmissions.
+   */
+  void closeSessions();
+
   /**
    * If any clients are connected, accept their requests and call the requestHandler function for each one.
+   * Binary requests are passed to the binaryRequestHandler instead, and their TCP sessions are kept open
+   * until they have been idle for getSessionTimeout() ms.
    */
   void acceptRequest();
 
@@ -307,6 +393,29 @@ public:
   void setNetworkFilter(networkFilterType networkFilter);
   networkFilterType getNetworkFilter();
 
+  void setBinaryRequestHandler(binaryRequestHandlerType binaryRequestHandler);
+  binaryRequestHandlerType getBinaryRequestHandler();
+
+  void setBinaryResponseHandler(binaryResponseHandlerType binaryResponseHandler);
+  binaryResponseHandlerType getBinaryResponseHandler();
+
+  /**
+   * Set the maximum length of a binary message or response. Frames received with a larger length close the connection.
+   * The frame buffer (twice this length) is allocated on first binary use. Default is 1024 bytes.
+   *
+   * @param maxFrameLength The maximum payload length in bytes.
+   */
+  void setMaxFrameLength(uint16_t maxFrameLength);
+  uint16_t getMaxFrameLength();
+
+  /**
+   * Set how long idle binary TCP sessions are kept open, both as station and as AP. Default is 10 000 ms.
+   *
+   * @param sessionTimeoutMs The idle timeout, in milliseconds. 0 closes sessions after each transmission.
+   */
+  void setSessionTimeout(uint32_t sessionTimeoutMs);
+  uint32_t getSessionTimeout();
+
   /**
    * Set whether scan results from this ESP8266WiFiMesh instance will include WiFi networks with hidden SSIDs.
    * This is false by default.
@@ -369,6 +478,74 @@ public:
    */
   void setAPModeTimeout(uint32_t apModeTimeoutMs);
   uint32_t getAPModeTimeout();
+
+  /**
+   * The other nodes of this mesh network found by WiFi scans, with their BSSID, WiFi channel, RSSI, when they were last seen
+   * and their recent transmission success rate. At most MESH_MAX_NEIGHBOURS nodes are kept, the least recently seen is dropped first.
+   * Entries are added, dropped and moved by scans, transmissions and clearNeighbours, so pointers and iterators into the table
+   * are only valid until the next call to attemptTransmission, refreshNeighbours, clearNeighbours or a scan.
+   */
+  const std::vector<NeighbourInfo> &getNeighbours();
+
+  /**
+   * @returns The neighbour with the given node ID, or nullptr if it is not in the neighbour table.
+   * The pointer is into the neighbour table and has the same limited validity as in getNeighbours, copy the entry to keep it longer.
+   */
+  const NeighbourInfo *getNeighbour(const String &nodeID);
+
+  /**
+   * Empty the neighbour table and the scan cache.
+   */
+  void clearNeighbours();
+
+  /**
+   * Set how long a neighbour is considered reachable after it was last seen in a scan or transmission.
+   * Only fresh neighbours are advertised and used as next hops. Default is 60 000 ms.
+   *
+   * @param neighbourMaxAgeMs The maximum age, in milliseconds.
+   */
+  void setNeighbourMaxAge(uint32_t neighbourMaxAgeMs);
+  uint32_t getNeighbourMaxAge();
+
+  /**
+   * Set how long attemptTransmission reuses the connectionQueue from the latest scan instead of scanning again.
+   * The networkFilter is not called for the reused queue. The cache is dropped whenever a connection to one of its networks fails.
+   * Default is 0, which scans on every attemptTransmission call.
+   *
+   * @param scanCacheTimeoutMs The maximum age of the cached scan, in milliseconds.
+   */
+  void setScanCacheTimeout(uint32_t scanCacheTimeoutMs);
+  uint32_t getScanCacheTimeout();
+
+  /**
+   * Call regularly, e.g. from loop(), to keep the neighbour table and the scan cache fresh without blocking.
+   * Starts an asynchronous WiFi scan once the scan cache is half of getScanCacheTimeout() old,
+   * and passes its results to the networkFilter when it completes. Does nothing if the scan cache timeout is 0.
+   */
+  void refreshNeighbours();
+
+  /**
+   * @returns The node IDs of the fresh neighbours of this node, separated by commas.
+   * Include it in messages to other nodes, which can pass it to setAdvertisedNeighbours.
+   */
+  String getNeighbourAdvertisement();
+
+  /**
+   * Store the neighbours advertised by another node, as returned by its getNeighbourAdvertisement method.
+   * Ignored if nodeID is not in the neighbour table.
+   */
+  void setAdvertisedNeighbours(const String &nodeID, const String &advertisement);
+
+  /**
+   * Select the neighbour to send to in order to reach a node.
+   * This is the node itself if it is a fresh neighbour, otherwise the fresh neighbour advertising it
+   * with the best transmission success rate, then the strongest signal.
+   * Put getNeighbour(nextHop)->networkInfo() in the connectionQueue, then call attemptTransmission with noScan set to true.
+   *
+   * @param targetNodeID The node ID of the final destination.
+   * @returns The node ID of the next hop, or an empty String if no route to the node is known.
+   */
+  String getNextHop(const String &targetNodeID);
 };
 
 #endif
@@ -0,0 +1,64 @@
+/*
+ * NeighbourInfo
+ * Copyright (C) 2018 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "NeighbourInfo.h"
+
+NeighbourInfo::NeighbourInfo(const String &newNodeID, const String &newSSID) : nodeID(newNodeID), SSID(newSSID)
+{ }
+
+float NeighbourInfo::successRate() const
+{
+  if(transmissionAttempts == 0)
+    return 0.5;
+
+  return (float)transmissionSuccesses / transmissionAttempts;
+}
+
+void NeighbourInfo::recordTransmission(bool success)
+{
+  if(transmissionAttempts >= 64)
+  {
+    transmissionAttempts /= 2;
+    transmissionSuccesses /= 2;
+  }
+
+  transmissionAttempts++;
+  if(success)
+    transmissionSuccesses++;
+}
+
+bool NeighbourInfo::advertises(const String &targetNodeID) const
+{
+  for(const String &advertisedNeighbour : advertisedNeighbours)
+    if(advertisedNeighbour == targetNodeID)
+      return true;
+
+  return false;
+}
+
+NetworkInfo NeighbourInfo::networkInfo() const
+{
+  return NetworkInfo(SSID, wifiChannel, const_cast<uint8_t *>(BSSID)); // NetworkInfo copies the BSSID
+}
@@ -0,0 +1,75 @@
+/*
+ * NeighbourInfo
+ * Copyright (C) 2018 Anders Löfgren
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __NEIGHBOURINFO_H__
+#define __NEIGHBOURINFO_H__
+
+#include <ESP8266WiFi.h>
+#include <vector>
+#include "NetworkInfo.h"
+
+/**
+ * What an ESP8266WiFiMesh instance knows about another node of its mesh, as seen in WiFi scans and transmissions.
+ */
+class NeighbourInfo {
+
+public:
+
+  String nodeID;
+  String SSID;
+  uint8_t BSSID[6] {0};
+  int wifiChannel = NETWORK_INFO_DEFAULT_INT;
+  int32_t RSSI = 0;
+  uint32_t lastSeen = 0; // millis() of the latest scan that found the node or transmission that reached it
+
+  // Recent transmission attempts and successes. Both are halved once attempts reaches 64, so old outcomes fade out.
+  uint8_t transmissionAttempts = 0;
+  uint8_t transmissionSuccesses = 0;
+
+  // Node IDs the node itself advertised as its neighbours, and when.
+  std::vector<String> advertisedNeighbours;
+  uint32_t lastAdvertised = 0;
+
+  NeighbourInfo(const String &newNodeID, const String &newSSID);
+
+  /**
+   * @returns The share of recent transmissions to this node that completed, from 0 to 1. 0.5 if there was no transmission yet.
+   */
+  float successRate() const;
+
+  void recordTransmission(bool success);
+
+  /**
+   * @returns True if nodeID is one of the advertisedNeighbours.
+   */
+  bool advertises(const String &targetNodeID) const;
+
+  /**
+   * @returns A NetworkInfo with the SSID, channel and BSSID of the node, ready for the connectionQueue.
+   */
+  NetworkInfo networkInfo() const;
+};
+
+#endif
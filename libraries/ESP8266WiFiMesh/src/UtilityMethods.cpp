@@ -47,12 +47,16 @@ void ESP8266WiFiMesh::storeLwipVersion()
   // SDK:2.2.1(cfd48f3)/Core:win-2.5.0-dev/lwIP:2.0.3(STABLE-2_0_3_RELEASE/glue:arduino-2.4.1-10-g0c0d8c2)/BearSSL:94e9704
   String fullVersion = ESP.getFullVersion();
 
-  int i = fullVersion.indexOf("lwIP:") + 5;
+  int lwipIndex = fullVersion.indexOf("lwIP:");
+  if(lwipIndex < 0)
+    return; // Unknown lwIP version, e.g. when emulated on host
+
+  int i = lwipIndex + 5;
   char currentChar = fullVersion.charAt(i);
 
   for(int versionPart = 0; versionPart < 3; versionPart++)
   {
-    while(!isdigit(currentChar))
+    while(currentChar && !isdigit(currentChar))
     {
       currentChar = fullVersion.charAt(++i);
     }
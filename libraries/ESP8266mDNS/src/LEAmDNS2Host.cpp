@@ -186,7 +186,12 @@ clsLEAMDNSHost::clsLEAMDNSHost(void)
     :   m_pUDPContext(0),
         m_pcHostName(0),
         m_pcDefaultInstanceName(0),
-        m_ProbeInformation()
+        m_ProbeInformation(),
+        m_stParseArenaSize(clsConsts::stParseArenaSize),
+        m_u8AnswerCacheSlots(clsConsts::u8AnswerCacheSlots),
+        m_u8ResponseCacheEntries(clsConsts::u8ResponseCacheEntries),
+        m_u32KnownAnswers(0),
+        m_u32RateLimited(0)
 {
 }
 
@@ -197,6 +202,11 @@ clsLEAMDNSHost::clsLEAMDNSHost(void)
 clsLEAMDNSHost::~clsLEAMDNSHost(void)
 {
     close();
+
+    _releaseQueries();
+    m_AnswerCache.release();
+    m_ParseArena.release();
+    m_ResponseCache.release();
 }
 
 /*
@@ -236,6 +246,12 @@ bool clsLEAMDNSHost::begin(const char* p_pcHostName,
         return false;
     }
 
+    if ((m_stParseArenaSize != m_ParseArena.size()) &&
+            (!m_ParseArena.init(m_stParseArenaSize)))
+    {
+        DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s begin: FAILED to alloc parse arena (%u bytes), using heap!\n"), _DH(), m_stParseArenaSize););
+    }
+
     bResult = LwipIntf::stateUpCB([this](netif * nif)
     {
         (void)nif;
@@ -338,6 +354,106 @@ bool clsLEAMDNSHost::setProbeResultCallback(clsLEAMDNSHost::fnProbeResultCallbac
     return true;
 }
 
+/*
+
+    MEMORY
+
+*/
+
+/*
+    clsLEAmDNS2_Host::setParseArenaSize
+
+    Set the size of the arena, which holds the records of one received message.
+    Messages exceeding the arena are processed partly (the remaining records are dropped).
+    Must be called before 'begin'; 0 selects heap allocation.
+
+*/
+bool clsLEAMDNSHost::setParseArenaSize(size_t p_stSize)
+{
+    bool    bResult = (!m_pUDPContext);
+
+    if (bResult)
+    {
+        m_stParseArenaSize = p_stSize;
+    }
+    return bResult;
+}
+
+/*
+    clsLEAmDNS2_Host::setAnswerCacheSlots
+
+    Set the number of preallocated query answer slots (max. 32).
+    If all slots are used, the answer closest to its TTL expiry is evicted for a new one.
+    Must be called while no query answers are stored; 0 selects (unbounded) heap allocation.
+
+*/
+bool clsLEAMDNSHost::setAnswerCacheSlots(uint8_t p_u8Slots)
+{
+    bool    bResult = (p_u8Slots <= clsConsts::u8AnswerCacheMaxSlots) &&
+                      (m_AnswerCache.release());    // Fails, if answers are stored
+
+    if (bResult)
+    {
+        m_u8AnswerCacheSlots = p_u8Slots;           // Allocated with the next answer
+    }
+    return bResult;
+}
+
+/*
+    clsLEAmDNS2_Host::memoryStats
+
+*/
+clsLEAMDNSHost::clsMemoryStats clsLEAMDNSHost::memoryStats(void) const
+{
+    clsMemoryStats  stats;
+
+    stats.m_stArenaSize = m_ParseArena.size();
+    stats.m_stArenaHighWater = m_ParseArena.highWater();
+    stats.m_u32ArenaOverflows = m_ParseArena.overflows();
+    stats.m_u8AnswerSlots = m_AnswerCache.slots();
+    stats.m_u8AnswerSlotsUsed = m_AnswerCache.used();
+    stats.m_u32AnswerEvictions = m_AnswerCache.m_u32Evictions;
+    return stats;
+}
+
+
+/*
+
+    RESPONSES
+
+*/
+
+/*
+    clsLEAmDNS2_Host::setResponseCacheEntries
+
+    Set the number of cached responses. Answers to repeated queries (and repeated
+    announcements) are copied from the cache instead of being built record by record.
+    Each entry takes about 'clsConsts::stResponseCacheBodySize' bytes; the entries are
+    allocated with the first cacheable response. 0 disables the cache.
+
+*/
+bool clsLEAMDNSHost::setResponseCacheEntries(uint8_t p_u8Entries)
+{
+    m_u8ResponseCacheEntries = p_u8Entries;
+    return m_ResponseCache.release();   // Allocated with the next response
+}
+
+/*
+    clsLEAmDNS2_Host::responseStats
+
+*/
+clsLEAMDNSHost::clsResponseStats clsLEAMDNSHost::responseStats(void) const
+{
+    clsResponseStats    stats;
+
+    stats.m_u8CacheEntries = m_ResponseCache.entries();
+    stats.m_u32CacheHits = m_ResponseCache.m_u32Hits;
+    stats.m_u32CacheMisses = m_ResponseCache.m_u32Misses;
+    stats.m_u32KnownAnswers = m_u32KnownAnswers;
+    stats.m_u32RateLimited = m_u32RateLimited;
+    return stats;
+}
+
 /*
     clsLEAmDNS2_Host::probeStatus
 
@@ -1102,6 +1218,7 @@ clsLEAMDNSHost::clsQuery* clsLEAMDNSHost::_allocQuery(clsLEAMDNSHost::clsQuery::
     clsQuery*    pQuery = new clsQuery(p_QueryType);
     if (pQuery)
     {
+        pQuery->m_pAnswerCache = &m_AnswerCache;
         // Link to query list
         m_Queries.push_back(pQuery);
     }
@@ -1320,6 +1437,87 @@ bool clsLEAMDNSHost::_executeQueryCallback(const clsQuery & p_Query,
     return true;
 }
 
+/*
+    clsLEAmDNS2_Host::_allocQueryAnswer
+
+    Takes a slot from the answer cache; if all slots are in use, the answer closest
+    to its TTL expiry is evicted first. Without answer cache, the answer is heap allocated.
+*/
+clsLEAMDNSHost::clsQuery::clsAnswer* clsLEAMDNSHost::_allocQueryAnswer(void)
+{
+    clsQuery::clsAnswer*    pAnswer = 0;
+
+    if ((m_u8AnswerCacheSlots) &&
+            (!m_AnswerCache.slots()) &&
+            (!m_AnswerCache.init(m_u8AnswerCacheSlots)))
+    {
+        DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _allocQueryAnswer: FAILED to alloc %u answer slots, using heap!\n"), _DH(), m_u8AnswerCacheSlots););
+        m_u8AnswerCacheSlots = 0;
+    }
+
+    if (m_AnswerCache.slots())
+    {
+        if ((!m_AnswerCache.full()) ||
+                (_evictQueryAnswer()))
+        {
+            pAnswer = m_AnswerCache.alloc();
+        }
+    }
+    else
+    {
+        pAnswer = new clsQuery::clsAnswer;
+    }
+    return pAnswer;
+}
+
+/*
+    clsLEAmDNS2_Host::_evictQueryAnswer
+
+    Removes the cached answer (of any query), which would be outlasted first.
+    The query callback is called like for a timed-out answer.
+*/
+bool clsLEAMDNSHost::_evictQueryAnswer(void)
+{
+    clsQuery*               pEvictQuery = 0;
+    clsQuery::clsAnswer*    pEvictAnswer = 0;
+    unsigned long           ulEvictExpiresIn = 0;
+
+    for (clsQuery* pQuery : m_Queries)
+    {
+        for (clsQuery::clsAnswer* pAnswer : pQuery->m_Answers)
+        {
+            unsigned long   ulExpiresIn = pAnswer->expiresIn();
+            if ((!pEvictAnswer) ||
+                    (ulExpiresIn < ulEvictExpiresIn))
+            {
+                pEvictQuery = pQuery;
+                pEvictAnswer = pAnswer;
+                ulEvictExpiresIn = ulExpiresIn;
+            }
+        }
+    }
+
+    bool    bResult = false;
+    if (pEvictAnswer)
+    {
+        DEBUG_EX_INFO(
+            DEBUG_OUTPUT.printf_P(PSTR("%s _evictQueryAnswer: Evicting answer (expires in %lu ms) for "), _DH(), ulEvictExpiresIn);
+            _printRRDomain(pEvictQuery->m_Domain);
+            DEBUG_OUTPUT.println();
+        );
+        _executeQueryCallback(*pEvictQuery, *pEvictAnswer,
+                              static_cast<clsQuery::clsAnswer::typeQueryAnswerType>((clsQuery::enuQueryType::Service == pEvictQuery->m_QueryType)
+                                      ? clsQuery::clsAnswer::enuQueryAnswerType::ServiceDomain
+                                      : clsQuery::clsAnswer::enuQueryAnswerType::HostDomain),
+                              false);
+        if ((bResult = pEvictQuery->removeAnswer(pEvictAnswer)))
+        {
+            ++m_AnswerCache.m_u32Evictions;
+        }
+    }
+    return bResult;
+}
+
 
 }   // namespace MDNSImplementation
 
@@ -180,6 +180,15 @@ protected:
 #endif
         static constexpr uint32_t u32SendTimeoutMs              = 50;       // timeout (ms) for a call to `UDPContext->send()` (12ms=1460B@1Mb/s)
 
+        static constexpr size_t     stParseArenaSize            = 4096;     // Default size of the arena holding the records of one received message (0: heap)
+        static constexpr uint8_t    u8AnswerCacheSlots          = 8;        // Default number of preallocated query answer slots (0: heap, unbounded)
+        static constexpr uint8_t    u8AnswerCacheMaxSlots       = 32;       // Slot usage is tracked in a 32 bit mask
+
+        static constexpr uint8_t    u8ResponseCacheEntries      = 4;        // Default number of cached (serialized) responses (0: no caching)
+        static constexpr size_t     stResponseCacheBodySize     = 384;      // Max. size of a cached response body (larger responses are built every time)
+        static constexpr uint32_t   u32MulticastRateLimitMs     = 1000;     // A record is multicast at most once per second on one interface (RFC 6762, 6)
+        static constexpr uint8_t    u8MulticastLogNetIfs        = 2;        // Interfaces tracked per host and service domain (STA and AP)
+
     };
 
     /**
@@ -416,6 +425,32 @@ protected:
         bool clear(bool p_bClearUserdata = false);
     };
 
+    /**
+        clsMulticastLog
+
+        Last multicast times of the records of one host or service domain.
+        RFC 6762, 6: A record is multicast at most once per second on one interface
+        (answers to probes excepted).
+    */
+    class clsMulticastLog
+    {
+    public:
+        clsMulticastLog(void);
+
+        uint32_t recent(const netif* p_pNetIf,
+                        uint32_t p_u32ContentMask) const;
+        bool stamp(const netif* p_pNetIf,
+                   uint32_t p_u32ContentMask);
+        bool clear(void);
+
+    protected:
+        static constexpr uint8_t    u8Records = 8;  // A, PTR_IPv4, PTR_IPv6, AAAA, PTR_TYPE, PTR_NAME, TXT, SRV
+
+        const netif*        m_apNetIfs[clsConsts::u8MulticastLogNetIfs];
+        uint8_t             m_au8Stamped[clsConsts::u8MulticastLogNetIfs];              // Records with a valid time
+        uint32_t            m_au32SentMs[clsConsts::u8MulticastLogNetIfs][u8Records];
+    };
+
 public:
     /**
         clsService
@@ -459,6 +494,7 @@ public:
         clsServiceTxts              m_Txts;
         fnDynamicServiceTxtCallback m_fnTxtCallback;
         clsProbeInformation         m_ProbeInformation;
+        clsMulticastLog             m_MulticastLog;
 
         clsService(void);
         ~clsService(void);
@@ -825,8 +861,7 @@ protected:
     class clsRRAnswerGeneric : public clsRRAnswer
     {
     public:
-        uint16_t            m_u16RDLength;  // Length of variable answer
-        uint8_t*            m_pu8RDData;    // Offset of start of variable answer in packet
+        uint16_t            m_u16RDLength;  // Length of variable answer (content is skipped in the input buffer)
 
         clsRRAnswerGeneric(const clsRRHeader& p_Header,
                            uint32_t p_u32TTL);
@@ -835,6 +870,42 @@ protected:
         bool clear(void);
     };
 
+    /**
+        clsParseArena
+
+        Bump allocator for the records read from one received message.
+        Memory is handed out in order and given back all at once, when the message
+        is processed (or in reverse order, eg. for short-lived temp buffers).
+    */
+    class clsParseArena
+    {
+    public:
+        clsParseArena(void);
+        ~clsParseArena(void);
+
+        bool init(size_t p_stSize);
+        bool release(void);
+
+        void* alloc(size_t p_stSize);
+        bool free(void* p_pMemory);
+        bool owns(const void* p_pMemory) const;
+        bool reset(void);
+
+        size_t size(void) const;
+        size_t highWater(void) const;
+        uint32_t overflows(void) const;
+        bool overflowed(void) const;
+
+    protected:
+        uint8_t*            m_pu8Buffer;
+        size_t              m_stSize;
+        size_t              m_stUsed;       // Bytes used by the current message
+        size_t              m_stLast;       // Offset of the last allocation (for LIFO release)
+        size_t              m_stHighWater;  // Max. bytes used by one message
+        uint32_t            m_u32Overflows; // Messages, that didn't fit into the arena
+        bool                m_bOverflowed;  // Current message didn't fit
+    };
+
 
     /**
         clsSendParameter
@@ -908,6 +979,8 @@ protected:
 public:
     // QUERIES & ANSWERS
 
+    class clsAnswerCache;
+
     /**
         clsQuery
     */
@@ -961,6 +1034,7 @@ public:
                 uint32_t                        m_u32TTL;
                 esp8266::polledTimeout::oneShot m_TTLTimeout;
                 typeTimeoutLevel                m_TimeoutLevel;
+                unsigned long                   m_ulExpiryTime;     // millis() at 100% of the TTL
 
                 clsTTL(void);
                 bool set(uint32_t p_u32TTL);
@@ -972,6 +1046,7 @@ public:
                 bool finalTimeoutLevel(void) const;
 
                 unsigned long timeout(void) const;
+                unsigned long remaining(void) const;
             };
 
             /**
@@ -1019,6 +1094,8 @@ public:
 
             bool clear(void);
 
+            unsigned long expiresIn(void) const;
+
 #ifdef MDNS_IPV4_SUPPORT
             bool releaseIPv4Addresses(void);
             bool addIPv4Address(clsIPAddressWithTTL* p_pIPAddress);
@@ -1135,6 +1212,7 @@ public:
         esp8266::polledTimeout::oneShot m_ResendTimeout;
         bool                            m_bAwaitingAnswers;
         clsAnswer::list                 m_Answers;
+        clsAnswerCache*                 m_pAnswerCache;     // Owner of the answer slots (0: heap)
 
         /**
             list
@@ -1148,6 +1226,7 @@ public:
 
         bool addAnswer(clsAnswer* p_pAnswer);
         bool removeAnswer(clsAnswer* p_pAnswer);
+        bool releaseAnswer(clsAnswer* p_pAnswer);
 
         clsAnswer* findAnswerForServiceDomain(const clsRRDomain& p_ServiceDomain);
         clsAnswer* findAnswerForHostDomain(const clsRRDomain& p_HostDomain);
@@ -1161,6 +1240,127 @@ public:
         clsAnswerAccessor answerAccessor(uint32 p_u32AnswerIndex) const;
     };
 
+    /**
+        clsAnswerCache
+
+        Preallocated slots for query answers. When all slots are in use, the host
+        evicts the answer closest to its TTL expiry to make room for a new one.
+    */
+    class clsAnswerCache
+    {
+    public:
+        clsAnswerCache(void);
+        ~clsAnswerCache(void);
+
+        bool init(uint8_t p_u8Slots);
+        bool release(void);
+
+        clsQuery::clsAnswer* alloc(void);
+        bool free(clsQuery::clsAnswer* p_pAnswer);
+        bool owns(const clsQuery::clsAnswer* p_pAnswer) const;
+
+        uint8_t slots(void) const;
+        uint8_t used(void) const;
+        bool full(void) const;
+
+        uint32_t    m_u32Evictions;
+
+    protected:
+        uint8_t*            m_pu8Slots;
+        uint8_t             m_u8Slots;
+        uint32_t            m_u32UsedMask;
+    };
+
+    /**
+        clsResponseCache
+
+        Serialized bodies (all records behind the message header) of recently sent responses.
+        Domain compression makes records refer to earlier offsets in the message, so complete
+        bodies are cached, not single records. Entries are keyed by a hash over everything a
+        response is built from (interface addresses, host and service domains, port, TXT items,
+        reply masks and flags): changed content leads to a new key and old entries age out.
+    */
+    class clsResponseCache
+    {
+    public:
+        /**
+            clsEntry
+        */
+        class clsEntry
+        {
+        public:
+            const netif*    m_pNetIf;
+            uint32_t        m_u32Key;
+            uint32_t        m_u32LastUse;
+            uint16_t        m_u16ANCount;
+            uint16_t        m_u16NSCount;
+            uint16_t        m_u16ARCount;
+            uint16_t        m_u16Length;        // 0: unused
+            uint8_t         m_au8Body[clsConsts::stResponseCacheBodySize];
+        };
+
+        clsResponseCache(void);
+        ~clsResponseCache(void);
+
+        bool init(uint8_t p_u8Entries);
+        bool release(void);
+
+        const clsEntry* find(const netif* p_pNetIf,
+                             uint32_t p_u32Key);
+
+        bool beginCapture(const netif* p_pNetIf,
+                          uint32_t p_u32Key);
+        bool capture(const unsigned char* p_pcBuffer,
+                     size_t p_stLength);
+        bool endCapture(const clsMsgHeader& p_MsgHeader,
+                        bool p_bCommit);
+
+        uint8_t entries(void) const;
+
+        static constexpr uint32_t   u32HashSeed = 2166136261UL; // FNV-1a offset basis
+
+        static uint32_t hash(uint32_t p_u32Hash,
+                             const void* p_pData,
+                             size_t p_stLength);
+        static uint32_t hash(uint32_t p_u32Hash,
+                             const char* p_pcString);
+
+        uint32_t    m_u32Hits;
+        uint32_t    m_u32Misses;
+
+    protected:
+        clsEntry*           m_pEntries;
+        uint8_t             m_u8Entries;
+        uint32_t            m_u32UseCounter;
+        clsEntry*           m_pCapture;         // Entry filled by '_udpAppendBuffer' while a response is built
+        size_t              m_stCaptured;
+    };
+
+    /**
+        clsResponseStats
+    */
+    struct clsResponseStats
+    {
+        uint8_t     m_u8CacheEntries;       // Cached responses (0: responses are built every time)
+        uint32_t    m_u32CacheHits;         // Responses sent from the cache
+        uint32_t    m_u32CacheMisses;       // Cacheable responses, that had to be built
+        uint32_t    m_u32KnownAnswers;      // Records not sent, as the querier listed them as known answers
+        uint32_t    m_u32RateLimited;       // Records not sent, as they were multicast less than a second ago
+    };
+
+    /**
+        clsMemoryStats
+    */
+    struct clsMemoryStats
+    {
+        size_t      m_stArenaSize;          // Parse arena size (0: records are heap allocated)
+        size_t      m_stArenaHighWater;     // Max. arena usage by one received message
+        uint32_t    m_u32ArenaOverflows;    // Received messages, that were only partly processed
+        uint8_t     m_u8AnswerSlots;        // Preallocated query answer slots (0: heap allocated)
+        uint8_t     m_u8AnswerSlotsUsed;
+        uint32_t    m_u32AnswerEvictions;   // Answers dropped before their TTL expired
+    };
+
 public:
     static const char* indexDomainName(const char* p_pcDomainName,
                                        const char* p_pcDivider = "-",
@@ -1190,6 +1390,19 @@ public:
     // Returns 'true' is host domain probing is done
     bool probeStatus(void) const;
 
+    // MEMORY
+    // Set the size of the parse arena (bytes) and the number of query answer slots.
+    // Both are allocated once (in 'begin' and with the first query); set them before.
+    // A size of 0 selects (unbounded) heap allocation
+    bool setParseArenaSize(size_t p_stSize);
+    bool setAnswerCacheSlots(uint8_t p_u8Slots);
+    clsMemoryStats memoryStats(void) const;
+
+    // RESPONSES
+    // Set the number of cached responses; 0 disables the cache
+    bool setResponseCacheEntries(uint8_t p_u8Entries);
+    clsResponseStats responseStats(void) const;
+
     // SERVICE
     bool setDefaultInstanceName(const char* p_pcInstanceName);
     const char* defaultInstanceName(void) const;
@@ -1344,6 +1557,8 @@ protected:
                                const clsQuery::clsAnswer& p_Answer,
                                clsQuery::clsAnswer::typeQueryAnswerType p_QueryAnswerTypeFlags,
                                bool p_SetContent);
+    clsQuery::clsAnswer* _allocQueryAnswer(void);
+    bool _evictQueryAnswer(void);
 
 
     // File: ..._Host_Control
@@ -1393,6 +1608,10 @@ protected:
     uint32_t _replyMaskForService(const clsRRHeader& p_RRHeader,
                                   clsService& p_rService,
                                   bool* p_pbFullNameMatch = 0);
+    uint32_t _suppressRecentMulticasts(netif* pNetIf,
+                                       clsSendParameter& p_rSendParameter);
+    bool _stampMulticasts(netif* pNetIf,
+                          const clsSendParameter& p_SendParameter);
 
 
     // File: ..._Host_Transfer
@@ -1403,6 +1622,8 @@ protected:
                                 clsSendParameter& p_rSendParameter,
                                 uint8_t p_IPProtocolTypes);
     bool _prepareMessage(netif* pNetIf, clsSendParameter& p_SendParameter);
+    uint32_t _responseCacheKey(netif* pNetIf,
+                               const clsSendParameter& p_SendParameter) const;
     bool _addQueryRecord(clsSendParameter& p_rSendParameter,
                          const clsRRDomain& p_QueryDomain,
                          uint16_t p_u16QueryType);
@@ -1417,6 +1638,10 @@ protected:
 
     // RESOURCE RECORD
     bool _readRRQuestion(clsRRQuestion& p_rQuestion);
+    template<class T>
+    T* _newRRAnswer(const clsRRHeader& p_Header,
+                    uint32_t p_u32TTL);
+    bool _releaseRRAnswer(clsRRAnswer* p_pAnswer);
     bool _readRRAnswer(clsRRAnswer*& p_rpAnswer);
 #ifdef MDNS_IPV4_SUPPORT
     bool _readRRAnswerA(clsRRAnswerA& p_rRRAnswerA,
@@ -1569,6 +1794,16 @@ protected:
     clsService::list            m_Services;
     clsQuery::list              m_Queries;
     clsProbeInformation         m_ProbeInformation;
+
+    size_t                      m_stParseArenaSize;
+    clsParseArena               m_ParseArena;
+    uint8_t                     m_u8AnswerCacheSlots;
+    clsAnswerCache              m_AnswerCache;
+    uint8_t                     m_u8ResponseCacheEntries;
+    clsResponseCache            m_ResponseCache;
+    clsMulticastLog             m_MulticastLog;
+    uint32_t                    m_u32KnownAnswers;
+    uint32_t                    m_u32RateLimited;
 };
 
 
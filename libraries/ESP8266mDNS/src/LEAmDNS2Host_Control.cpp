@@ -97,6 +97,8 @@ bool clsLEAMDNSHost::_parseMessage()
         DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _parseMessage: FAILED to read header\n"), _DH()););
         m_pUDPContext->flush();
     }
+    // All records of the message are processed -> give back the parse arena
+    m_ParseArena.reset();
     DEBUG_EX_INFO(
         unsigned    uFreeHeap = ESP.getFreeHeap();
         DEBUG_OUTPUT.printf_P(PSTR("%s _parseMessage: Done (%s after %lu ms, ate %i bytes, remaining %u)\n\n"), _DH(), (bResult ? "Succeeded" : "FAILED"), (millis() - ulStartTime), (uStartMemory - uFreeHeap), uFreeHeap);
@@ -281,67 +283,49 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
                 if ((DNS_RRTYPE_ANY != pKnownRRAnswer->m_Header.m_Attributes.m_u16Type) &&                  // No ANY type answer
                         (DNS_RRCLASS_ANY != (pKnownRRAnswer->m_Header.m_Attributes.m_u16Class & (~0x8000))))    // No ANY class answer
                 {
-                    /*  - RFC6762 7.1 Suppression only for 'Shared Records' -
-                        // Find match between planned answer (sendParameter.m_u8HostReplyMask) and this 'known answer'
-                        uint32_t u32HostMatchMask = (sendParameter.m_u32HostReplyMask & _replyMaskForHost(pNetIf, pKnownRRAnswer->m_Header));
-                        if ((u32HostMatchMask) &&                                           // The RR in the known answer matches an RR we are planning to send, AND
-                        ((Consts::u32HostTTL / 2) <= pKnownRRAnswer->m_u32TTL))              // The TTL of the known answer is longer than half of the new host TTL (120s)
-                        {
-
+                    // Check known host answers (RFC 6762, 7.1)
+                    // Find match between planned answer (sendParameter.m_u32HostReplyMask) and this 'known answer'
+                    uint32_t u32HostMatchMask = (sendParameter.m_u32HostReplyMask & _replyMaskForHost(pNetIf, pKnownRRAnswer->m_Header));
+                    if ((u32HostMatchMask) &&                                               // The RR in the known answer matches an RR we are planning to send, AND
+                            ((clsConsts::u32HostTTL / 2) <= pKnownRRAnswer->m_u32TTL))      // The TTL of the known answer is longer than half of the new host TTL (120s)
+                    {
                         // Compare contents
+                        uint32_t    u32KnownMask = 0;
                         if (enuAnswerType::PTR == pKnownRRAnswer->answerType())
                         {
-                            stcRRDomain    hostDomain;
+                            clsRRDomain    hostDomain;
                             if ((_buildDomainForHost(m_pcHostName, hostDomain)) &&
-                                (((stcRRAnswerPTR*)pKnownRRAnswer)->m_PTRDomain == hostDomain))
+                                    (((clsRRAnswerPTR*)pKnownRRAnswer)->m_PTRDomain == hostDomain))
                             {
-                                // Host domain match
-                        #ifdef MDNS_IPV4_SUPPORT
-                                if (u32HostMatchMask & static_cast<uint32_t>(enuContentFlag::PTR_IPv4))
-                                {
-                                    // IPv4 PTR was asked for, but is already known -> skipping
-                                    DEBUG_EX_INFO2(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: IPv4 PTR already known (TTL:%u)... skipping!\n"), _DH(), pKnownRRAnswer->m_u32TTL););
-                                    sendParameter.m_u32HostReplyMask &= ~static_cast<uint32_t>(enuContentFlag::PTR_IPv4);
-                                }
-                        #endif
-                        #ifdef MDNS2_IPV6_SUPPORT
-                                if (u32HostMatchMask & static_cast<uint32_t>(enuContentFlag::PTR_IPv6))
-                                {
-                                    // IPv6 PTR was asked for, but is already known -> skipping
-                                    DEBUG_EX_INFO2(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: IPv6 PTR already known (TTL:%u)... skipping!\n"), _DH(), pKnownRRAnswer->m_u32TTL););
-                                    sendParameter.m_u32HostReplyMask &= ~static_cast<uint32_t>(enuContentFlag::PTR_IPv6);
-                                }
-                        #endif
+                                // Host domain match; IPv4 or IPv6 PTR was asked for, but is already known
+                                u32KnownMask = (u32HostMatchMask & (static_cast<uint32_t>(enuContentFlag::PTR_IPv4) | static_cast<uint32_t>(enuContentFlag::PTR_IPv6)));
                             }
                         }
-                        else if (u32HostMatchMask & static_cast<uint32_t>(enuContentFlag::A))
+#ifdef MDNS_IPV4_SUPPORT
+                        else if ((enuAnswerType::A == pKnownRRAnswer->answerType()) &&
+                                 (u32HostMatchMask & static_cast<uint32_t>(enuContentFlag::A)) &&
+                                 (((clsRRAnswerA*)pKnownRRAnswer)->m_IPAddress == _getResponderIPAddress(pNetIf, enuIPProtocolType::V4)))
                         {
-                            // IPv4 address was asked for
-                        #ifdef MDNS_IPV4_SUPPORT
-                            if ((enuAnswerType::A == pKnownRRAnswer->answerType()) &&
-                                (((stcRRAnswerA*)pKnownRRAnswer)->m_IPAddress == _getResponderIPAddress(pNetIf, enuIPProtocolType::V4)))
-                            {
-
-                                DEBUG_EX_INFO2(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: IPv4 address already known (TTL:%u)... skipping!\n"), _DH(), pKnownRRAnswer->m_u32TTL););
-                                sendParameter.m_u32HostReplyMask &= ~static_cast<uint32_t>(enuContentFlag::A);
-                            }   // else: RData NOT IPv4 length !!
-                        #endif
+                            // IPv4 address was asked for, but is already known
+                            u32KnownMask = static_cast<uint32_t>(enuContentFlag::A);
                         }
-                        else if (u32HostMatchMask & static_cast<uint32_t>(enuContentFlag::AAAA))
+#endif
+#ifdef MDNS2_IPV6_SUPPORT
+                        else if ((enuAnswerType::AAAA == pKnownRRAnswer->answerType()) &&
+                                 (u32HostMatchMask & static_cast<uint32_t>(enuContentFlag::AAAA)) &&
+                                 (((clsRRAnswerAAAA*)pKnownRRAnswer)->m_IPAddress == _getResponderIPAddress(pNetIf, enuIPProtocolType::V6)))
                         {
-                            // IPv6 address was asked for
-                        #ifdef MDNS2_IPV6_SUPPORT
-                            if ((enuAnswerType::AAAA == pKnownRRAnswer->answerType()) &&
-                                (((stcRRAnswerAAAA*)pKnownRRAnswer)->m_IPAddress == _getResponderIPAddress(pNetIf, enuIPProtocolType::V6)))
-                            {
-
-                                DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: IPv6 address already known... skipping!\n"), _DH()););
-                                sendParameter.m_u32HostReplyMask &= ~static_cast<uint32_t>(enuContentFlag::AAAA);
-                            }   // else: RData NOT IPv6 length !!
-                        #endif
+                            // IPv6 address was asked for, but is already known
+                            u32KnownMask = static_cast<uint32_t>(enuContentFlag::AAAA);
+                        }
+#endif
+                        if (u32KnownMask)
+                        {
+                            DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Host answer(s) %s already known (TTL:%u)... skipping!\n"), _DH(), _replyFlags2String(u32KnownMask), pKnownRRAnswer->m_u32TTL););
+                            sendParameter.m_u32HostReplyMask &= ~u32KnownMask;
+                            m_u32KnownAnswers += __builtin_popcount(u32KnownMask);
                         }
-                        }   // Host match and TTL
-                    */
+                    }   // Host match and TTL
 
                     //
                     // Check host tiebreak possibility
@@ -420,10 +404,13 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
 
                         uint32_t    u32ServiceMatchMask = (pService->m_u32ReplyMask & _replyMaskForService(pKnownRRAnswer->m_Header, *pService));
 
-                        if ((u32ServiceMatchMask) &&                                // The RR in the known answer matches an RR we are planning to send, AND
-                                ((clsConsts::u32ServiceTTL / 2) <= pKnownRRAnswer->m_u32TTL))   // The TTL of the known answer is longer than half of the new service TTL (4500s)
+                        // Check known service answers (RFC 6762, 7.1)
+                        // The TTL of the known answer must be longer than half of the new TTL (SRV: host TTL 120s, others: service TTL 4500s)
+                        if (u32ServiceMatchMask)                                    // The RR in the known answer matches an RR we are planning to send
                         {
-                            if (enuAnswerType::PTR == pKnownRRAnswer->answerType())
+                            uint32_t    u32KnownMask = 0;
+                            if ((enuAnswerType::PTR == pKnownRRAnswer->answerType()) &&
+                                    ((clsConsts::u32ServiceTTL / 2) <= pKnownRRAnswer->m_u32TTL))
                             {
                                 clsRRDomain    serviceDomain;
                                 if ((u32ServiceMatchMask & static_cast<uint32_t>(enuContentFlag::PTR_TYPE)) &&
@@ -431,48 +418,46 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
                                         (serviceDomain == ((clsRRAnswerPTR*)pKnownRRAnswer)->m_PTRDomain))
                                 {
                                     DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Service type PTR already known (TTL:%u)... skipping!\n"), _DH(pService), pKnownRRAnswer->m_u32TTL););
-                                    pService->m_u32ReplyMask &= ~static_cast<uint32_t>(enuContentFlag::PTR_TYPE);
+                                    u32KnownMask |= static_cast<uint32_t>(enuContentFlag::PTR_TYPE);
                                 }
                                 if ((u32ServiceMatchMask & static_cast<uint32_t>(enuContentFlag::PTR_NAME)) &&
                                         (_buildDomainForService(*pService, true, serviceDomain)) &&
                                         (serviceDomain == ((clsRRAnswerPTR*)pKnownRRAnswer)->m_PTRDomain))
                                 {
                                     DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Service name PTR already known (TTL:%u)... skipping!\n"), _DH(pService), pKnownRRAnswer->m_u32TTL););
-                                    pService->m_u32ReplyMask &= ~static_cast<uint32_t>(enuContentFlag::PTR_NAME);
+                                    u32KnownMask |= static_cast<uint32_t>(enuContentFlag::PTR_NAME);
                                 }
                             }
-                            /*  - RFC6762 7.1 Suppression only for 'Shared Records'
-                                else if (u32ServiceMatchMask & static_cast<uint32_t>(enuContentFlag::SRV))
-                                {
-                                DEBUG_EX_ERR(if (enuAnswerType::SRV != pKnownRRAnswer->answerType()) DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: ERROR! INVALID answer type (SRV)!\n"), _DH(pService)););
-                                stcRRDomain    hostDomain;
+                            else if ((enuAnswerType::SRV == pKnownRRAnswer->answerType()) &&
+                                     (u32ServiceMatchMask & static_cast<uint32_t>(enuContentFlag::SRV)) &&
+                                     ((clsConsts::u32HostTTL / 2) <= pKnownRRAnswer->m_u32TTL))
+                            {
+                                clsRRDomain    hostDomain;
                                 if ((_buildDomainForHost(m_pcHostName, hostDomain)) &&
-                                    (hostDomain == ((stcRRAnswerSRV*)pKnownRRAnswer)->m_SRVDomain))    // Host domain match
-                                {
-
-                                    if ((Consts::u16SRVPriority == ((stcRRAnswerSRV*)pKnownRRAnswer)->m_u16Priority) &&
-                                        (Consts::u16SRVWeight == ((stcRRAnswerSRV*)pKnownRRAnswer)->m_u16Weight) &&
-                                        (pService->m_u16Port == ((stcRRAnswerSRV*)pKnownRRAnswer)->m_u16Port))
-                                    {
-
-                                        DEBUG_EX_INFO2(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Service SRV answer already known (TTL:%u)... skipping!\n"), _DH(pService), pKnownRRAnswer->m_u32TTL););
-                                        pService->m_u32ReplyMask &= ~static_cast<uint32_t>(enuContentFlag::SRV);
-                                    }   // else: Small differences -> send update message
-                                }
-                                }*/
-                            /*  - RFC6762 7.1 Suppression only for 'Shared Records'
-                                else if (u32ServiceMatchMask & static_cast<uint32_t>(enuContentFlag::TXT))
+                                        (hostDomain == ((clsRRAnswerSRV*)pKnownRRAnswer)->m_SRVDomain) &&      // Host domain match
+                                        (clsConsts::u16SRVPriority == ((clsRRAnswerSRV*)pKnownRRAnswer)->m_u16Priority) &&
+                                        (clsConsts::u16SRVWeight == ((clsRRAnswerSRV*)pKnownRRAnswer)->m_u16Weight) &&
+                                        (pService->m_u16Port == ((clsRRAnswerSRV*)pKnownRRAnswer)->m_u16Port))
                                 {
-                                DEBUG_EX_ERR(if (enuAnswerType::TXT != pKnownRRAnswer->answerType()) DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: ERROR! INVALID answer type (TXT)!\n"), _DH(pService)););
+                                    DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Service SRV answer already known (TTL:%u)... skipping!\n"), _DH(pService), pKnownRRAnswer->m_u32TTL););
+                                    u32KnownMask |= static_cast<uint32_t>(enuContentFlag::SRV);
+                                }   // else: Small differences -> send update message
+                            }
+                            else if ((enuAnswerType::TXT == pKnownRRAnswer->answerType()) &&
+                                     (u32ServiceMatchMask & static_cast<uint32_t>(enuContentFlag::TXT)) &&
+                                     ((clsConsts::u32ServiceTTL / 2) <= pKnownRRAnswer->m_u32TTL))
+                            {
                                 _collectServiceTxts(*pService);
-                                if (pService->m_Txts == ((stcRRAnswerTXT*)pKnownRRAnswer)->m_Txts)
+                                if (pService->m_Txts == ((clsRRAnswerTXT*)pKnownRRAnswer)->m_Txts)
                                 {
-                                    DEBUG_EX_INFO2(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Service TXT answer already known (TTL:%u)... skipping!\n"), _DH(pService), pKnownRRAnswer->m_u32TTL););
-                                    pService->m_u32ReplyMask &= ~static_cast<uint32_t>(enuContentFlag::TXT);
+                                    DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: Service TXT answer already known (TTL:%u)... skipping!\n"), _DH(pService), pKnownRRAnswer->m_u32TTL););
+                                    u32KnownMask |= static_cast<uint32_t>(enuContentFlag::TXT);
                                 }
                                 _releaseTempServiceTxts(*pService);
-                                }*/
-                        }   // Service match and enough TTL
+                            }
+                            pService->m_u32ReplyMask &= ~u32KnownMask;
+                            m_u32KnownAnswers += __builtin_popcount(u32KnownMask);
+                        }   // Service match
 
                         //
                         // Check service tiebreak possibility
@@ -522,7 +507,7 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
 
             if (pKnownRRAnswer)
             {
-                delete pKnownRRAnswer;
+                _releaseRRAnswer(pKnownRRAnswer);
                 pKnownRRAnswer = 0;
             }
         }   // for answers
@@ -535,6 +520,14 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
 
     if (bResult)
     {
+        // Multicast responses: Skip records, that were just multicast (RFC 6762, 6)
+        // BUT answer probe queries (with proposed records in the authority section) in any case
+        if ((!sendParameter.m_bUnicast) &&
+                (!p_MsgHeader.m_u16NSCount))
+        {
+            _suppressRecentMulticasts(pNetIf, sendParameter);
+        }
+
         // Check, if a reply is needed
         uint32_t    u32ReplyNeeded = sendParameter.m_u32HostReplyMask;
         for (const clsService* pService : m_Services)
@@ -550,7 +543,11 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
             sendParameter.m_Response = clsSendParameter::enuResponseType::Response;
             sendParameter.m_bAuthorative = true;
 
-            bResult = _sendMessage(pNetIf, sendParameter);
+            if (((bResult = _sendMessage(pNetIf, sendParameter))) &&
+                    (!sendParameter.m_bUnicast))
+            {
+                _stampMulticasts(pNetIf, sendParameter);
+            }
         }
         DEBUG_EX_INFO(else
         {
@@ -577,6 +574,8 @@ bool clsLEAMDNSHost::_parseQuery(netif* pNetIf,
             DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: UNSOLVED tiebreak-need for service domain '%s')\n"), _DH(), _service2String(pService)););
             pService->m_ProbeInformation.m_bTiebreakNeeded = false;
         }
+        // Clear the reply mask for the next query
+        pService->m_u32ReplyMask = 0;
     }
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _parseQuery: FAILED!\n"), _DH()););
     return bResult;
@@ -651,12 +650,20 @@ bool clsLEAMDNSHost::_parseResponse(netif* pNetIf, const clsLEAMDNSHost::clsMsgH
             }
             else
             {
-                DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _parseResponse: FAILED to read answer!\n"), _DH()););
                 if (pRRAnswer)
                 {
-                    delete pRRAnswer;
+                    _releaseRRAnswer(pRRAnswer);
                     pRRAnswer = 0;
                 }
+                if (m_ParseArena.overflowed())
+                {
+                    // Parse arena exhausted: process the answers read so far and drop the rest
+                    DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _parseResponse: Parse arena exhausted after %u answers, dropping %u!\n"), _DH(), an, (u32NumberOfAnswerRRs - an)););
+                    m_pUDPContext->flush();
+                    bResult = true;
+                    break;
+                }
+                DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _parseResponse: FAILED to read answer!\n"), _DH()););
                 bResult = false;
             }
         }   // for answers
@@ -679,7 +686,7 @@ bool clsLEAMDNSHost::_parseResponse(netif* pNetIf, const clsLEAMDNSHost::clsMsgH
         {
             //DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("%s _parseResponse: DELETING answer!\n"), _DH()););
             clsRRAnswer*   pNextAnswer = pCollectedRRAnswers->m_pNext;
-            delete pCollectedRRAnswers;
+            _releaseRRAnswer(pCollectedRRAnswers);
             pCollectedRRAnswers = pNextAnswer;
         }
     }
@@ -895,7 +902,7 @@ bool clsLEAMDNSHost::_processPTRAnswer(const clsLEAMDNSHost::clsRRAnswerPTR* p_p
                     }
                 }
                 else if ((p_pPTRAnswer->m_u32TTL) &&                        // Not just a goodbye-message
-                         ((pSQAnswer = new clsQuery::clsAnswer)))           // Not yet included -> add answer
+                         ((pSQAnswer = _allocQueryAnswer())))           // Not yet included -> add answer
                 {
                     pSQAnswer->m_ServiceDomain = p_pPTRAnswer->m_PTRDomain;
                     pSQAnswer->m_QueryAnswerFlags |= static_cast<clsQuery::clsAnswer::typeQueryAnswerType>(clsQuery::clsAnswer::enuQueryAnswerType::ServiceDomain);
@@ -1077,7 +1084,7 @@ bool clsLEAMDNSHost::_processAAnswer(const clsLEAMDNSHost::clsRRAnswerA* p_pAAns
                 {
                     clsQuery::clsAnswer* pSQAnswer = pQuery->findAnswerForHostDomain(p_pAAnswer->m_Header.m_Domain);
                     if ((!pSQAnswer) &&
-                            ((pSQAnswer = new clsQuery::clsAnswer)))
+                            ((pSQAnswer = _allocQueryAnswer())))
                     {
                         // Add not yet included answer
                         pSQAnswer->m_HostDomain = p_pAAnswer->m_Header.m_Domain;
@@ -1183,7 +1190,7 @@ bool clsLEAMDNSHost::_processAAAAAnswer(const clsLEAMDNSHost::clsRRAnswerAAAA* p
                 {
                     clsQuery::clsAnswer* pSQAnswer = pQuery->findAnswerForHostDomain(p_pAAAAAnswer->m_Header.m_Domain);
                     if ((!pSQAnswer) &&
-                            ((pSQAnswer = new clsQuery::clsAnswer)))
+                            ((pSQAnswer = _allocQueryAnswer())))
                     {
                         // Add not yet included answer
                         pSQAnswer->m_HostDomain = p_pAAAAAnswer->m_Header.m_Domain;
@@ -2209,6 +2216,59 @@ uint32_t clsLEAMDNSHost::_replyMaskForService(const clsLEAMDNSHost::clsRRHeader&
     return u32ReplyMask;
 }
 
+/*
+    clsLEAmDNS2_Host::_suppressRecentMulticasts
+
+    RFC 6762, 6: A record is not multicast on an interface, if it was multicast there
+    less than a second ago. Those records are removed from the host and service reply masks.
+    Returns the number of removed records.
+
+*/
+uint32_t clsLEAMDNSHost::_suppressRecentMulticasts(netif* pNetIf,
+        clsLEAMDNSHost::clsSendParameter& p_rSendParameter)
+{
+    uint32_t    u32Recent = m_MulticastLog.recent(pNetIf, p_rSendParameter.m_u32HostReplyMask);
+    uint32_t    u32Suppressed = __builtin_popcount(u32Recent);
+
+    DEBUG_EX_INFO(if (u32Recent) DEBUG_OUTPUT.printf_P(PSTR("%s _suppressRecentMulticasts: Host answer(s) %s were just multicast... skipping!\n"), _DH(), _replyFlags2String(u32Recent)););
+    p_rSendParameter.m_u32HostReplyMask &= ~u32Recent;
+    for (clsService* pService : m_Services)
+    {
+        if (pService->m_u32ReplyMask)
+        {
+            u32Recent = pService->m_MulticastLog.recent(pNetIf, pService->m_u32ReplyMask);
+            DEBUG_EX_INFO(if (u32Recent) DEBUG_OUTPUT.printf_P(PSTR("%s _suppressRecentMulticasts: Service answer(s) %s were just multicast... skipping!\n"), _DH(pService), _replyFlags2String(u32Recent)););
+            pService->m_u32ReplyMask &= ~u32Recent;
+            u32Suppressed += __builtin_popcount(u32Recent);
+        }
+    }
+    m_u32RateLimited += u32Suppressed;
+    return u32Suppressed;
+}
+
+/*
+    clsLEAmDNS2_Host::_stampMulticasts
+
+    Logs the multicast of the records in the host and service reply masks.
+
+*/
+bool clsLEAMDNSHost::_stampMulticasts(netif* pNetIf,
+                                      const clsLEAMDNSHost::clsSendParameter& p_SendParameter)
+{
+    if (p_SendParameter.m_u32HostReplyMask)
+    {
+        m_MulticastLog.stamp(pNetIf, p_SendParameter.m_u32HostReplyMask);
+    }
+    for (clsService* pService : m_Services)
+    {
+        if (pService->m_u32ReplyMask)
+        {
+            pService->m_MulticastLog.stamp(pNetIf, pService->m_u32ReplyMask);
+        }
+    }
+    return true;
+}
+
 
 } // namespace MDNSImplementation
 
@@ -23,6 +23,8 @@
 */
 
 #include <algorithm>
+#include <cstddef>
+#include <new>
 
 #include "ESP8266mDNS.h"
 #include "LEAmDNS2Host.h"
@@ -776,6 +778,120 @@ bool clsLEAMDNSHost::clsService::clsProbeInformation::clear(bool p_bClearUserdat
 }
 
 
+/**
+    clsLEAMDNSHost::clsMulticastLog
+
+    Last multicast times of the host or service domain records (one bit per record
+    in the content flags) for the interfaces the records were sent on.
+
+*/
+
+/*
+    clsLEAMDNSHost::clsMulticastLog::clsMulticastLog constructor
+
+*/
+clsLEAMDNSHost::clsMulticastLog::clsMulticastLog(void)
+{
+    clear();
+}
+
+/*
+    clsLEAMDNSHost::clsMulticastLog::recent
+
+    Returns the records of 'p_u32ContentMask', that were multicast on the given
+    interface within the last second.
+
+*/
+uint32_t clsLEAMDNSHost::clsMulticastLog::recent(const netif* p_pNetIf,
+        uint32_t p_u32ContentMask) const
+{
+    uint32_t    u32Recent = 0;
+
+    for (uint8_t u8NetIf = 0; u8NetIf < clsConsts::u8MulticastLogNetIfs; ++u8NetIf)
+    {
+        if (p_pNetIf == m_apNetIfs[u8NetIf])
+        {
+            uint32_t    u32Now = millis();
+            uint32_t    u32Records = (p_u32ContentMask & m_au8Stamped[u8NetIf]);
+            while (u32Records)
+            {
+                uint8_t u8Record = __builtin_ctz(u32Records);
+                u32Records &= (u32Records - 1);
+                if ((u32Now - m_au32SentMs[u8NetIf][u8Record]) < clsConsts::u32MulticastRateLimitMs)
+                {
+                    u32Recent |= (1UL << u8Record);
+                }
+            }
+            break;
+        }
+    }
+    return u32Recent;
+}
+
+/*
+    clsLEAMDNSHost::clsMulticastLog::stamp
+
+    Records the multicast of the records in 'p_u32ContentMask'. An unknown interface
+    takes a free log slot or the one, that wasn't stamped for the longest time.
+
+*/
+bool clsLEAMDNSHost::clsMulticastLog::stamp(const netif* p_pNetIf,
+        uint32_t p_u32ContentMask)
+{
+    uint32_t    u32Now = millis();
+    uint8_t     u8Slot = 0;
+    uint32_t    u32SlotAge = 0;
+
+    for (uint8_t u8NetIf = 0; u8NetIf < clsConsts::u8MulticastLogNetIfs; ++u8NetIf)
+    {
+        if (p_pNetIf == m_apNetIfs[u8NetIf])
+        {
+            u8Slot = u8NetIf;
+            break;
+        }
+        // Age of the slot: time since its last stamp (free slots are the oldest)
+        uint32_t    u32Age = UINT32_MAX;
+        for (uint8_t u8Record = 0; u8Record < u8Records; ++u8Record)
+        {
+            if (m_au8Stamped[u8NetIf] & (1 << u8Record))
+            {
+                u32Age = std::min(u32Age, (u32Now - m_au32SentMs[u8NetIf][u8Record]));
+            }
+        }
+        if (u32Age > u32SlotAge)
+        {
+            u8Slot = u8NetIf;
+            u32SlotAge = u32Age;
+        }
+    }
+    if (p_pNetIf != m_apNetIfs[u8Slot])
+    {
+        m_apNetIfs[u8Slot] = p_pNetIf;
+        m_au8Stamped[u8Slot] = 0;
+    }
+
+    uint32_t    u32Records = (p_u32ContentMask & ((1UL << u8Records) - 1));
+    m_au8Stamped[u8Slot] |= u32Records;
+    while (u32Records)
+    {
+        m_au32SentMs[u8Slot][__builtin_ctz(u32Records)] = u32Now;
+        u32Records &= (u32Records - 1);
+    }
+    return true;
+}
+
+/*
+    clsLEAMDNSHost::clsMulticastLog::clear
+
+*/
+bool clsLEAMDNSHost::clsMulticastLog::clear(void)
+{
+    memset(m_apNetIfs, 0, sizeof(m_apNetIfs));
+    memset(m_au8Stamped, 0, sizeof(m_au8Stamped));
+    return true;
+}
+
+
 /**
     clsLEAMDNSHost::clsService
 
@@ -1990,8 +2106,7 @@ bool clsLEAMDNSHost::clsRRAnswerSRV::clear(void)
 clsLEAMDNSHost::clsRRAnswerGeneric::clsRRAnswerGeneric(const clsRRHeader& p_Header,
         uint32_t p_u32TTL)
     :   clsRRAnswer(enuAnswerType::Generic, p_Header, p_u32TTL),
-        m_u16RDLength(0),
-        m_pu8RDData(0)
+        m_u16RDLength(0)
 {
 }
 
@@ -2010,16 +2125,187 @@ clsLEAMDNSHost::clsRRAnswerGeneric::~clsRRAnswerGeneric(void)
 */
 bool clsLEAMDNSHost::clsRRAnswerGeneric::clear(void)
 {
-    if (m_pu8RDData)
+    m_u16RDLength = 0;
+
+    return true;
+}
+
+
+/**
+    clsLEAMDNSHost::clsParseArena
+
+    Holds the records (and temp buffers) created while reading one received message.
+    Allocation just moves the fill offset; all memory is given back by 'reset' after
+    the message is processed. The last allocation may be given back earlier by 'free'
+    (LIFO), so known answers, which are read and dropped one by one, reuse the same space.
+    If the arena is exhausted, 'alloc' fails and the message is flagged as 'overflowed';
+    the arena never grows.
+*/
+
+/*
+    clsLEAMDNSHost::clsParseArena::clsParseArena constructor
+
+*/
+clsLEAMDNSHost::clsParseArena::clsParseArena(void)
+    :   m_pu8Buffer(0),
+        m_stSize(0),
+        m_stUsed(0),
+        m_stLast(0),
+        m_stHighWater(0),
+        m_u32Overflows(0),
+        m_bOverflowed(false)
+{
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::~clsParseArena destructor
+
+*/
+clsLEAMDNSHost::clsParseArena::~clsParseArena(void)
+{
+    release();
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::init
+
+*/
+bool clsLEAMDNSHost::clsParseArena::init(size_t p_stSize)
+{
+    release();
+    if (p_stSize)
     {
-        delete[] m_pu8RDData;
-        m_pu8RDData = 0;
+        m_pu8Buffer = (uint8_t*)malloc(p_stSize);
+        m_stSize = (m_pu8Buffer ? p_stSize : 0);
     }
-    m_u16RDLength = 0;
+    return (m_stSize == p_stSize);
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::release
 
+*/
+bool clsLEAMDNSHost::clsParseArena::release(void)
+{
+    if (m_pu8Buffer)
+    {
+        ::free(m_pu8Buffer);
+        m_pu8Buffer = 0;
+    }
+    m_stSize = 0;
+    m_stUsed = 0;
+    m_stLast = 0;
+    m_bOverflowed = false;
     return true;
 }
 
+/*
+    clsLEAMDNSHost::clsParseArena::alloc
+
+*/
+void* clsLEAMDNSHost::clsParseArena::alloc(size_t p_stSize)
+{
+    void*   pMemory = 0;
+
+    size_t  stOffset = ((m_stUsed + (alignof(std::max_align_t) - 1)) & ~(alignof(std::max_align_t) - 1));
+    if ((m_pu8Buffer) &&
+            (p_stSize <= m_stSize) &&
+            (stOffset <= (m_stSize - p_stSize)))
+    {
+        pMemory = (m_pu8Buffer + stOffset);
+        m_stLast = m_stUsed;
+        m_stUsed = (stOffset + p_stSize);
+        m_stHighWater = std::max(m_stHighWater, m_stUsed);
+    }
+    else if (m_pu8Buffer)
+    {
+        m_bOverflowed = true;
+    }
+    return pMemory;
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::free
+
+    Only the last allocation is given back; anything else stays until 'reset'.
+*/
+bool clsLEAMDNSHost::clsParseArena::free(void* p_pMemory)
+{
+    bool    bResult = false;
+
+    if ((owns(p_pMemory)) &&
+            ((uint8_t*)p_pMemory >= (m_pu8Buffer + m_stLast)) &&
+            (((uint8_t*)p_pMemory - m_pu8Buffer) < (ptrdiff_t)m_stUsed))
+    {
+        m_stUsed = m_stLast;
+        bResult = true;
+    }
+    return bResult;
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::owns
+
+*/
+bool clsLEAMDNSHost::clsParseArena::owns(const void* p_pMemory) const
+{
+    return ((m_pu8Buffer) &&
+            ((const uint8_t*)p_pMemory >= m_pu8Buffer) &&
+            ((const uint8_t*)p_pMemory < (m_pu8Buffer + m_stSize)));
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::reset
+
+*/
+bool clsLEAMDNSHost::clsParseArena::reset(void)
+{
+    if (m_bOverflowed)
+    {
+        ++m_u32Overflows;
+        m_bOverflowed = false;
+    }
+    m_stUsed = 0;
+    m_stLast = 0;
+    return true;
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::size
+
+*/
+size_t clsLEAMDNSHost::clsParseArena::size(void) const
+{
+    return m_stSize;
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::highWater
+
+*/
+size_t clsLEAMDNSHost::clsParseArena::highWater(void) const
+{
+    return m_stHighWater;
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::overflows
+
+*/
+uint32_t clsLEAMDNSHost::clsParseArena::overflows(void) const
+{
+    return m_u32Overflows;
+}
+
+/*
+    clsLEAMDNSHost::clsParseArena::overflowed
+
+*/
+bool clsLEAMDNSHost::clsParseArena::overflowed(void) const
+{
+    return m_bOverflowed;
+}
+
 
 /**
     clsLEAMDNSHost::clsSendParameter
@@ -2244,7 +2530,8 @@ uint16_t clsLEAMDNSHost::clsSendParameter::findCachedDomainOffset(const void* p_
 clsLEAMDNSHost::clsQuery::clsAnswer::clsTTL::clsTTL(void)
     :   m_u32TTL(0),
         m_TTLTimeout(std::numeric_limits<esp8266::polledTimeout::oneShot::timeType>::max()),
-        m_TimeoutLevel(static_cast<typeTimeoutLevel>(enuTimeoutLevel::None))
+        m_TimeoutLevel(static_cast<typeTimeoutLevel>(enuTimeoutLevel::None)),
+        m_ulExpiryTime(0)
 {
 }
 
@@ -2259,6 +2546,7 @@ bool clsLEAMDNSHost::clsQuery::clsAnswer::clsTTL::set(uint32_t p_u32TTL)
     {
         m_TimeoutLevel = static_cast<typeTimeoutLevel>(enuTimeoutLevel::Base);  // Set to 80%
         m_TTLTimeout.reset(timeout());
+        m_ulExpiryTime = (millis() + (std::min(m_u32TTL, (uint32_t)(INT32_MAX / 1000)) * 1000));
     }
     else
     {
@@ -2310,6 +2598,7 @@ bool clsLEAMDNSHost::clsQuery::clsAnswer::clsTTL::prepareDeletion(void)
 {
     m_TimeoutLevel = static_cast<typeTimeoutLevel>(enuTimeoutLevel::Final);
     m_TTLTimeout.reset(1 * 1000);   // See RFC 6762, 10.1
+    m_ulExpiryTime = (millis() + (1 * 1000));
 
     return true;
 }
@@ -2343,6 +2632,22 @@ unsigned long clsLEAMDNSHost::clsQuery::clsAnswer::clsTTL::timeout(void) const
     return u32Timeout;
 }
 
+/*
+    clsLEAMDNSHost::clsQuery::clsAnswer::clsTTL::remaining
+
+    Milliseconds until the TTL is outlasted (0 for unset or outlasted TTLs).
+*/
+unsigned long clsLEAMDNSHost::clsQuery::clsAnswer::clsTTL::remaining(void) const
+{
+    long    lRemaining = (long)(m_ulExpiryTime - millis());
+
+    return (((m_u32TTL) &&
+             (static_cast<typeTimeoutLevel>(enuTimeoutLevel::None) != m_TimeoutLevel) &&
+             (0 < lRemaining))
+            ? lRemaining
+            : 0);
+}
+
 
 /**
     clsLEAMDNSHost::clsQuery::clsAnswer::clsIPAddress
@@ -2406,6 +2711,39 @@ bool clsLEAMDNSHost::clsQuery::clsAnswer::clear(void)
            );
 }
 
+/*
+    clsLEAMDNSHost::clsQuery::clsAnswer::expiresIn
+
+    Milliseconds until the key component of the answer is outlasted.
+    For service answers, this is the service domain (PTR); for host answers
+    the last IP address.
+*/
+unsigned long clsLEAMDNSHost::clsQuery::clsAnswer::expiresIn(void) const
+{
+    unsigned long   ulExpiresIn = 0;
+
+    if (m_QueryAnswerFlags & static_cast<typeQueryAnswerType>(enuQueryAnswerType::ServiceDomain))
+    {
+        ulExpiresIn = m_TTLServiceDomain.remaining();
+    }
+    else
+    {
+#ifdef MDNS_IPV4_SUPPORT
+        for (const clsIPAddressWithTTL* pIPAddress : m_IPv4Addresses)
+        {
+            ulExpiresIn = std::max(ulExpiresIn, pIPAddress->m_TTL.remaining());
+        }
+#endif
+#ifdef MDNS2_IPV6_SUPPORT
+        for (const clsIPAddressWithTTL* pIPAddress : m_IPv6Addresses)
+        {
+            ulExpiresIn = std::max(ulExpiresIn, pIPAddress->m_TTL.remaining());
+        }
+#endif
+    }
+    return ulExpiresIn;
+}
+
 #ifdef MDNS_IPV4_SUPPORT
 /*
     clsLEAMDNSHost::clsQuery::clsAnswer::releaseIPv4Addresses
@@ -2986,7 +3324,8 @@ clsLEAMDNSHost::clsQuery::clsQuery(const enuQueryType p_QueryType)
         m_bStaticQuery(false),
         m_u32SentCount(0),
         m_ResendTimeout(std::numeric_limits<esp8266::polledTimeout::oneShot::timeType>::max()),
-        m_bAwaitingAnswers(true)
+        m_bAwaitingAnswers(true),
+        m_pAnswerCache(0)
 {
     clear();
     m_QueryType = p_QueryType;
@@ -3016,7 +3355,7 @@ bool clsLEAMDNSHost::clsQuery::clear(void)
     m_bAwaitingAnswers = true;
     for (clsAnswer* pAnswer : m_Answers)
     {
-        delete pAnswer;
+        releaseAnswer(pAnswer);
     }
     m_Answers.clear();
     return true;
@@ -3128,13 +3467,32 @@ bool clsLEAMDNSHost::clsQuery::removeAnswer(clsLEAMDNSHost::clsQuery::clsAnswer*
     if (m_Answers.end() != it)
     {
         m_Answers.erase(it);
-        delete p_pAnswer;
+        releaseAnswer(p_pAnswer);
 
         bResult = true;
     }
     return bResult;
 }
 
+/*
+    clsLEAMDNSHost::clsQuery::releaseAnswer
+
+    Gives the answer back to the answer cache (or the heap).
+*/
+bool clsLEAMDNSHost::clsQuery::releaseAnswer(clsLEAMDNSHost::clsQuery::clsAnswer* p_pAnswer)
+{
+    if ((m_pAnswerCache) &&
+            (m_pAnswerCache->owns(p_pAnswer)))
+    {
+        m_pAnswerCache->free(p_pAnswer);
+    }
+    else
+    {
+        delete p_pAnswer;
+    }
+    return true;
+}
+
 /*
     clsLEAMDNSHost::clsQuery::findAnswerForServiceDomain
 
@@ -3174,6 +3532,355 @@ clsLEAMDNSHost::clsQuery::clsAnswer* clsLEAMDNSHost::clsQuery::findAnswerForHost
 }
 
 
+/**
+    clsLEAMDNSHost::clsAnswerCache
+
+    A fixed number of query answer slots, allocated in one block.
+    Slot usage is kept in a bit mask; answers are constructed in place.
+*/
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::clsAnswerCache constructor
+
+*/
+clsLEAMDNSHost::clsAnswerCache::clsAnswerCache(void)
+    :   m_u32Evictions(0),
+        m_pu8Slots(0),
+        m_u8Slots(0),
+        m_u32UsedMask(0)
+{
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::~clsAnswerCache destructor
+
+*/
+clsLEAMDNSHost::clsAnswerCache::~clsAnswerCache(void)
+{
+    release();
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::init
+
+*/
+bool clsLEAMDNSHost::clsAnswerCache::init(uint8_t p_u8Slots)
+{
+    release();
+
+    p_u8Slots = std::min(p_u8Slots, clsConsts::u8AnswerCacheMaxSlots);
+    if (p_u8Slots)
+    {
+        m_pu8Slots = (uint8_t*)malloc(p_u8Slots * sizeof(clsQuery::clsAnswer));
+        m_u8Slots = (m_pu8Slots ? p_u8Slots : 0);
+    }
+    return (m_u8Slots == p_u8Slots);
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::release
+
+    All answers must have been given back before.
+*/
+bool clsLEAMDNSHost::clsAnswerCache::release(void)
+{
+    bool    bResult = (0 == m_u32UsedMask);
+
+    if ((bResult) &&
+            (m_pu8Slots))
+    {
+        ::free(m_pu8Slots);
+        m_pu8Slots = 0;
+        m_u8Slots = 0;
+    }
+    return bResult;
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::alloc
+
+*/
+clsLEAMDNSHost::clsQuery::clsAnswer* clsLEAMDNSHost::clsAnswerCache::alloc(void)
+{
+    clsQuery::clsAnswer*    pAnswer = 0;
+
+    if (!full())
+    {
+        uint8_t u8Slot = __builtin_ctz(~m_u32UsedMask);
+        m_u32UsedMask |= (1UL << u8Slot);
+        pAnswer = new (m_pu8Slots + (u8Slot * sizeof(clsQuery::clsAnswer))) clsQuery::clsAnswer;
+    }
+    return pAnswer;
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::free
+
+*/
+bool clsLEAMDNSHost::clsAnswerCache::free(clsQuery::clsAnswer* p_pAnswer)
+{
+    bool    bResult = false;
+
+    if (owns(p_pAnswer))
+    {
+        uint8_t u8Slot = (((uint8_t*)p_pAnswer - m_pu8Slots) / sizeof(clsQuery::clsAnswer));
+        p_pAnswer->~clsAnswer();
+        m_u32UsedMask &= ~(1UL << u8Slot);
+        bResult = true;
+    }
+    return bResult;
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::owns
+
+*/
+bool clsLEAMDNSHost::clsAnswerCache::owns(const clsQuery::clsAnswer* p_pAnswer) const
+{
+    return ((m_pu8Slots) &&
+            ((const uint8_t*)p_pAnswer >= m_pu8Slots) &&
+            ((const uint8_t*)p_pAnswer < (m_pu8Slots + (m_u8Slots * sizeof(clsQuery::clsAnswer)))));
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::slots
+
+*/
+uint8_t clsLEAMDNSHost::clsAnswerCache::slots(void) const
+{
+    return m_u8Slots;
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::used
+
+*/
+uint8_t clsLEAMDNSHost::clsAnswerCache::used(void) const
+{
+    return __builtin_popcount(m_u32UsedMask);
+}
+
+/*
+    clsLEAMDNSHost::clsAnswerCache::full
+
+*/
+bool clsLEAMDNSHost::clsAnswerCache::full(void) const
+{
+    return (used() == m_u8Slots);
+}
+
+
+/**
+    clsLEAMDNSHost::clsResponseCache
+
+    Serialized response bodies, keyed by interface and content hash.
+    The body of a response is captured (in '_udpAppendBuffer') while the response
+    is built; the least recently used entry is replaced.
+
+*/
+
+/*
+    clsLEAMDNSHost::clsResponseCache::clsResponseCache constructor
+
+*/
+clsLEAMDNSHost::clsResponseCache::clsResponseCache(void)
+    :   m_u32Hits(0),
+        m_u32Misses(0),
+        m_pEntries(0),
+        m_u8Entries(0),
+        m_u32UseCounter(0),
+        m_pCapture(0),
+        m_stCaptured(0)
+{
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::~clsResponseCache destructor
+
+*/
+clsLEAMDNSHost::clsResponseCache::~clsResponseCache(void)
+{
+    release();
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::init
+
+*/
+bool clsLEAMDNSHost::clsResponseCache::init(uint8_t p_u8Entries)
+{
+    release();
+
+    if ((p_u8Entries) &&
+            ((m_pEntries = new clsEntry[p_u8Entries])))
+    {
+        m_u8Entries = p_u8Entries;
+        for (uint8_t u8Entry = 0; u8Entry < m_u8Entries; ++u8Entry)
+        {
+            m_pEntries[u8Entry].m_u16Length = 0;
+        }
+    }
+    return (m_u8Entries == p_u8Entries);
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::release
+
+*/
+bool clsLEAMDNSHost::clsResponseCache::release(void)
+{
+    if (m_pEntries)
+    {
+        delete[] m_pEntries;
+        m_pEntries = 0;
+        m_u8Entries = 0;
+    }
+    m_pCapture = 0;
+    return true;
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::find
+
+*/
+const clsLEAMDNSHost::clsResponseCache::clsEntry* clsLEAMDNSHost::clsResponseCache::find(const netif* p_pNetIf,
+        uint32_t p_u32Key)
+{
+    for (uint8_t u8Entry = 0; u8Entry < m_u8Entries; ++u8Entry)
+    {
+        clsEntry&   rEntry = m_pEntries[u8Entry];
+        if ((rEntry.m_u16Length) &&
+                (p_u32Key == rEntry.m_u32Key) &&
+                (p_pNetIf == rEntry.m_pNetIf))
+        {
+            rEntry.m_u32LastUse = ++m_u32UseCounter;
+            ++m_u32Hits;
+            return &rEntry;
+        }
+    }
+    ++m_u32Misses;
+    return 0;
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::beginCapture
+
+    Selects an unused or the least recently used entry for the body of the response,
+    that is about to be written.
+
+*/
+bool clsLEAMDNSHost::clsResponseCache::beginCapture(const netif* p_pNetIf,
+        uint32_t p_u32Key)
+{
+    m_pCapture = 0;
+    for (uint8_t u8Entry = 0; u8Entry < m_u8Entries; ++u8Entry)
+    {
+        clsEntry*   pEntry = &m_pEntries[u8Entry];
+        if ((!m_pCapture) ||
+                ((m_pCapture->m_u16Length) &&                                               // Current choice is in use AND
+                 ((!pEntry->m_u16Length) ||                                                 // this entry is unused OR
+                  ((int32_t)(pEntry->m_u32LastUse - m_pCapture->m_u32LastUse) < 0))))       // less recently used
+        {
+            m_pCapture = pEntry;
+        }
+    }
+    if (m_pCapture)
+    {
+        m_pCapture->m_u16Length = 0;    // Invalid until committed
+        m_pCapture->m_pNetIf = p_pNetIf;
+        m_pCapture->m_u32Key = p_u32Key;
+        m_stCaptured = 0;
+    }
+    return (0 != m_pCapture);
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::capture
+
+    Bodies exceeding the entry size are not cached.
+
+*/
+bool clsLEAMDNSHost::clsResponseCache::capture(const unsigned char* p_pcBuffer,
+        size_t p_stLength)
+{
+    if (m_pCapture)
+    {
+        if ((m_stCaptured + p_stLength) <= sizeof(m_pCapture->m_au8Body))
+        {
+            memcpy(&m_pCapture->m_au8Body[m_stCaptured], p_pcBuffer, p_stLength);
+        }
+        m_stCaptured += p_stLength;
+    }
+    return true;
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::endCapture
+
+*/
+bool clsLEAMDNSHost::clsResponseCache::endCapture(const clsMsgHeader& p_MsgHeader,
+        bool p_bCommit)
+{
+    bool    bResult = false;
+
+    if ((m_pCapture) &&
+            (p_bCommit) &&
+            (m_stCaptured) &&
+            (m_stCaptured <= sizeof(m_pCapture->m_au8Body)))
+    {
+        m_pCapture->m_u16ANCount = p_MsgHeader.m_u16ANCount;
+        m_pCapture->m_u16NSCount = p_MsgHeader.m_u16NSCount;
+        m_pCapture->m_u16ARCount = p_MsgHeader.m_u16ARCount;
+        m_pCapture->m_u16Length = m_stCaptured;
+        m_pCapture->m_u32LastUse = ++m_u32UseCounter;
+        bResult = true;
+    }
+    m_pCapture = 0;
+    return bResult;
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::entries
+
+*/
+uint8_t clsLEAMDNSHost::clsResponseCache::entries(void) const
+{
+    return m_u8Entries;
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::hash (static)
+
+    FNV-1a hash of 'p_pData', continuing 'p_u32Hash' (start with 'u32HashSeed').
+
+*/
+uint32_t clsLEAMDNSHost::clsResponseCache::hash(uint32_t p_u32Hash,
+        const void* p_pData,
+        size_t p_stLength)
+{
+    const uint8_t*  pu8Data = (const uint8_t*)p_pData;
+    while (p_stLength--)
+    {
+        p_u32Hash = ((p_u32Hash ^ *pu8Data++) * 16777619UL);
+    }
+    return p_u32Hash;
+}
+
+/*
+    clsLEAMDNSHost::clsResponseCache::hash (static)
+
+    The terminating '\0' is included, so consecutive strings can't be mixed up.
+
+*/
+uint32_t clsLEAMDNSHost::clsResponseCache::hash(uint32_t p_u32Hash,
+        const char* p_pcString)
+{
+    return (p_pcString
+            ? hash(p_u32Hash, p_pcString, (strlen(p_pcString) + 1))
+            : hash(p_u32Hash, "", 1));
+}
+
+
 }   // namespace MDNSImplementation
 
 
@@ -22,6 +22,7 @@
 
 */
 
+#include <new>
 #include <coredecls.h>  // for can_yield()
 #include "ESP8266mDNS.h"
 #include "LEAmDNS2Host.h"
@@ -214,6 +215,8 @@ bool clsLEAMDNSHost::_sendMessage_Multicast(netif* pNetIf, clsLEAMDNSHost::clsSe
     In the first loop 'only' the header informations (mainly number of answers) are collected,
     while in the second loop, the header and all queries and answers are written to the UDP
     output buffer.
+    The body of cacheable responses is recorded while written; if the same response (same
+    content) is needed again, the header is written and the cached body is appended.
 
 */
 bool clsLEAMDNSHost::_prepareMessage(netif* pNetIf, clsLEAMDNSHost::clsSendParameter& p_rSendParameter)
@@ -235,6 +238,29 @@ bool clsLEAMDNSHost::_prepareMessage(netif* pNetIf, clsLEAMDNSHost::clsSendParam
                                        ? msgHeader.m_u16ANCount    // Usual answers
                                        : msgHeader.m_u16NSCount);  // Authorative answers
 
+    // Cached response?
+    uint32_t    u32ResponseKey = _responseCacheKey(pNetIf, p_rSendParameter);
+    if ((u32ResponseKey) &&
+            ((m_ResponseCache.entries()) ||
+             (m_ResponseCache.init(m_u8ResponseCacheEntries))))
+    {
+        const clsResponseCache::clsEntry*   pCachedResponse = m_ResponseCache.find(pNetIf, u32ResponseKey);
+        if (pCachedResponse)
+        {
+            msgHeader.m_u16ANCount = pCachedResponse->m_u16ANCount;
+            msgHeader.m_u16NSCount = pCachedResponse->m_u16NSCount;
+            msgHeader.m_u16ARCount = pCachedResponse->m_u16ARCount;
+            bResult = ((_writeMDNSMsgHeader(msgHeader, p_rSendParameter)) &&
+                       (_udpAppendBuffer(pCachedResponse->m_au8Body, pCachedResponse->m_u16Length)));
+            DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _prepareMDNSMessage: FAILED to append cached response!\n"), _DH()););
+            return bResult;
+        }
+    }
+    else
+    {
+        u32ResponseKey = 0;
+    }
+
     /**
         enuSequence
     */
@@ -268,6 +294,13 @@ bool clsLEAMDNSHost::_prepareMessage(netif* pNetIf, clsLEAMDNSHost::clsSendParam
                    ? true
                    : _writeMDNSMsgHeader(msgHeader, p_rSendParameter));
         DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _prepareMDNSMessage: _writeMDNSMsgHeader FAILED!\n"), _DH()););
+        if ((bResult) &&
+                (u32ResponseKey) &&
+                (static_cast<typeSequence>(enuSequence::Send) == sequence))
+        {
+            // Record the body (everything behind the header) for the response cache
+            m_ResponseCache.beginCapture(pNetIf, u32ResponseKey);
+        }
         // Questions
         for (clsRRQuestion::list::iterator it = p_rSendParameter.m_RRQuestions.begin(); ((bResult) && (it != p_rSendParameter.m_RRQuestions.end())); it++)
         {
@@ -517,10 +550,79 @@ bool clsLEAMDNSHost::_prepareMessage(netif* pNetIf, clsLEAMDNSHost::clsSendParam
 
         DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _prepareMDNSMessage: Loop %i FAILED!\n"), _DH(), sequence););
     }   // for sequence
+    m_ResponseCache.endCapture(msgHeader, bResult);
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _prepareMDNSMessage: FAILED!\n"), _DH()););
     return bResult;
 }
 
+/*
+    MDNSResponder::_responseCacheKey
+
+    Key of the cached response for 'p_SendParameter' on the given interface: a hash over
+    everything the response is built from.
+    0: The response can't be cached (queries, probes and legacy responses carry questions;
+    TXT items added by a dynamic callback may change with every response).
+
+*/
+uint32_t clsLEAMDNSHost::_responseCacheKey(netif* pNetIf,
+        const clsLEAMDNSHost::clsSendParameter& p_SendParameter) const
+{
+    if ((!m_u8ResponseCacheEntries) ||
+            (clsSendParameter::enuResponseType::None == p_SendParameter.m_Response) ||
+            (p_SendParameter.m_bLegacyDNSQuery) ||
+            (!p_SendParameter.m_RRQuestions.empty()))
+    {
+        return 0;
+    }
+
+    uint8_t     au8Flags[] = { static_cast<uint8_t>(p_SendParameter.m_Response),
+                               p_SendParameter.m_bAuthorative,
+                               p_SendParameter.m_bCacheFlush,
+                               p_SendParameter.m_bUnannounce
+                             };
+    uint32_t    u32Key = clsResponseCache::hash(clsResponseCache::u32HashSeed, au8Flags, sizeof(au8Flags));
+    u32Key = clsResponseCache::hash(u32Key, &p_SendParameter.m_u32HostReplyMask, sizeof(p_SendParameter.m_u32HostReplyMask));
+    u32Key = clsResponseCache::hash(u32Key, m_pcHostName);
+#ifdef MDNS_IPV4_SUPPORT
+    uint32_t    u32IPv4Address = _getResponderIPAddress(pNetIf, enuIPProtocolType::V4);
+    u32Key = clsResponseCache::hash(u32Key, &u32IPv4Address, sizeof(u32IPv4Address));
+#endif
+#ifdef MDNS2_IPV6_SUPPORT
+    IPAddress   ipV6Address = _getResponderIPAddress(pNetIf, enuIPProtocolType::V6);
+    if (ipV6Address.isSet())
+    {
+        u32Key = clsResponseCache::hash(u32Key, ipV6Address.raw6(), clsConsts::u16IPv6Size);
+    }
+#endif
+
+    for (const clsService* pService : m_Services)
+    {
+        if (pService->m_u32ReplyMask)
+        {
+            bool    bTxt = (pService->m_u32ReplyMask & static_cast<uint32_t>(enuContentFlag::TXT));
+            if ((bTxt) &&
+                    (pService->m_fnTxtCallback))
+            {
+                return 0;
+            }
+            u32Key = clsResponseCache::hash(u32Key, &pService->m_u32ReplyMask, sizeof(pService->m_u32ReplyMask));
+            u32Key = clsResponseCache::hash(u32Key, pService->m_pcInstanceName);
+            u32Key = clsResponseCache::hash(u32Key, pService->m_pcType);
+            u32Key = clsResponseCache::hash(u32Key, pService->m_pcProtocol);
+            u32Key = clsResponseCache::hash(u32Key, &pService->m_u16Port, sizeof(pService->m_u16Port));
+            if (bTxt)
+            {
+                for (const clsServiceTxt* pTxt : pService->m_Txts.m_Txts)
+                {
+                    u32Key = clsResponseCache::hash(u32Key, pTxt->m_pcKey);
+                    u32Key = clsResponseCache::hash(u32Key, pTxt->m_pcValue);
+                }
+            }
+        }
+    }
+    return (u32Key ? : 1);
+}
+
 /*
     MDNSResponder::_addQueryRecord
 
@@ -685,6 +787,54 @@ bool clsLEAMDNSHost::_readRRQuestion(clsLEAMDNSHost::clsRRQuestion& p_rRRQuestio
     return bResult;
 }
 
+/*
+    MDNSResponder::_newRRAnswer
+
+    Creates an answer object in the parse arena (or on the heap, if no arena is set).
+    Fails, if the arena is exhausted.
+*/
+template<class T>
+T* clsLEAMDNSHost::_newRRAnswer(const clsLEAMDNSHost::clsRRHeader& p_Header,
+                                uint32_t p_u32TTL)
+{
+    T*      pRRAnswer = 0;
+
+    if (m_ParseArena.size())
+    {
+        void*   pMemory = m_ParseArena.alloc(sizeof(T));
+        if (pMemory)
+        {
+            pRRAnswer = new (pMemory) T(p_Header, p_u32TTL);
+        }
+        DEBUG_EX_ERR(if (!pMemory) DEBUG_OUTPUT.printf_P(PSTR("%s _newRRAnswer: Parse arena exhausted!\n"), _DH()););
+    }
+    else
+    {
+        pRRAnswer = new T(p_Header, p_u32TTL);
+    }
+    return pRRAnswer;
+}
+
+/*
+    MDNSResponder::_releaseRRAnswer
+
+    Destroys an answer created by '_newRRAnswer'.
+    Arena memory is given back at once for the last answer, else with the end of the message.
+*/
+bool clsLEAMDNSHost::_releaseRRAnswer(clsLEAMDNSHost::clsRRAnswer* p_pRRAnswer)
+{
+    if (m_ParseArena.owns(p_pRRAnswer))
+    {
+        p_pRRAnswer->~clsRRAnswer();
+        m_ParseArena.free(p_pRRAnswer);
+    }
+    else
+    {
+        delete p_pRRAnswer;
+    }
+    return true;
+}
+
 /*
     MDNSResponder::_readRRAnswer
 
@@ -719,31 +869,31 @@ bool clsLEAMDNSHost::_readRRAnswer(clsLEAMDNSHost::clsRRAnswer*& p_rpRRAnswer)
         {
 #ifdef MDNS_IPV4_SUPPORT
         case DNS_RRTYPE_A:
-            p_rpRRAnswer = new clsRRAnswerA(header, u32TTL);
-            bResult = _readRRAnswerA(*(clsRRAnswerA*&)p_rpRRAnswer, u16RDLength);
+            bResult = (((p_rpRRAnswer = _newRRAnswer<clsRRAnswerA>(header, u32TTL))) &&
+                       (_readRRAnswerA(*(clsRRAnswerA*&)p_rpRRAnswer, u16RDLength)));
             break;
 #endif
         case DNS_RRTYPE_PTR:
-            p_rpRRAnswer = new clsRRAnswerPTR(header, u32TTL);
-            bResult = _readRRAnswerPTR(*(clsRRAnswerPTR*&)p_rpRRAnswer, u16RDLength);
+            bResult = (((p_rpRRAnswer = _newRRAnswer<clsRRAnswerPTR>(header, u32TTL))) &&
+                       (_readRRAnswerPTR(*(clsRRAnswerPTR*&)p_rpRRAnswer, u16RDLength)));
             break;
         case DNS_RRTYPE_TXT:
-            p_rpRRAnswer = new clsRRAnswerTXT(header, u32TTL);
-            bResult = _readRRAnswerTXT(*(clsRRAnswerTXT*&)p_rpRRAnswer, u16RDLength);
+            bResult = (((p_rpRRAnswer = _newRRAnswer<clsRRAnswerTXT>(header, u32TTL))) &&
+                       (_readRRAnswerTXT(*(clsRRAnswerTXT*&)p_rpRRAnswer, u16RDLength)));
             break;
 #ifdef MDNS2_IPV6_SUPPORT
         case DNS_RRTYPE_AAAA:
-            p_rpRRAnswer = new clsRRAnswerAAAA(header, u32TTL);
-            bResult = _readRRAnswerAAAA(*(clsRRAnswerAAAA*&)p_rpRRAnswer, u16RDLength);
+            bResult = (((p_rpRRAnswer = _newRRAnswer<clsRRAnswerAAAA>(header, u32TTL))) &&
+                       (_readRRAnswerAAAA(*(clsRRAnswerAAAA*&)p_rpRRAnswer, u16RDLength)));
             break;
 #endif
         case DNS_RRTYPE_SRV:
-            p_rpRRAnswer = new clsRRAnswerSRV(header, u32TTL);
-            bResult = _readRRAnswerSRV(*(clsRRAnswerSRV*&)p_rpRRAnswer, u16RDLength);
+            bResult = (((p_rpRRAnswer = _newRRAnswer<clsRRAnswerSRV>(header, u32TTL))) &&
+                       (_readRRAnswerSRV(*(clsRRAnswerSRV*&)p_rpRRAnswer, u16RDLength)));
             break;
         default:
-            p_rpRRAnswer = new clsRRAnswerGeneric(header, u32TTL);
-            bResult = _readRRAnswerGeneric(*(clsRRAnswerGeneric*&)p_rpRRAnswer, u16RDLength);
+            bResult = (((p_rpRRAnswer = _newRRAnswer<clsRRAnswerGeneric>(header, u32TTL))) &&
+                       (_readRRAnswerGeneric(*(clsRRAnswerGeneric*&)p_rpRRAnswer, u16RDLength)));
             break;
         }
 
@@ -808,7 +958,7 @@ bool clsLEAMDNSHost::_readRRAnswer(clsLEAMDNSHost::clsRRAnswer*& p_rpRRAnswer)
 
         DEBUG_EX_INFO_IF(!((bResult) && (p_rpRRAnswer)),
         {
-            DEBUG_OUTPUT.printf_P(PSTR("%s _readRRAnswer: FAILED to read specific answer of type 0x%04X!\n"), _DH(), p_rpRRAnswer->m_Header.m_Attributes.m_u16Type);
+            DEBUG_OUTPUT.printf_P(PSTR("%s _readRRAnswer: FAILED to read specific answer of type 0x%04X!\n"), _DH(), header.m_Attributes.m_u16Type);
         });
     }
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _readRRAnswer: FAILED!\n"), _DH()););
@@ -859,7 +1009,12 @@ bool clsLEAMDNSHost::_readRRAnswerTXT(clsLEAMDNSHost::clsRRAnswerTXT& p_rRRAnswe
     {
         bResult = false;
 
-        unsigned char*  pucBuffer = new unsigned char[p_u16RDLength];
+        unsigned char*  pucBuffer = (unsigned char*)m_ParseArena.alloc(p_u16RDLength);
+        if ((!pucBuffer) &&
+                (!m_ParseArena.size()))
+        {
+            pucBuffer = new unsigned char[p_u16RDLength];
+        }
         if (pucBuffer)
         {
             if (_udpReadBuffer(pucBuffer, p_u16RDLength))
@@ -949,7 +1104,10 @@ bool clsLEAMDNSHost::_readRRAnswerTXT(clsLEAMDNSHost::clsRRAnswerTXT& p_rRRAnswe
                 DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _readRRAnswerTXT: FAILED to read TXT content!\n"), _DH()););
             }
             // Clean up
-            delete[] pucBuffer;
+            if (!m_ParseArena.free(pucBuffer))
+            {
+                delete[] pucBuffer;
+            }
         }
         else
         {
@@ -1008,13 +1166,16 @@ bool clsLEAMDNSHost::_readRRAnswerSRV(clsLEAMDNSHost::clsRRAnswerSRV& p_rRRAnswe
 bool clsLEAMDNSHost::_readRRAnswerGeneric(clsLEAMDNSHost::clsRRAnswerGeneric& p_rRRAnswerGeneric,
         uint16_t p_u16RDLength)
 {
-    bool    bResult = (0 == p_u16RDLength);
+    bool    bResult = false;
 
+    // The content of unknown answers is never used -> just skip it
     p_rRRAnswerGeneric.clear();
-    if (((p_rRRAnswerGeneric.m_u16RDLength = p_u16RDLength)) &&
-            ((p_rRRAnswerGeneric.m_pu8RDData = new unsigned char[p_rRRAnswerGeneric.m_u16RDLength])))
+    if ((m_pUDPContext) &&
+            (m_pUDPContext->getSize() >= p_u16RDLength))
     {
-        bResult = _udpReadBuffer(p_rRRAnswerGeneric.m_pu8RDData, p_rRRAnswerGeneric.m_u16RDLength);
+        m_pUDPContext->seek(m_pUDPContext->tell() + p_u16RDLength);
+        p_rRRAnswerGeneric.m_u16RDLength = p_u16RDLength;
+        bResult = true;
     }
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _readRRAnswerGeneric: FAILED!\n"), _DH()););
     return bResult;
@@ -1390,7 +1551,8 @@ bool clsLEAMDNSHost::_udpAppendBuffer(const unsigned char* p_pcBuffer,
 {
     bool bResult = ((p_pcBuffer) &&
                     (p_stLength) &&
-                    (p_stLength == m_pUDPContext->append((const char*)p_pcBuffer, p_stLength)));
+                    (p_stLength == m_pUDPContext->append((const char*)p_pcBuffer, p_stLength)) &&
+                    (m_ResponseCache.capture(p_pcBuffer, p_stLength)));
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("%s _udpAppendBuffer: FAILED!\n"), _DH()););
     return bResult;
 }
@@ -1971,12 +2133,13 @@ bool clsLEAMDNSHost::_writeMDNSAnswer_TXT(clsLEAMDNSHost::clsService& p_rService
                 unsigned char       ucLengthByte = pTxt->length();
                 if (!((bResult = ((_udpAppendBuffer((unsigned char*)&ucLengthByte, sizeof(ucLengthByte))) &&                                        // Length
                                   (p_rSendParameter.shiftOffset(sizeof(ucLengthByte))) &&
-                                  ((size_t)os_strlen(pTxt->m_pcKey) == m_pUDPContext->append(pTxt->m_pcKey, os_strlen(pTxt->m_pcKey))) &&           // Key
+                                  (_udpAppendBuffer((const unsigned char*)pTxt->m_pcKey, os_strlen(pTxt->m_pcKey))) &&                                // Key
                                   (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcKey))) &&
-                                  (1 == m_pUDPContext->append("=", 1)) &&                                                                           // =
+                                  (_udpAppendBuffer((const unsigned char*)"=", 1)) &&                                                                // =
                                   (p_rSendParameter.shiftOffset(1)) &&
                                   ((!pTxt->m_pcValue) ||
-                                   (((size_t)os_strlen(pTxt->m_pcValue) == m_pUDPContext->append(pTxt->m_pcValue, os_strlen(pTxt->m_pcValue))) &&   // Value
+                                   (!*pTxt->m_pcValue) ||
+                                   ((_udpAppendBuffer((const unsigned char*)pTxt->m_pcValue, os_strlen(pTxt->m_pcValue))) &&                          // Value
                                     (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcValue)))))))))
                 {
                     DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("%s _writeMDNSAnswer_TXT: FAILED to write %sTxt %s=%s!\n"), _DH(), (pTxt->m_bTemp ? "temp. " : ""), (pTxt->m_pcKey ? : "?"), (pTxt->m_pcValue ? : "?")););
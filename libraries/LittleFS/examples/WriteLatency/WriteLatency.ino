@@ -0,0 +1,99 @@
+// Write latency of a periodic logger, with and without background
+// garbage collection.  Prints a histogram of the time taken by each
+// write() and flush() for both runs.
+// Released to the public domain
+
+#include <FS.h>
+#include <LittleFS.h>
+
+// Choose the filesystem to test
+// WARNING:  The filesystem will be formatted at the start of each run!
+// LittleFS only collects in the background with littlefs 2.8 or later,
+// before that both runs behave the same.
+
+#define TESTFS SPIFFS
+//#define TESTFS LittleFS
+
+// SPIFFS is deprecated, but still the one stalling writes on collection
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+// One sample every SAMPLEMS, flushed every 10 samples
+#define SAMPLES 5000
+#define SAMPLEMS 10
+#define SAMPLESIZE 64
+// The log alternates between two files of this size
+#define ROTATEKB 16
+// Free space left next to the ballast file, so that collection is needed
+#define FREEKB 96
+// Background collection every second, a step (one block erase, ~100ms)
+// is only started when it fits in the budget
+#define GCPERIODMS 1000
+#define GCBUDGETMS 200
+
+static const char *bucketNames[FSStats::latencyBuckets] = { "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s" };
+
+void DoRun(FS *fs, bool background) {
+  if (!fs->format() || !fs->begin()) {
+    Serial.printf("Unable to format() and begin(), aborting\n");
+    return;
+  }
+
+  FSInfo info;
+  fs->info(info);
+  uint8_t data[256];
+  memset(data, 0x55, sizeof(data));
+  File ballast = fs->open("/ballast.bin", "w");
+  for (size_t left = info.totalBytes - info.usedBytes; left > FREEKB * 1024; left -= sizeof(data)) {
+    if (ballast.write(data, sizeof(data)) != sizeof(data)) {
+      break;
+    }
+  }
+  ballast.close();
+
+  fs->setBackgroundGC(background ? GCPERIODMS * 1000 : 0, GCBUDGETMS * 1000);
+  FSStats st;
+  fs->stats(st, true);
+
+  Serial.printf("Logging %d samples %s background garbage collection...\n", SAMPLES, background ? "with" : "without");
+  File f;
+  int file = 0;
+  uint32_t next = millis();
+  for (int i = 0; i < SAMPLES; i++) {
+    if (!f || (f.size() >= ROTATEKB * 1024)) {
+      f.close();
+      file ^= 1;
+      f = fs->open(String("/log") + file, "w");
+    }
+    f.write(data, SAMPLESIZE);
+    if ((i % 10) == 9) {
+      f.flush();
+    }
+    next += SAMPLEMS;
+    int32_t wait = next - millis();
+    if (wait > 0) {
+      delay(wait); // Background collection runs here
+    }
+  }
+  f.close();
+  fs->setBackgroundGC(0);
+
+  fs->stats(st);
+  Serial.printf("==> write()/flush() latency %s background garbage collection:\n", background ? "with" : "without");
+  for (size_t i = 0; i < FSStats::latencyBuckets; i++) {
+    Serial.printf("    %-7s %u\n", bucketNames[i], st.writeLatency[i]);
+  }
+  Serial.printf("    worst case %u us, %u collection steps\n", st.writeMaxUs, st.gcSteps);
+  fs->end();
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.printf("Beginning test\n");
+  Serial.flush();
+  DoRun(&TESTFS, false);
+  DoRun(&TESTFS, true);
+}
+
+void loop() {
+  delay(10000);
+}
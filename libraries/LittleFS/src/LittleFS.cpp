@@ -168,6 +168,8 @@ int LittleFSImpl::lfs_flash_read(const struct lfs_config *c,
     lfs_block_t block, lfs_off_t off, void *dst, lfs_size_t size) {
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize) + off;
+    me->_stats.readCalls++;
+    me->_stats.readBytes += size;
     return flash_hal_read(addr, size, static_cast<uint8_t*>(dst)) == FLASH_HAL_OK ? 0 : -1;
 }
 
@@ -176,6 +178,8 @@ int LittleFSImpl::lfs_flash_prog(const struct lfs_config *c,
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize) + off;
     const uint8_t *src = reinterpret_cast<const uint8_t *>(buffer);
+    me->_stats.progCalls++;
+    me->_stats.progBytes += size;
     return flash_hal_write(addr, size, static_cast<const uint8_t*>(src)) == FLASH_HAL_OK ? 0 : -1;
 }
 
@@ -183,13 +187,15 @@ int LittleFSImpl::lfs_flash_erase(const struct lfs_config *c, lfs_block_t block)
     LittleFSImpl *me = reinterpret_cast<LittleFSImpl*>(c->context);
     uint32_t addr = me->_start + (block * me->_blockSize);
     uint32_t size = me->_blockSize;
+    me->_stats.eraseCalls++;
+    me->_stats.eraseBytes += size;
     return flash_hal_erase(addr, size) == FLASH_HAL_OK ? 0 : -1;
 }
 
 int LittleFSImpl::lfs_flash_sync(const struct lfs_config *c) {
-    /* NOOP */
     (void) c;
-    return 0;
+    // Commits end here, push pages held by the flash_hal cache
+    return flash_hal_sync() == FLASH_HAL_OK ? 0 : -1;
 }
 
 
@@ -28,6 +28,9 @@
 #define __LITTLEFS_H
 
 #include <limits>
+#include <memory>
+#include <new>
+#include <algorithm>
 #include <FS.h>
 #include <FSImpl.h>
 #include <debug.h>
@@ -48,7 +51,48 @@ class LittleFSConfig : public FSConfig
 {
 public:
     static constexpr uint32_t FSId = 0x4c495454;
-    LittleFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat) { }
+    LittleFSConfig(bool autoFormat = true) : FSConfig(FSId, autoFormat), _readSize(64), _progSize(64),
+        _cacheSize(256), _lookaheadSize(0), _blockCycles(16), _readAhead(0) { }
+
+    // Smallest flash read and program, every flash access is a multiple of these
+    LittleFSConfig setReadSize(uint32_t size) {
+        _readSize = size;
+        return *this;
+    }
+    LittleFSConfig setProgSize(uint32_t size) {
+        _progSize = size;
+        return *this;
+    }
+    // Size of the read cache, the program cache and each open file's cache, so the
+    // largest single flash read.  Must be a multiple of the read and program sizes
+    // and divide the block size.  Costs (2 + open files) * size bytes of RAM.
+    LittleFSConfig setCacheSize(uint32_t size) {
+        _cacheSize = size;
+        return *this;
+    }
+    // Free block bitmap, one bit per block, multiple of 8 bytes.  The default of 0
+    // sizes it to cover the whole filesystem (at most 256 bytes).
+    LittleFSConfig setLookaheadSize(uint32_t size) {
+        _lookaheadSize = size;
+        return *this;
+    }
+    // Metadata erase cycles before it is moved for wear leveling, -1 disables
+    LittleFSConfig setBlockCycles(int32_t cycles) {
+        _blockCycles = cycles;
+        return *this;
+    }
+    // Bytes read ahead for small sequential reads of files opened read-only, 0 disables
+    LittleFSConfig setReadAhead(uint32_t size) {
+        _readAhead = size;
+        return *this;
+    }
+
+    uint32_t _readSize;
+    uint32_t _progSize;
+    uint32_t _cacheSize;
+    uint32_t _lookaheadSize;
+    int32_t  _blockCycles;
+    uint32_t _readAhead;
 };
 
 class LittleFSImpl : public FSImpl
@@ -58,19 +102,16 @@ public:
         : _start(start) , _size(size) , _pageSize(pageSize) , _blockSize(blockSize) , _maxOpenFds(maxOpenFds),
           _mounted(false) {
         memset(&_lfs, 0, sizeof(_lfs));
+        memset(&_stats, 0, sizeof(_stats));
         memset(&_lfs_cfg, 0, sizeof(_lfs_cfg));
         _lfs_cfg.context = (void*) this;
         _lfs_cfg.read = lfs_flash_read;
         _lfs_cfg.prog = lfs_flash_prog;
         _lfs_cfg.erase = lfs_flash_erase;
         _lfs_cfg.sync = lfs_flash_sync;
-        _lfs_cfg.read_size = 64;
-        _lfs_cfg.prog_size = 64;
         _lfs_cfg.block_size =  _blockSize;
         _lfs_cfg.block_count =_blockSize? _size / _blockSize: 0;
-        _lfs_cfg.block_cycles = 16; // TODO - need better explanation
-        _lfs_cfg.cache_size = 64;
-        _lfs_cfg.lookahead_size = 64;
+        _applyConfig(_cfg);
         _lfs_cfg.read_buffer = nullptr;
         _lfs_cfg.prog_buffer = nullptr;
         _lfs_cfg.lookahead_buffer = nullptr;
@@ -176,8 +217,39 @@ public:
         if ((cfg._type != LittleFSConfig::FSId) || _mounted) {
             return false;
         }
-        _cfg = *static_cast<const LittleFSConfig *>(&cfg);
-       return true;
+        const LittleFSConfig& lfsCfg = *static_cast<const LittleFSConfig *>(&cfg);
+        if (!_applyConfig(lfsCfg)) {
+            return false;
+        }
+        _cfg = lfsCfg;
+        return true;
+    }
+
+    bool stats(FSStats& stats, bool reset) override {
+        stats = _stats;
+        if (reset) {
+            memset(&_stats, 0, sizeof(_stats));
+        }
+        return true;
+    }
+
+    bool gcStep(uint32_t budgetUs) override {
+        (void) budgetUs;
+#if defined(LFS_VERSION) && (LFS_VERSION >= 0x00020008)
+        // One bounded pass: refill the lookahead buffer, which otherwise
+        // happens by traversing the whole filesystem inside a write, and
+        // compact metadata pairs past compact_thresh on newer littlefs
+        if (!_mounted) {
+            return false;
+        }
+        int rc = lfs_fs_gc(&_lfs);
+        if (rc < 0) {
+            DEBUGV("lfs_fs_gc rc=%d\n", rc);
+            return false;
+        }
+        _stats.gcSteps++;
+#endif
+        return false;
     }
 
     bool begin() override {
@@ -250,6 +322,28 @@ protected:
         return _mounted;
     }
 
+    // Check the geometry and copy it into the littlefs configuration, leaving it
+    // untouched when it is not usable
+    bool _applyConfig(const LittleFSConfig& cfg) {
+        uint32_t lookahead = cfg._lookaheadSize;
+        if (!lookahead) {
+            lookahead = std::min<uint32_t>(256, std::max<uint32_t>(8, (_lfs_cfg.block_count + 63) / 64 * 8));
+        }
+        if (!cfg._readSize || !cfg._progSize || !cfg._cacheSize ||
+            (cfg._cacheSize % cfg._readSize) || (cfg._cacheSize % cfg._progSize) ||
+            (_blockSize && (_blockSize % cfg._cacheSize)) || (lookahead % 8)) {
+            DEBUGV("LittleFS: invalid read=%u prog=%u cache=%u lookahead=%u\n",
+                   cfg._readSize, cfg._progSize, cfg._cacheSize, lookahead);
+            return false;
+        }
+        _lfs_cfg.read_size = cfg._readSize;
+        _lfs_cfg.prog_size = cfg._progSize;
+        _lfs_cfg.cache_size = cfg._cacheSize;
+        _lfs_cfg.lookahead_size = lookahead;
+        _lfs_cfg.block_cycles = cfg._blockCycles;
+        return true;
+    }
+
     int _getUsedBlocks() {
         if (!_mounted) {
             return 0;
@@ -309,6 +403,7 @@ protected:
     lfs_config  _lfs_cfg;
 
     LittleFSConfig _cfg;
+    FSStats        _stats;
 
     uint32_t _start;
     uint32_t _size;
@@ -323,7 +418,8 @@ protected:
 class LittleFSFileImpl : public FileImpl
 {
 public:
-    LittleFSFileImpl(LittleFSImpl* fs, const char *name, std::shared_ptr<lfs_file_t> fd, int flags, time_t creation) : _fs(fs), _fd(fd), _opened(true), _flags(flags), _creation(creation) {
+    LittleFSFileImpl(LittleFSImpl* fs, const char *name, std::shared_ptr<lfs_file_t> fd, int flags, time_t creation) : _fs(fs), _fd(fd), _opened(true), _flags(flags), _creation(creation),
+        _raSize((flags & LFS_O_WRONLY) ? 0 : fs->_cfg._readAhead), _raLen(0), _raOff(0) {
         _name = std::shared_ptr<char>(new char[strlen(name) + 1], std::default_delete<char[]>());
         strcpy(_name.get(), name);
     }
@@ -338,7 +434,9 @@ public:
         if (!_opened || !_fd || !buf) {
             return 0;
         }
+        uint32_t start = micros();
         int result = lfs_file_write(_fs->getFS(), _getFD(), (void*) buf, size);
+        _fs->_stats.addWriteLatency(micros() - start);
         if (result < 0) {
             DEBUGV("lfs_write rc=%d\n", result);
             return 0;
@@ -350,6 +448,9 @@ public:
         if (!_opened || !_fd | !buf) {
             return 0;
         }
+        if (_raSize) {
+            return _readBuffered(buf, size);
+        }
         int result = lfs_file_read(_fs->getFS(), _getFD(), (void*) buf, size);
         if (result < 0) {
             DEBUGV("lfs_read rc=%d\n", result);
@@ -363,7 +464,9 @@ public:
         if (!_opened || !_fd) {
             return;
         }
+        uint32_t start = micros();
         int rc = lfs_file_sync(_fs->getFS(), _getFD());
+        _fs->_stats.addWriteLatency(micros() - start);
         if (rc < 0) {
             DEBUGV("lfs_file_sync rc=%d\n", rc);
         }
@@ -377,6 +480,7 @@ public:
         if (mode == SeekEnd) {
             offset = -offset; // TODO - this seems like its plain wrong vs. POSIX
         }
+        _dropReadAhead();
         auto lastPos = position();
         int rc = lfs_file_seek(_fs->getFS(), _getFD(), offset, (int)mode); // NB. SeekMode === LFS_SEEK_TYPES
         if (rc < 0) {
@@ -400,7 +504,7 @@ public:
             return 0;
         }
 
-        return result;
+        return result - (_raLen - _raOff);
     }
 
     size_t size() const override {
@@ -419,10 +523,26 @@ public:
         return true;
     }
 
+    const uint8_t* mapped() const override {
+        if (!_opened || !_fd || (_flags & LFS_O_WRONLY)) {
+            return nullptr;
+        }
+        // Inline files live inside metadata pairs.  Otherwise the data is a CTZ
+        // skip-list whose first block carries no pointers, so a file fitting in
+        // one block is stored contiguously from its start.
+        const lfs_file_t *fd = _getFD();
+        if ((fd->flags & LFS_F_INLINE) || !fd->ctz.size || (fd->ctz.size > _fs->_blockSize)) {
+            return nullptr;
+        }
+        return flash_hal_map(_fs->_start + fd->ctz.head * _fs->_blockSize, fd->ctz.size);
+    }
+
     void close() override {
         if (_opened && _fd) {
             lfs_file_close(_fs->getFS(), _getFD());
             _opened = false;
+            _raBuf.reset();
+            _raLen = _raOff = 0;
             DEBUGV("lfs_file_close: fd=%p\n", _getFD());
             if (timeCallback && (_flags & LFS_O_WRONLY)) {
                 // If the file opened with O_CREAT, write the creation time attribute
@@ -501,12 +621,62 @@ protected:
         return _fd.get();
     }
 
+    // Small reads are served from a buffer refilled _raSize bytes at a time, the
+    // littlefs file position is then ahead of ours by the unread part of the buffer
+    size_t _readBuffered(uint8_t* buf, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            if (_raOff < _raLen) {
+                size_t n = std::min<size_t>(size - done, _raLen - _raOff);
+                memcpy(buf + done, _raBuf.get() + _raOff, n);
+                _raOff += n;
+                done += n;
+                continue;
+            }
+            if (!_raBuf && (size - done < _raSize)) {
+                _raBuf.reset(new (std::nothrow) uint8_t[_raSize]);
+            }
+            if (!_raBuf || (size - done >= _raSize)) {
+                // Large reads, or no memory for the buffer, go straight to the caller
+                int result = lfs_file_read(_fs->getFS(), _getFD(), (void*) (buf + done), size - done);
+                if (result < 0) {
+                    DEBUGV("lfs_read rc=%d\n", result);
+                    break;
+                }
+                done += result;
+                break;
+            }
+            int result = lfs_file_read(_fs->getFS(), _getFD(), (void*) _raBuf.get(), _raSize);
+            if (result <= 0) {
+                if (result < 0) {
+                    DEBUGV("lfs_read rc=%d\n", result);
+                }
+                break;
+            }
+            _raLen = result;
+            _raOff = 0;
+        }
+        return done;
+    }
+
+    // Hand the unread part of the buffer back so both positions agree again
+    void _dropReadAhead() {
+        if (_raOff < _raLen) {
+            lfs_file_seek(_fs->getFS(), _getFD(), -(lfs_soff_t)(_raLen - _raOff), LFS_SEEK_CUR);
+        }
+        _raLen = _raOff = 0;
+    }
+
     LittleFSImpl                *_fs;
     std::shared_ptr<lfs_file_t>  _fd;
     std::shared_ptr<char>        _name;
     bool                         _opened;
     int                          _flags;
     time_t                       _creation;
+    std::unique_ptr<uint8_t[]>   _raBuf;
+    uint32_t                     _raSize;
+    uint32_t                     _raLen;
+    uint32_t                     _raOff;
 };
 
 class LittleFSDirImpl : public DirImpl
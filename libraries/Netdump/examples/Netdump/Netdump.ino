@@ -64,10 +64,15 @@ void startTracefile() {
   // To file all traffic, format pcap file
   tracefile = filesystem->open("/tr.pcap", "w");
   nd.fileDump(tracefile);
+  // or pcapng, which also records the packets dropped when the capture ring was full
+  //  tracefile = filesystem->open("/tr.pcapng", "w");
+  //  nd.fileDump(tracefile, nullptr, Netdump::Format::PCAPNG);
 }
 
 void startTcpDump() {
   // To tcpserver, all traffic.
+  // A compiled filter expression is cheaper than a Filter on busy networks, ie:
+  //  nd.setFilterExpression("not port 22 and (tcp or udp port 53)");
   tcpServer.begin();
   nd.tcpDump(tcpServer);
 }
@@ -110,6 +115,13 @@ void setup(void) {
   }
               );
 
+  webServer.on("/stats",
+  []() {
+    String s = "<h1>Captured " + String(nd.getCaptured()) + ", dropped " + String(nd.getDropped()) + "</h1>";
+    webServer.send(200, "text/html", s);
+  }
+              );
+
   webServer.on("/reset",
   []() {
     nd.reset();
@@ -122,6 +134,9 @@ void setup(void) {
   webServer.serveStatic("/", *filesystem, "/");
   webServer.begin();
 
+  // printDump, fileDump and tcpDump capture into a 4KB ring by default, enlarge it for bursty traffic
+  //  nd.setCaptureBuffer(16384);
+
   startSerial(SerialOption::AllFull); // Serial output examples, use enum SerialOption for selection
 
   //  startTcpDump();     // tcpdump option
@@ -39,10 +39,7 @@ Netdump::Netdump()
 Netdump::~Netdump()
 {
     reset();
-    if (packetBuffer)
-    {
-        delete[] packetBuffer;
-    }
+    ring.end();
 };
 
 void Netdump::setCallback(const Callback nc)
@@ -64,39 +61,79 @@ void Netdump::setFilter(const Filter nf)
 void Netdump::reset()
 {
     setCallback(nullptr, nullptr);
+    compiledFilter.clear();
+    dumpTarget = DumpTarget::NONE;
+    tcpDumpPort = 0;
+}
+
+bool Netdump::setFilterExpression(const char* expression)
+{
+    return compiledFilter.compile(expression);
+}
+
+bool Netdump::setCaptureBuffer(size_t ringSize, uint16_t snapLength)
+{
+    return ring.begin(ringSize, snapLength);
 }
 
 void Netdump::printDump(Print& out, Packet::PacketDetail ndd, const Filter nf)
 {
     out.printf("netDump starting\r\n");
-    setCallback([&out, ndd, this](const Packet & ndp)
-    {
-        printDumpProcess(out, ndd, ndp);
-    }, nf);
+    dumpPrint = &out;
+    dumpDetail = ndd;
+    startRing(DumpTarget::PRINT, nf, Format::PCAP);
 }
 
-void Netdump::fileDump(File& outfile, const Filter nf)
+void Netdump::fileDump(File& outfile, const Filter nf, Format format)
 {
-
-    writePcapHeader(outfile);
-    setCallback([&outfile, this](const Packet & ndp)
+    dumpFormat = format;
+    if (format == Format::PCAPNG)
     {
-        fileDumpProcess(outfile, ndp);
-    }, nf);
+        writePcapngHeader(outfile);
+    }
+    else
+    {
+        writePcapHeader(outfile);
+    }
+    dumpFile = &outfile;
+    startRing(DumpTarget::FILE, nf, format);
 }
-void Netdump::tcpDump(WiFiServer &tcpDumpServer, const Filter nf)
+
+void Netdump::tcpDump(WiFiServer &tcpDumpServer, const Filter nf, Format format)
 {
+    // capture starts when a client connects
+    if (!startRing(DumpTarget::NONE, nf, format))
+    {
+        return;
+    }
+    schedule_function([&tcpDumpServer, this]()
+    {
+        tcpDumpLoop(tcpDumpServer);
+    });
+}
 
-    if (!packetBuffer)
+bool Netdump::startRing(DumpTarget target, const Filter nf, Format format)
+{
+    if (!ring.active() && !ring.begin(defaultRingSize, maxPcapLength))
+    {
+        return false;
+    }
+    ring.clear();
+    ring.resetCounters();
+    for (int i = 0; i < CaptureRing::maxInterfaces; i++)
     {
-        packetBuffer = new (std::nothrow) char[tcpBufferSize];
+        reportedDrops[i] = 0;
     }
-    bufferIndex = 0;
 
-    schedule_function([&tcpDumpServer, this, nf]()
+    setCallback(nullptr, nf);
+    dumpFormat = format;
+    tcpDumpPort = 0;
+    dumpTarget = target;
+    if (target == DumpTarget::PRINT || target == DumpTarget::FILE)
     {
-        tcpDumpLoop(tcpDumpServer, nf);
-    });
+        scheduleDrain();
+    }
+    return true;
 }
 
 void Netdump::capture(int netif_idx, const char* data, size_t len, int out, int success)
@@ -107,8 +144,30 @@ void Netdump::capture(int netif_idx, const char* data, size_t len, int out, int
     }
 }
 
+// IPv4 TCP segment from or to port, checked on the raw frame
+static bool isTcpPort(const char* data, size_t len, uint16_t port)
+{
+    const uint8_t* frame = reinterpret_cast<const uint8_t*>(data);
+    if (len < ETH_HDR_LEN + 20 || frame[12] != 0x08 || frame[13] != 0x00 || frame[ETH_HDR_LEN + 9] != 6)
+    {
+        return false;
+    }
+    size_t tcp = ETH_HDR_LEN + ((frame[ETH_HDR_LEN] & 0x0f) << 2);
+    if (len < tcp + 4)
+    {
+        return false;
+    }
+    uint16_t sourcePort = (frame[tcp] << 8) | frame[tcp + 1];
+    uint16_t destinationPort = (frame[tcp + 2] << 8) | frame[tcp + 3];
+    return sourcePort == port || destinationPort == port;
+}
+
 void Netdump::netdumpCapture(int netif_idx, const char* data, size_t len, int out, int success)
 {
+    if (!compiledFilter.empty() && !compiledFilter.match(data, len))
+    {
+        return;
+    }
     if (netDumpCallback)
     {
         Packet np(millis(), netif_idx, data, len, out, success);
@@ -118,101 +177,244 @@ void Netdump::netdumpCapture(int netif_idx, const char* data, size_t len, int ou
         }
         netDumpCallback(np);
     }
+    else if (dumpTarget != DumpTarget::NONE)
+    {
+        if (tcpDumpPort && isTcpPort(data, len, tcpDumpPort))
+        {
+            // skip myself
+            return;
+        }
+        if (netDumpFilter)
+        {
+            Packet np(millis(), netif_idx, data, len, out, success);
+            if (!netDumpFilter(np))
+            {
+                return;
+            }
+        }
+        // bounded copy only, formatting and output are done from the loop
+        ring.push(netif_idx, data, len, out, success);
+    }
+}
+
+void Netdump::scheduleDrain()
+{
+    if (!drainScheduled)
+    {
+        drainScheduled = schedule_function([this]()
+        {
+            drainLoop();
+        });
+    }
+}
+
+void Netdump::drainLoop()
+{
+    drainScheduled = false;
+    if (dumpTarget == DumpTarget::PRINT || dumpTarget == DumpTarget::FILE)
+    {
+        drainRing();
+        scheduleDrain();
+    }
+}
+
+void Netdump::drainRing()
+{
+    while (const CaptureRing::Record* record = ring.peek())
+    {
+        switch (dumpTarget)
+        {
+        case DumpTarget::PRINT:
+        {
+            Packet np(record->msec, record->netif_idx, record->data(), record->capturedLength, record->out, record->success);
+            printDumpProcess(*dumpPrint, dumpDetail, np);
+            break;
+        }
+        case DumpTarget::FILE:
+            writeRecord(*dumpFile, *record, false);
+            break;
+        case DumpTarget::TCP:
+            if (!writeRecord(tcpDumpClient, *record, true))
+            {
+                return; // retried on next loop
+            }
+            break;
+        default:
+            return;
+        }
+        ring.pop();
+    }
+
+    if (dumpFormat == Format::PCAPNG)
+    {
+        if (dumpTarget == DumpTarget::FILE)
+        {
+            writeStatistics(*dumpFile, false);
+        }
+        else if (dumpTarget == DumpTarget::TCP)
+        {
+            writeStatistics(tcpDumpClient, true);
+        }
+    }
 }
 
 void Netdump::writePcapHeader(Stream& s) const
 {
     uint32_t pcapHeader[6];
-    pcapHeader[0] = 0xa1b2c3d4;     // pcap magic number
+    pcapHeader[0] = pcapMagic;      // pcap magic number
     pcapHeader[1] = 0x00040002;     // pcap major/minor version
     pcapHeader[2] = 0;			     // pcap UTC correction in seconds
     pcapHeader[3] = 0;			     // pcap time stamp accuracy
-    pcapHeader[4] = maxPcapLength;  // pcap max packet length per record
+    pcapHeader[4] = ring.active() ? ring.getSnapLength() : maxPcapLength; // pcap max packet length per record
     pcapHeader[5] = 1;              // pacp data linkt type = ethernet
     s.write(reinterpret_cast<char*>(pcapHeader), 24);
 }
 
-void Netdump::printDumpProcess(Print& out, Packet::PacketDetail ndd, const Packet& np) const
+void Netdump::writePcapngHeader(Stream& s) const
 {
-    out.printf_P(PSTR("%8d %s"), np.getTime(), np.toString(ndd).c_str());
+    uint32_t sectionHeader[7];
+    sectionHeader[0] = 0x0a0d0d0a;  // section header block
+    sectionHeader[1] = 28;          // block length
+    sectionHeader[2] = 0x1a2b3c4d;  // byte order magic
+    sectionHeader[3] = 0x00000001;  // major/minor version 1.0
+    sectionHeader[4] = 0xffffffff;  // section length unknown
+    sectionHeader[5] = 0xffffffff;
+    sectionHeader[6] = 28;          // block length
+    s.write(reinterpret_cast<char*>(sectionHeader), 28);
+
+    // one interface description per netif_idx, in order
+    uint32_t interfaceDescription[5];
+    interfaceDescription[0] = 1;    // interface description block
+    interfaceDescription[1] = 20;   // block length
+    interfaceDescription[2] = 1;    // link type = ethernet, reserved
+    interfaceDescription[3] = ring.active() ? ring.getSnapLength() : maxPcapLength; // snap length
+    interfaceDescription[4] = 20;   // block length
+    for (int i = 0; i < CaptureRing::maxInterfaces; i++)
+    {
+        s.write(reinterpret_cast<char*>(interfaceDescription), 20);
+    }
 }
 
-void Netdump::fileDumpProcess(File& outfile, const Packet& np) const
+bool Netdump::writeRecord(Stream& s, const CaptureRing::Record& record, bool checkSpace)
 {
-    size_t incl_len = np.getPacketSize() > maxPcapLength ? maxPcapLength : np.getPacketSize();
-    uint32_t pcapHeader[4];
+    if (dumpFormat == Format::PCAP)
+    {
+        if (checkSpace && s.availableForWrite() < (int)record.pcapRecordLength())
+        {
+            return false;
+        }
+        s.write(record.pcapRecord(), record.pcapRecordLength());
+        return true;
+    }
 
-    struct timeval tv;
-    gettimeofday(&tv, nullptr);
-    pcapHeader[0] = tv.tv_sec;
-    pcapHeader[1] = tv.tv_usec;
-    pcapHeader[2] = incl_len;
-    pcapHeader[3] = np.getPacketSize();
-    outfile.write(reinterpret_cast<char*>(pcapHeader), 16); // pcap record header
+    size_t padding = (4 - (record.capturedLength & 3)) & 3;
+    uint32_t blockLength = 28 + record.capturedLength + padding + 16;
+    if (checkSpace && s.availableForWrite() < (int)blockLength)
+    {
+        return false;
+    }
 
-    outfile.write(np.rawData(), incl_len);
+    uint64_t timestamp = (uint64_t)record.sec * 1000000 + record.usec; // microseconds, the default resolution
+    uint32_t packetHeader[7];
+    packetHeader[0] = 6;            // enhanced packet block
+    packetHeader[1] = blockLength;
+    packetHeader[2] = record.netif_idx >= 0 && record.netif_idx < CaptureRing::maxInterfaces ? record.netif_idx : 0;
+    packetHeader[3] = timestamp >> 32;
+    packetHeader[4] = timestamp;
+    packetHeader[5] = record.capturedLength;
+    packetHeader[6] = record.packetLength;
+
+    uint32_t packetTrailer[4];
+    packetTrailer[0] = 0x00040002;  // option epb_flags, length 4
+    packetTrailer[1] = record.out ? 2 : 1; // outbound / inbound
+    packetTrailer[2] = 0;           // end of options
+    packetTrailer[3] = blockLength;
+
+    static const char zeroes[3] = { 0 };
+    s.write(reinterpret_cast<char*>(packetHeader), 28);
+    s.write(record.data(), record.capturedLength);
+    s.write(zeroes, padding);
+    s.write(reinterpret_cast<char*>(packetTrailer), 16);
+    return true;
 }
 
-void Netdump::tcpDumpProcess(const Packet& np)
+bool Netdump::writeStatistics(Stream& s, bool checkSpace)
 {
-    if (np.isTCP() && np.hasPort(tcpDumpClient.localPort()))
+    for (int i = 0; i < CaptureRing::maxInterfaces; i++)
     {
-        // skip myself
-        return;
-    }
-    size_t incl_len = np.getPacketSize() > maxPcapLength ? maxPcapLength : np.getPacketSize();
+        uint32_t drops = ring.getDropped(i);
+        if (drops == reportedDrops[i])
+        {
+            continue;
+        }
+        if (checkSpace && s.availableForWrite() < 40)
+        {
+            return false;
+        }
 
-    if (bufferIndex + 16 + incl_len < tcpBufferSize) // only add if enough space available
-    {
         struct timeval tv;
         gettimeofday(&tv, nullptr);
-        uint32_t* pcapHeader = reinterpret_cast<uint32_t*>(&packetBuffer[bufferIndex]);
-        pcapHeader[0] = tv.tv_sec;      // add pcap record header
-        pcapHeader[1] = tv.tv_usec;
-        pcapHeader[2] = incl_len;
-        pcapHeader[3] = np.getPacketSize();
-        bufferIndex += 16; // pcap header size
-        memcpy(&packetBuffer[bufferIndex], np.rawData(), incl_len);
-        bufferIndex += incl_len;
+        uint64_t timestamp = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+        uint32_t statistics[10];
+        statistics[0] = 5;          // interface statistics block
+        statistics[1] = 40;         // block length
+        statistics[2] = i;          // interface id
+        statistics[3] = timestamp >> 32;
+        statistics[4] = timestamp;
+        statistics[5] = 0x00080005; // option isb_ifdrop, length 8
+        statistics[6] = drops;
+        statistics[7] = 0;
+        statistics[8] = 0;          // end of options
+        statistics[9] = 40;         // block length
+        s.write(reinterpret_cast<char*>(statistics), 40);
+        reportedDrops[i] = drops;
     }
+    return true;
+}
 
-    if (bufferIndex && tcpDumpClient && tcpDumpClient.availableForWrite() >= (int)bufferIndex)
-    {
-        tcpDumpClient.write(packetBuffer, bufferIndex);
-        bufferIndex = 0;
-    }
+void Netdump::printDumpProcess(Print& out, Packet::PacketDetail ndd, const Packet& np) const
+{
+    out.printf_P(PSTR("%8d %s"), np.getTime(), np.toString(ndd).c_str());
 }
 
-void Netdump::tcpDumpLoop(WiFiServer &tcpDumpServer, const Filter nf)
+void Netdump::tcpDumpLoop(WiFiServer &tcpDumpServer)
 {
     if (tcpDumpServer.hasClient())
     {
         tcpDumpClient = tcpDumpServer.available();
         tcpDumpClient.setNoDelay(true);
+        tcpDumpPort = tcpDumpClient.localPort();
 
-        bufferIndex = 0;
-        writePcapHeader(tcpDumpClient);
-
-        setCallback([this](const Packet & ndp)
+        ring.clear();
+        for (int i = 0; i < CaptureRing::maxInterfaces; i++)
+        {
+            reportedDrops[i] = ring.getDropped(i);
+        }
+        if (dumpFormat == Format::PCAPNG)
         {
-            tcpDumpProcess(ndp);
-        }, nf);
+            writePcapngHeader(tcpDumpClient);
+        }
+        else
+        {
+            writePcapHeader(tcpDumpClient);
+        }
+        dumpTarget = DumpTarget::TCP;
     }
-    if (!tcpDumpClient || !tcpDumpClient.connected())
+    if (dumpTarget == DumpTarget::TCP && (!tcpDumpClient || !tcpDumpClient.connected()))
     {
-        setCallback(nullptr);
+        dumpTarget = DumpTarget::NONE;
+        tcpDumpPort = 0;
     }
-    if (bufferIndex && tcpDumpClient && tcpDumpClient.availableForWrite() >= (int)bufferIndex)
+    if (dumpTarget == DumpTarget::TCP)
     {
-        tcpDumpClient.write(packetBuffer, bufferIndex);
-        bufferIndex = 0;
+        drainRing();
     }
 
     if (tcpDumpServer.status() != CLOSED)
     {
-        schedule_function([&tcpDumpServer, this, nf]()
+        schedule_function([&tcpDumpServer, this]()
         {
-            tcpDumpLoop(tcpDumpServer, nf);
+            tcpDumpLoop(tcpDumpServer);
         });
     }
 }
@@ -27,6 +27,8 @@
 #include <lwipopts.h>
 #include <FS.h>
 #include "NetdumpPacket.h"
+#include "NetdumpRing.h"
+#include "NetdumpFilter.h"
 #include <ESP8266WiFi.h>
 #include "CallBackList.h"
 
@@ -43,6 +45,12 @@ public:
     using Callback = std::function<void(const Packet&)>;
     using LwipCallback = std::function<void(int, const char*, int, int, int)>;
 
+    enum class Format
+    {
+        PCAP,
+        PCAPNG
+    };
+
     Netdump();
     ~Netdump();
 
@@ -51,12 +59,42 @@ public:
     void setFilter(const Filter nf);
     void reset();
 
-    void printDump(Print& out, Packet::PacketDetail ndd, const Filter nf = nullptr);
-    void fileDump(File& outfile, const Filter nf = nullptr);
-    void tcpDump(WiFiServer &tcpDumpServer, const Filter nf = nullptr);
+    // tcpdump-like expression (see NetdumpFilter.h), matched on the raw frame in the
+    // capture hook before the Filter and before any copy, for all outputs.
+    // Returns false on syntax error, nullptr or "" removes it.
+    bool setFilterExpression(const char* expression);
+
+    // printDump, fileDump and tcpDump copy packets into a preallocated ring from the
+    // capture hook, and write them out from the loop. The ring is allocated on first
+    // use with defaultRingSize bytes and maxPcapLength snap length, unless set here.
+    bool setCaptureBuffer(size_t ringSize, uint16_t snapLength = maxPcapLength);
 
+    void printDump(Print& out, Packet::PacketDetail ndd, const Filter nf = nullptr);
+    void fileDump(File& outfile, const Filter nf = nullptr, Format format = Format::PCAP);
+    void tcpDump(WiFiServer &tcpDumpServer, const Filter nf = nullptr, Format format = Format::PCAP);
+
+    // Packets stored in the ring, and packets lost because it was full
+    uint32_t getCaptured() const
+    {
+        return ring.getCaptured();
+    }
+    uint32_t getDropped() const
+    {
+        return ring.getDropped();
+    }
+
+    static constexpr size_t defaultRingSize = 4096;
+    static constexpr uint16_t maxPcapLength = 1024;
 
 private:
+    enum class DumpTarget
+    {
+        NONE,
+        PRINT,
+        FILE,
+        TCP
+    };
+
     Callback netDumpCallback = nullptr;
     Filter   netDumpFilter   = nullptr;
 
@@ -66,19 +104,32 @@ private:
 
     void netdumpCapture(int netif_idx, const char* data, size_t len, int out, int success);
 
+    bool startRing(DumpTarget target, const Filter nf, Format format);
+    void scheduleDrain();
+    void drainLoop();
+    void drainRing();
+
     void printDumpProcess(Print& out, Packet::PacketDetail ndd, const Packet& np) const;
-    void fileDumpProcess(File& outfile, const Packet& np) const;
-    void tcpDumpProcess(const Packet& np);
-    void tcpDumpLoop(WiFiServer &tcpDumpServer, const Filter nf);
+    void tcpDumpLoop(WiFiServer &tcpDumpServer);
 
     void writePcapHeader(Stream& s) const;
+    void writePcapngHeader(Stream& s) const;
+    bool writeRecord(Stream& s, const CaptureRing::Record& record, bool checkSpace);
+    bool writeStatistics(Stream& s, bool checkSpace);
+
+    CompiledFilter compiledFilter;
+    CaptureRing ring;
+    DumpTarget dumpTarget = DumpTarget::NONE;
+    Format dumpFormat = Format::PCAP;
+    Print* dumpPrint = nullptr;
+    Packet::PacketDetail dumpDetail = Packet::PacketDetail::NONE;
+    File* dumpFile = nullptr;
+    bool drainScheduled = false;
+    uint32_t reportedDrops[CaptureRing::maxInterfaces] = { 0 };
 
     WiFiClient tcpDumpClient;
-    char* packetBuffer = nullptr;
-    size_t bufferIndex = 0;
+    uint16_t tcpDumpPort = 0; // local port of tcpDumpClient, whose own packets are not captured
 
-    static constexpr int tcpBufferSize = 2048;
-    static constexpr int maxPcapLength = 1024;
     static constexpr uint32_t pcapMagic = 0xa1b2c3d4;
 };
 
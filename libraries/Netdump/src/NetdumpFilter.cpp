@@ -0,0 +1,578 @@
+/*
+    NetDump library - tcpdump-like packet logger facility
+
+    Copyright (c) 2019 Herman Reintke. All rights reserved.
+    This file is part of the esp8266 core for Arduino environment.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "NetdumpFilter.h"
+#include "NetdumpPacket.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace NetCapture
+{
+
+namespace
+{
+
+// The program is in postfix order: every instruction pushes one bit on the
+// evaluation stack, AND and OR pop two, NOT pops one.
+enum Opcode : uint8_t
+{
+    ETHERTYPE,
+    IPPROTO,
+    HOST,
+    PORT,
+    LOAD,
+    LENGTH,
+    AND,
+    OR,
+    NOT
+};
+
+enum Direction : uint8_t
+{
+    SRC = 1,
+    DST = 2,
+    SRC_OR_DST = SRC | DST
+};
+
+enum Base : uint8_t
+{
+    ETHER,
+    IP,
+    TCP,
+    UDP,
+    ICMP
+};
+
+enum Relation : uint8_t
+{
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE
+};
+
+constexpr uint16_t ethTypeIPv4 = 0x0800;
+constexpr uint16_t ethTypeARP  = 0x0806;
+constexpr uint16_t ethTypeIPv6 = 0x86dd;
+
+constexpr uint8_t protoICMP   = 1;
+constexpr uint8_t protoIGMP   = 2;
+constexpr uint8_t protoTCP    = 6;
+constexpr uint8_t protoUDP    = 17;
+constexpr uint8_t protoICMPv6 = 58;
+
+inline uint32_t load(const uint8_t* p, uint8_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return p[0];
+    case 2:
+        return (p[0] << 8) | p[1];
+    default:
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | (p[2] << 8) | p[3];
+    }
+}
+
+inline bool compare(uint32_t a, uint8_t relation, uint32_t b)
+{
+    switch (relation)
+    {
+    case EQ:
+        return a == b;
+    case NE:
+        return a != b;
+    case LT:
+        return a < b;
+    case LE:
+        return a <= b;
+    case GT:
+        return a > b;
+    default:
+        return a >= b;
+    }
+}
+
+} // namespace
+
+class CompiledFilter::Parser
+{
+public:
+    Parser(const char* expression, std::vector<Instruction>& program)
+        : start(expression), cursor(expression), program(program)
+    {
+        next();
+    }
+
+    bool parse()
+    {
+        if (tokenLength == 0)
+        {
+            return true; // empty expression matches everything
+        }
+        return parseOr() && tokenLength == 0;
+    }
+
+    size_t position() const
+    {
+        return token - start;
+    }
+
+private:
+    void next()
+    {
+        while (*cursor == ' ' || *cursor == '\t')
+        {
+            cursor++;
+        }
+        token = cursor;
+        if (isWordChar(*cursor))
+        {
+            while (isWordChar(*cursor))
+            {
+                cursor++;
+            }
+        }
+        else if (*cursor)
+        {
+            // two character operators, then single characters
+            static const char* const pairs[] = { "&&", "||", "==", "!=", "<=", ">=" };
+            bool pair = false;
+            for (const char* p : pairs)
+            {
+                pair |= cursor[0] == p[0] && cursor[1] == p[1];
+            }
+            cursor += pair ? 2 : 1;
+        }
+        tokenLength = cursor - token;
+    }
+
+    static bool isWordChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '/' || c == '_';
+    }
+
+    bool is(const char* word) const
+    {
+        return tokenLength == strlen(word) && strncmp(token, word, tokenLength) == 0;
+    }
+
+    bool accept(const char* word)
+    {
+        if (!is(word))
+        {
+            return false;
+        }
+        next();
+        return true;
+    }
+
+    bool number(uint32_t& value)
+    {
+        char buffer[16];
+        if (tokenLength == 0 || tokenLength >= sizeof(buffer) || token[0] < '0' || token[0] > '9')
+        {
+            return false;
+        }
+        memcpy(buffer, token, tokenLength);
+        buffer[tokenLength] = 0;
+        char* end;
+        value = strtoul(buffer, &end, 0);
+        if (*end)
+        {
+            return false;
+        }
+        next();
+        return true;
+    }
+
+    // a.b.c.d, or a.b.c.d/bits when prefix is set
+    bool address(uint32_t& value, uint32_t& mask, bool prefix)
+    {
+        const char* p = token;
+        const char* end = token + tokenLength;
+        value = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            uint32_t octet = 0;
+            const char* digits = p;
+            while (p < end && *p >= '0' && *p <= '9' && p - digits < 3)
+            {
+                octet = octet * 10 + (*p++ - '0');
+            }
+            if (p == digits || octet > 255 || (i < 3 && (p == end || *p++ != '.')))
+            {
+                return false;
+            }
+            value = (value << 8) | octet;
+        }
+        mask = 0xffffffff;
+        if (prefix && p < end && *p == '/')
+        {
+            uint32_t bits = 0;
+            const char* digits = ++p;
+            while (p < end && *p >= '0' && *p <= '9' && p - digits < 2)
+            {
+                bits = bits * 10 + (*p++ - '0');
+            }
+            if (p == digits || bits > 32)
+            {
+                return false;
+            }
+            mask = bits ? 0xffffffff << (32 - bits) : 0;
+        }
+        if (p != end || (value & ~mask))
+        {
+            return false;
+        }
+        next();
+        return true;
+    }
+
+    bool relation(uint8_t& r)
+    {
+        static const char* const relations[] = { "=", "!=", "<", "<=", ">", ">=" };
+        if (is("=="))
+        {
+            r = EQ;
+            next();
+            return true;
+        }
+        for (uint8_t i = 0; i < sizeof(relations) / sizeof(relations[0]); i++)
+        {
+            if (is(relations[i]))
+            {
+                r = i;
+                next();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool emit(uint8_t opcode, uint8_t base = 0, uint32_t value = 0, uint32_t mask = 0xffffffff,
+              uint16_t offset = 0, uint8_t size = 0, uint8_t relation = EQ)
+    {
+        // AND and OR pop two and push one, NOT pops one and pushes one
+        depth += opcode == AND || opcode == OR ? -1 : opcode == NOT ? 0 : 1;
+        if (depth > (int)maxDepth)
+        {
+            return false;
+        }
+        program.push_back(Instruction{ opcode, base, size, relation, offset, mask, value });
+        return true;
+    }
+
+    bool parseOr()
+    {
+        if (!parseAnd())
+        {
+            return false;
+        }
+        while (accept("or") || accept("||"))
+        {
+            if (!parseAnd() || !emit(OR))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseAnd()
+    {
+        if (!parseNot())
+        {
+            return false;
+        }
+        while (accept("and") || accept("&&"))
+        {
+            if (!parseNot() || !emit(AND))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parseNot()
+    {
+        // A run of negations is one NOT or none, without recursing per word
+        bool negate = false;
+        while (accept("not") || accept("!"))
+        {
+            negate = !negate;
+        }
+        return parsePrimitive() && (!negate || emit(NOT));
+    }
+
+    bool parseDirected(uint8_t protocol)
+    {
+        uint8_t direction = SRC_OR_DST;
+        if (accept("src"))
+        {
+            direction = SRC;
+        }
+        else if (accept("dst"))
+        {
+            direction = DST;
+        }
+
+        uint32_t value, mask;
+        if (protocol == 0 && accept("host"))
+        {
+            return address(value, mask, false) && emit(HOST, direction, value, mask);
+        }
+        if (protocol == 0 && accept("net"))
+        {
+            return address(value, mask, true) && emit(HOST, direction, value, mask);
+        }
+        if (accept("port"))
+        {
+            if (!number(value) || value > 0xffff || !emit(PORT, direction, value))
+            {
+                return false;
+            }
+            return protocol == 0 || (emit(IPPROTO, 0, protocol) && emit(AND));
+        }
+        return false;
+    }
+
+    // base "[" offset [":" size] "]" ["&" mask] relation value
+    bool parseLoad(uint8_t base)
+    {
+        uint32_t offset, size = 1, mask = 0xffffffff, value;
+        uint8_t r;
+        if (!number(offset) || offset > 0xffff)
+        {
+            return false;
+        }
+        if (accept(":") && (!number(size) || (size != 1 && size != 2 && size != 4)))
+        {
+            return false;
+        }
+        if (!accept("]"))
+        {
+            return false;
+        }
+        if (accept("&") && !number(mask))
+        {
+            return false;
+        }
+        return relation(r) && number(value) && emit(LOAD, base, value, mask, offset, size, r);
+    }
+
+    bool parsePrimitive()
+    {
+        if (accept("("))
+        {
+            // Each level recurses through the whole grammar, bound the stack used
+            if (++nesting > (int)maxNesting)
+            {
+                return false;
+            }
+            bool ok = parseOr() && accept(")");
+            nesting--;
+            return ok;
+        }
+        if (is("src") || is("dst") || is("host") || is("net") || is("port"))
+        {
+            return parseDirected(0);
+        }
+        if (accept("len"))
+        {
+            uint8_t r;
+            uint32_t value;
+            return relation(r) && number(value) && emit(LENGTH, 0, value, 0xffffffff, 0, 0, r);
+        }
+
+        struct Protocol
+        {
+            const char* name;
+            int8_t base;       // -1 when loads are not supported
+            uint16_t etherType;
+            uint8_t ipProtocol;
+        };
+        static const Protocol protocols[] =
+        {
+            { "ether", ETHER, 0, 0 },
+            { "arp", -1, ethTypeARP, 0 },
+            { "ip", IP, ethTypeIPv4, 0 },
+            { "ip6", -1, ethTypeIPv6, 0 },
+            { "tcp", TCP, 0, protoTCP },
+            { "udp", UDP, 0, protoUDP },
+            { "icmp", ICMP, 0, protoICMP },
+            { "igmp", -1, 0, protoIGMP },
+        };
+        for (const Protocol& protocol : protocols)
+        {
+            if (!accept(protocol.name))
+            {
+                continue;
+            }
+            if (protocol.base >= 0 && accept("["))
+            {
+                return parseLoad(protocol.base);
+            }
+            if (protocol.ipProtocol == protoTCP || protocol.ipProtocol == protoUDP)
+            {
+                if (is("src") || is("dst") || is("port"))
+                {
+                    return parseDirected(protocol.ipProtocol);
+                }
+            }
+            if (protocol.etherType)
+            {
+                return emit(ETHERTYPE, 0, protocol.etherType);
+            }
+            if (protocol.ipProtocol == protoICMP)
+            {
+                return emit(IPPROTO, 0, protoICMP) && emit(IPPROTO, 0, protoICMPv6) && emit(OR);
+            }
+            if (protocol.ipProtocol)
+            {
+                return emit(IPPROTO, 0, protocol.ipProtocol);
+            }
+            return false; // "ether" without a load
+        }
+        return false;
+    }
+
+    const char* start;
+    const char* cursor;
+    const char* token;
+    size_t tokenLength;
+    std::vector<Instruction>& program;
+    int depth = 0;
+    int nesting = 0;
+};
+
+bool CompiledFilter::compile(const char* expression)
+{
+    if (!expression)
+    {
+        clear();
+        return true;
+    }
+    std::vector<Instruction> compiled;
+    Parser parser(expression, compiled);
+    if (!parser.parse())
+    {
+        errorAt = parser.position();
+        return false;
+    }
+    compiled.shrink_to_fit();
+    program.swap(compiled);
+    errorAt = 0;
+    return true;
+}
+
+void CompiledFilter::clear()
+{
+    std::vector<Instruction>().swap(program);
+    errorAt = 0;
+}
+
+bool CompiledFilter::match(const char* data, size_t length) const
+{
+    if (program.empty())
+    {
+        return true;
+    }
+
+    // derived once per frame, instructions only compare
+    const uint8_t* frame = reinterpret_cast<const uint8_t*>(data);
+    uint16_t etherType = length >= ETH_HDR_LEN ? load(frame + 12, 2) : 0;
+    bool ipv4 = etherType == ethTypeIPv4 && length >= ETH_HDR_LEN + 20;
+    bool ipv6 = etherType == ethTypeIPv6 && length >= ETH_HDR_LEN + 40;
+    uint8_t ipProtocol = ipv4 ? frame[ETH_HDR_LEN + 9] : ipv6 ? frame[ETH_HDR_LEN + 6] : 0;
+    size_t transport = ipv4 ? ETH_HDR_LEN + ((frame[ETH_HDR_LEN] & 0x0f) << 2) : ETH_HDR_LEN + 40;
+    bool ports = (ipProtocol == protoTCP || ipProtocol == protoUDP) && length >= transport + 4;
+
+    uint32_t stack = 0;
+    for (const Instruction& i : program)
+    {
+        bool result;
+        switch (i.opcode)
+        {
+        case ETHERTYPE:
+            result = etherType == i.value;
+            break;
+        case IPPROTO:
+            result = (ipv4 || ipv6) && ipProtocol == i.value;
+            break;
+        case HOST:
+            result = ipv4 && (((i.base & SRC) && (load(frame + ETH_HDR_LEN + 12, 4) & i.mask) == i.value)
+                              || ((i.base & DST) && (load(frame + ETH_HDR_LEN + 16, 4) & i.mask) == i.value));
+            break;
+        case PORT:
+            result = ports && (((i.base & SRC) && load(frame + transport, 2) == i.value)
+                               || ((i.base & DST) && load(frame + transport + 2, 2) == i.value));
+            break;
+        case LOAD:
+        {
+            size_t at = i.offset;
+            switch (i.base)
+            {
+            case ETHER:
+                result = true;
+                break;
+            case IP:
+                result = ipv4;
+                at += ETH_HDR_LEN;
+                break;
+            case TCP:
+            case UDP:
+                result = (ipv4 || ipv6) && ipProtocol == (i.base == TCP ? protoTCP : protoUDP);
+                at += transport;
+                break;
+            default:
+                result = (ipv4 && ipProtocol == protoICMP) || (ipv6 && ipProtocol == protoICMPv6);
+                at += transport;
+                break;
+            }
+            result = result && at + i.size <= length && compare(load(frame + at, i.size) & i.mask, i.relation, i.value);
+            break;
+        }
+        case LENGTH:
+            result = compare(length, i.relation, i.value);
+            break;
+        case AND:
+            result = (stack & 3) == 3;
+            stack >>= 2;
+            break;
+        case OR:
+            result = (stack & 3) != 0;
+            stack >>= 2;
+            break;
+        default: // NOT
+            result = !(stack & 1);
+            stack >>= 1;
+            break;
+        }
+        stack = (stack << 1) | result;
+    }
+    return stack & 1;
+}
+
+} // namespace NetCapture
@@ -0,0 +1,100 @@
+/*
+    NetDump library - tcpdump-like packet logger facility
+
+    Copyright (c) 2019 Herman Reintke. All rights reserved.
+    This file is part of the esp8266 core for Arduino environment.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __NETDUMP_FILTER_H
+#define __NETDUMP_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace NetCapture
+{
+
+// tcpdump-like filter expression, compiled once and matched on raw ethernet frames.
+//
+//   expression := expression ("or" | "||") expression
+//               | expression ("and" | "&&") expression
+//               | ("not" | "!") expression
+//               | "(" expression ")"
+//               | primitive
+//   primitive  := ["src" | "dst"] "host" a.b.c.d
+//               | ["src" | "dst"] "net" a.b.c.d["/"bits]
+//               | [proto] ["src" | "dst"] "port" number
+//               | "arp" | "ip" | "ip6" | "tcp" | "udp" | "icmp" | "igmp"
+//               | base "[" offset [":" 1|2|4] "]" ["&" mask] relation value
+//               | "len" relation value
+//   base       := "ether" | "ip" | "tcp" | "udp" | "icmp"
+//   relation   := "=" | "==" | "!=" | "<" | "<=" | ">" | ">="
+//
+// "and" binds tighter than "or", parentheses nest at most maxNesting deep. Numbers
+// are decimal or 0x hexadecimal, multi-byte loads are big endian. host and net match
+// IPv4 addresses, port matches TCP and UDP over IPv4 and IPv6. Examples: "tcp port 80",
+// "host 10.0.0.1 and not arp", "tcp[13] & 2 != 0", "udp and (port 53 or port 5353)".
+class CompiledFilter
+{
+public:
+
+    // Returns false on syntax error, the previous program is then kept
+    // and errorPosition() is the offset of the unexpected token.
+    bool compile(const char* expression);
+    void clear();
+
+    bool empty() const
+    {
+        return program.empty();
+    }
+    size_t size() const
+    {
+        return program.size();
+    }
+    size_t errorPosition() const
+    {
+        return errorAt;
+    }
+
+    bool match(const char* data, size_t length) const;
+
+    static constexpr size_t maxDepth = 32; // evaluation stack, one bit per entry
+    static constexpr size_t maxNesting = 16; // parentheses, each level recurses in the parser
+
+private:
+
+    struct Instruction
+    {
+        uint8_t  opcode;
+        uint8_t  base;     // LOAD: frame area, HOST/PORT: direction
+        uint8_t  size;     // LOAD: 1, 2 or 4 bytes
+        uint8_t  relation;
+        uint16_t offset;
+        uint32_t mask;
+        uint32_t value;
+    };
+
+    class Parser;
+
+    std::vector<Instruction> program;
+    size_t errorAt = 0;
+};
+
+} // namespace NetCapture
+
+#endif /* __NETDUMP_FILTER_H */
@@ -0,0 +1,162 @@
+/*
+    NetDump library - tcpdump-like packet logger facility
+
+    Copyright (c) 2019 Herman Reintke. All rights reserved.
+    This file is part of the esp8266 core for Arduino environment.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "NetdumpRing.h"
+#include <string.h>
+#include <sys/time.h>
+#include <new>
+#include <Arduino.h>
+
+namespace NetCapture
+{
+
+CaptureRing::~CaptureRing()
+{
+    end();
+}
+
+bool CaptureRing::begin(size_t ringSize, uint16_t newSnapLength)
+{
+    end();
+    ringSize &= ~3;
+    if (ringSize < recordSize(newSnapLength) + sizeof(Record))
+    {
+        return false;
+    }
+    buffer = new (std::nothrow) char[ringSize];
+    if (!buffer)
+    {
+        return false;
+    }
+    size = ringSize;
+    snapLength = newSnapLength;
+    head = tail = 0;
+    resetCounters();
+    return true;
+}
+
+void CaptureRing::end()
+{
+    char* oldBuffer = buffer;
+    buffer = nullptr; // push() is a no-op from now on
+    size = 0;
+    head = tail = 0;
+    delete[] oldBuffer;
+}
+
+void CaptureRing::resetCounters()
+{
+    captured = 0;
+    dropped = 0;
+    for (int i = 0; i < maxInterfaces; i++)
+    {
+        interfaceDropped[i] = 0;
+    }
+}
+
+bool CaptureRing::push(int netif_idx, const char* data, size_t len, int out, int success)
+{
+    if (!buffer)
+    {
+        return false;
+    }
+
+    size_t capturedLength = len > snapLength ? snapLength : len;
+    size_t needed = recordSize(capturedLength);
+    size_t h = head;
+    size_t t = tail;
+    size_t at;
+
+    // head == tail means empty, so a record never fills the last free byte
+    if (h >= t && (needed < size - h || (needed == size - h && t > 0)))
+    {
+        at = h;
+    }
+    else if (h >= t && needed < t)
+    {
+        if (size - h >= sizeof(Record))
+        {
+            reinterpret_cast<Record*>(buffer + h)->capturedLength = wrapMarker;
+        }
+        at = 0;
+    }
+    else if (h < t && needed < t - h)
+    {
+        at = h;
+    }
+    else
+    {
+        dropped++;
+        if (netif_idx >= 0 && netif_idx < maxInterfaces)
+        {
+            interfaceDropped[netif_idx]++;
+        }
+        return false;
+    }
+
+    Record* record = reinterpret_cast<Record*>(buffer + at);
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    record->msec = millis();
+    record->netif_idx = netif_idx;
+    record->out = out;
+    record->success = success;
+    record->reserved = 0;
+    record->sec = tv.tv_sec;
+    record->usec = tv.tv_usec;
+    record->capturedLength = capturedLength;
+    record->packetLength = len;
+    memcpy(buffer + at + sizeof(Record), data, capturedLength);
+
+    size_t next = at + needed;
+    head = next == size ? 0 : next;
+    captured++;
+    return true;
+}
+
+const CaptureRing::Record* CaptureRing::peek()
+{
+    if (!buffer || tail == head)
+    {
+        return nullptr;
+    }
+    if (size - tail < sizeof(Record) || reinterpret_cast<Record*>(buffer + tail)->capturedLength == wrapMarker)
+    {
+        tail = 0;
+        if (tail == head)
+        {
+            return nullptr;
+        }
+    }
+    return reinterpret_cast<Record*>(buffer + tail);
+}
+
+void CaptureRing::pop()
+{
+    const Record* record = peek();
+    if (record)
+    {
+        size_t next = tail + recordSize(record->capturedLength);
+        tail = next == size ? 0 : next;
+    }
+}
+
+} // namespace NetCapture
@@ -0,0 +1,127 @@
+/*
+    NetDump library - tcpdump-like packet logger facility
+
+    Copyright (c) 2019 Herman Reintke. All rights reserved.
+    This file is part of the esp8266 core for Arduino environment.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __NETDUMP_RING_H
+#define __NETDUMP_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace NetCapture
+{
+
+// Preallocated single producer / single consumer packet ring.
+// push() is called from the lwIP capture hook and only moves head,
+// peek() and pop() are called from the loop and only move tail.
+class CaptureRing
+{
+public:
+
+    // The last 16 bytes of a record header are a pcap record header,
+    // so a pcap record is written from &sec with a single write.
+    struct Record
+    {
+        uint32_t msec;
+        int8_t   netif_idx;
+        uint8_t  out;
+        uint8_t  success;
+        uint8_t  reserved;
+        uint32_t sec;
+        uint32_t usec;
+        uint32_t capturedLength;
+        uint32_t packetLength;
+
+        const char* data() const
+        {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+        const char* pcapRecord() const
+        {
+            return reinterpret_cast<const char*>(&sec);
+        }
+        size_t pcapRecordLength() const
+        {
+            return 16 + capturedLength;
+        }
+    };
+
+    CaptureRing() = default;
+    ~CaptureRing();
+
+    bool begin(size_t ringSize, uint16_t snapLength);
+    void end();
+    bool active() const
+    {
+        return buffer != nullptr;
+    }
+
+    bool push(int netif_idx, const char* data, size_t len, int out, int success);
+
+    const Record* peek();
+    void pop();
+    void clear()
+    {
+        tail = head; // drop everything stored so far, from the consumer side
+    }
+
+    uint16_t getSnapLength() const
+    {
+        return snapLength;
+    }
+    uint32_t getCaptured() const
+    {
+        return captured;
+    }
+    uint32_t getDropped() const
+    {
+        return dropped;
+    }
+    uint32_t getDropped(int netif_idx) const
+    {
+        return netif_idx >= 0 && netif_idx < maxInterfaces ? interfaceDropped[netif_idx] : 0;
+    }
+    void resetCounters();
+
+    static constexpr int maxInterfaces = 2;
+
+private:
+    static size_t recordSize(size_t capturedLength)
+    {
+        return (sizeof(Record) + capturedLength + 3) & ~3;
+    }
+
+    char* buffer = nullptr;
+    size_t size = 0;
+    uint16_t snapLength = 0;
+
+    volatile size_t head = 0; // next record written, only moved by push()
+    volatile size_t tail = 0; // next record read, only moved by peek()/pop()
+
+    volatile uint32_t captured = 0;
+    volatile uint32_t dropped = 0;
+    volatile uint32_t interfaceDropped[maxInterfaces] = { 0 };
+
+    static constexpr uint32_t wrapMarker = 0xffffffff;
+};
+
+} // namespace NetCapture
+
+#endif /* __NETDUMP_RING_H */
@@ -0,0 +1,190 @@
+/*
+ PackedFS.cpp - Read-only packed image filesystem for the ESP8266
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <pgmspace.h>
+#include "PackedFS.h"
+#include "debug.h"
+#include "flash_hal.h"
+
+namespace packedfs_impl {
+
+bool PackedFSImpl::begin() {
+    if (_mounted) {
+        return true;
+    }
+    if (!_image && !_size) {
+        DEBUGV("PackedFS: no image configured\n");
+        return false;
+    }
+    _count = 0;
+    _imageSize = _image ? sizeof(PackedFSHeader) : _size; // Bounds for reading the header
+    PackedFSHeader h;
+    if (!_read(0, &h, sizeof(h))) {
+        return false;
+    }
+    if ((h.magic != magic) || (h.version != version) || (h.entrySize != sizeof(PackedFSEntry)) ||
+        (h.imageSize < sizeof(h) + h.count * sizeof(PackedFSEntry)) || (!_image && (h.imageSize > _size))) {
+        DEBUGV("PackedFS: bad image magic=%08x version=%u entry=%u size=%u\n",
+               h.magic, h.version, h.entrySize, h.imageSize);
+        _imageSize = 0;
+        return false;
+    }
+    _count = h.count;
+    _imageSize = h.imageSize;
+    _mounted = true;
+    return true;
+}
+
+FileImplPtr PackedFSImpl::open(const char* path, OpenMode openMode, AccessMode accessMode) {
+    if (!_mounted || !path) {
+        DEBUGV("PackedFSImpl::open() called on unmounted FS or with no path\n");
+        return FileImplPtr();
+    }
+    if ((accessMode & AM_WRITE) || (openMode & (OM_CREATE | OM_APPEND | OM_TRUNCATE))) {
+        DEBUGV("PackedFSImpl::open() called for writing on read-only FS\n");
+        return FileImplPtr();
+    }
+    char name[nameMax];
+    if (!_normalize(path, name)) {
+        return FileImplPtr();
+    }
+    PackedFSEntry e;
+    if (_find(name, e)) {
+        return std::make_shared<PackedFSFileImpl>(this, name, &e);
+    }
+    if (_isDir(name)) {
+        // Like LittleFS, a directory opens as a File which can only be listed
+        return std::make_shared<PackedFSFileImpl>(this, name, nullptr);
+    }
+    return FileImplPtr();
+}
+
+DirImplPtr PackedFSImpl::openDir(const char* path) {
+    if (!_mounted || !path) {
+        return DirImplPtr();
+    }
+    char prefix[nameMax];
+    if (!_normalize(path, prefix)) {
+        return DirImplPtr();
+    }
+    size_t len = strlen(prefix);
+    if (len) {
+        if (len + 2 > nameMax) {
+            return DirImplPtr();
+        }
+        prefix[len] = '/';
+        prefix[len + 1] = 0;
+    }
+    return std::make_shared<PackedFSDirImpl>(this, prefix);
+}
+
+bool PackedFSImpl::_read(uint32_t offset, void* dst, size_t size) const {
+    if ((offset > _imageSize) || (size > _imageSize - offset)) {
+        return false;
+    }
+    if (_image) {
+        memcpy_P(dst, _image + offset, size);
+        return true;
+    }
+    return flash_hal_read(_start + offset, size, static_cast<uint8_t*>(dst)) == FLASH_HAL_OK;
+}
+
+const uint8_t* PackedFSImpl::_map(uint32_t offset, size_t size) const {
+    if ((offset > _imageSize) || (size > _imageSize - offset)) {
+        return nullptr;
+    }
+    return _image ? _image + offset : flash_hal_map(_start + offset, size);
+}
+
+bool PackedFSImpl::_entry(uint32_t index, PackedFSEntry& e) const {
+    return (index < _count) && _read(sizeof(PackedFSHeader) + index * sizeof(PackedFSEntry), &e, sizeof(e));
+}
+
+bool PackedFSImpl::_name(const PackedFSEntry& e, char* name) const {
+    size_t size = std::min<size_t>(nameMax, _imageSize - std::min(e.name, _imageSize));
+    if (!size || !_read(e.name, name, size)) {
+        return false;
+    }
+    name[size - 1] = 0; // mkpackfs.py refuses longer names
+    return true;
+}
+
+uint32_t PackedFSImpl::_lowerBound(const char* name) const {
+    uint32_t lo = 0;
+    uint32_t hi = _count;
+    PackedFSEntry e;
+    char entryName[nameMax];
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (!_entry(mid, e) || !_name(e, entryName)) {
+            return _count;
+        }
+        if (strcmp(entryName, name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool PackedFSImpl::_find(const char* name, PackedFSEntry& e) const {
+    char entryName[nameMax];
+    uint32_t index = _lowerBound(name);
+    return _entry(index, e) && _name(e, entryName) && !strcmp(entryName, name);
+}
+
+bool PackedFSImpl::_isDir(const char* name) const {
+    // The root always exists, other directories when some entry lives below them
+    size_t len = strlen(name);
+    if (!len) {
+        return true;
+    }
+    char prefix[nameMax + 1];
+    memcpy(prefix, name, len);
+    prefix[len] = '/';
+    prefix[len + 1] = 0;
+    PackedFSEntry e;
+    char entryName[nameMax];
+    uint32_t index = _lowerBound(prefix);
+    return _entry(index, e) && _name(e, entryName) && !strncmp(entryName, prefix, len + 1);
+}
+
+bool PackedFSImpl::_normalize(const char* path, char* name) {
+    while (*path == '/') {
+        path++;
+    }
+    size_t len = strlen(path);
+    while (len && (path[len - 1] == '/')) {
+        len--;
+    }
+    if (len >= nameMax) {
+        return false;
+    }
+    memcpy(name, path, len);
+    name[len] = 0;
+    return true;
+}
+
+}; // namespace
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_PACKEDFS)
+FS PackedFS = FS(FSImplPtr(new packedfs_impl::PackedFSImpl()));
+#endif
@@ -0,0 +1,435 @@
+/*
+ PackedFS.h - Read-only packed image filesystem for the ESP8266
+
+ An image made at build time by tools/mkpackfs.py holds a directory sorted
+ by path, so lookups are binary searches, followed by the file contents
+ stored whole and 4-byte aligned, so reads never walk pages and files can
+ be used in place from mapped flash.  The image is either linked into the
+ sketch as a PROGMEM array (it then follows OTA updates of the sketch) or
+ written to a free flash area, and it mounts alongside LittleFS or SPIFFS.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef __PACKEDFS_H
+#define __PACKEDFS_H
+
+#include <FS.h>
+#include <FSImpl.h>
+#include <debug.h>
+#include <flash_hal.h>
+
+using namespace fs;
+
+namespace packedfs_impl {
+
+class PackedFSFileImpl;
+class PackedFSDirImpl;
+
+// Image layout, all little endian:
+//   Header
+//   Entry[count], sorted by name (bytewise)
+//   names, NUL terminated, without leading slash
+//   contents, each starting 4-byte aligned
+struct PackedFSHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t count;
+    uint32_t imageSize;
+};
+
+struct PackedFSEntry {
+    uint32_t name;      // offsets from the start of the image
+    uint32_t data;
+    uint32_t size;
+    uint32_t mtime;
+    uint8_t  hash[8];   // leading bytes of the SHA-256 of the contents
+};
+
+class PackedFSConfig : public FSConfig
+{
+public:
+    static constexpr uint32_t FSId = 0x504b4653;
+    PackedFSConfig(const void* image = nullptr) : FSConfig(FSId, false), _image(image), _addr(0), _size(0) { }
+
+    // Image linked into the sketch, a PROGMEM array written by mkpackfs.py --header
+    PackedFSConfig setImage(const void* image) {
+        _image = image;
+        return *this;
+    }
+    // Image written to flash at addr, outside of the sketch and of the writable FS
+    PackedFSConfig setFlash(uint32_t addr, uint32_t size) {
+        _image = nullptr;
+        _addr = addr;
+        _size = size;
+        return *this;
+    }
+
+    const void* _image;
+    uint32_t    _addr;
+    uint32_t    _size;
+};
+
+class PackedFSImpl : public FSImpl
+{
+public:
+    static constexpr uint32_t magic = 0x53464b50; // "PKFS"
+    static constexpr uint16_t version = 1;
+    static constexpr size_t   nameMax = 64; // including terminating NUL
+
+    PackedFSImpl(uint32_t start = 0, uint32_t size = 0)
+        : _image(nullptr), _start(start), _size(size), _count(0), _imageSize(0), _mounted(false) { }
+
+    FileImplPtr open(const char* path, OpenMode openMode, AccessMode accessMode) override;
+    DirImplPtr openDir(const char* path) override;
+
+    bool exists(const char* path) override {
+        if (!_mounted || !path) {
+            return false;
+        }
+        char name[nameMax];
+        if (!_normalize(path, name)) {
+            return false;
+        }
+        PackedFSEntry e;
+        return _find(name, e) || _isDir(name);
+    }
+
+    bool info(FSInfo& info) override {
+        if (!_mounted) {
+            return false;
+        }
+        info.totalBytes = _imageSize;
+        info.usedBytes = _imageSize;
+        info.blockSize = 4;
+        info.pageSize = 4;
+        info.maxOpenFiles = 0; // Not limited, files are independent views of the image
+        info.maxPathLength = nameMax;
+        return true;
+    }
+
+    bool info64(FSInfo64& info64) override {
+        FSInfo i;
+        if (!info(i)) {
+            return false;
+        }
+        info64.blockSize     = i.blockSize;
+        info64.pageSize      = i.pageSize;
+        info64.maxOpenFiles  = i.maxOpenFiles;
+        info64.maxPathLength = i.maxPathLength;
+        info64.totalBytes    = i.totalBytes;
+        info64.usedBytes     = i.usedBytes;
+        return true;
+    }
+
+    // The image is read-only
+    bool rename(const char* pathFrom, const char* pathTo) override {
+        (void) pathFrom;
+        (void) pathTo;
+        return false;
+    }
+    bool remove(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool mkdir(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool rmdir(const char* path) override {
+        (void) path;
+        return false;
+    }
+    bool format() override {
+        return false;
+    }
+
+    bool setConfig(const FSConfig &cfg) override {
+        if ((cfg._type != PackedFSConfig::FSId) || _mounted) {
+            return false;
+        }
+        const PackedFSConfig& pcfg = *static_cast<const PackedFSConfig *>(&cfg);
+        _image = static_cast<const uint8_t*>(pcfg._image);
+        if (!_image) {
+            _start = pcfg._addr;
+            _size = pcfg._size;
+        }
+        return true;
+    }
+
+    bool begin() override;
+
+    void end() override {
+        _mounted = false;
+    }
+
+protected:
+    friend class PackedFSFileImpl;
+    friend class PackedFSDirImpl;
+
+    bool _read(uint32_t offset, void* dst, size_t size) const;
+    const uint8_t* _map(uint32_t offset, size_t size) const;
+    bool _entry(uint32_t index, PackedFSEntry& e) const;
+    bool _name(const PackedFSEntry& e, char* name) const;
+    uint32_t _lowerBound(const char* name) const;
+    bool _find(const char* name, PackedFSEntry& e) const;
+    bool _isDir(const char* name) const;
+
+    // Strip leading and trailing slashes, false if the result does not fit
+    static bool _normalize(const char* path, char* name);
+
+    const uint8_t* _image;
+    uint32_t       _start;
+    uint32_t       _size;
+    uint32_t       _count;
+    uint32_t       _imageSize;
+    bool           _mounted;
+};
+
+
+class PackedFSFileImpl : public FileImpl
+{
+public:
+    PackedFSFileImpl(PackedFSImpl* fs, const char* name, const PackedFSEntry* e)
+        : _fs(fs), _pos(0), _opened(true), _isDir(!e) {
+        if (e) {
+            _e = *e;
+        } else {
+            memset(&_e, 0, sizeof(_e));
+        }
+        _name = std::shared_ptr<char>(new char[strlen(name) + 1], std::default_delete<char[]>());
+        strcpy(_name.get(), name);
+    }
+
+    size_t write(const uint8_t *buf, size_t size) override {
+        (void) buf;
+        (void) size;
+        return 0;
+    }
+
+    size_t read(uint8_t* buf, size_t size) override {
+        if (!_opened || _isDir || !buf || !_fs->_mounted) {
+            return 0;
+        }
+        size = std::min<size_t>(size, _e.size - _pos);
+        if (!size || !_fs->_read(_e.data + _pos, buf, size)) {
+            return 0;
+        }
+        _pos += size;
+        return size;
+    }
+
+    void flush() override { }
+
+    bool seek(uint32_t pos, SeekMode mode) override {
+        if (!_opened || _isDir) {
+            return false;
+        }
+        int64_t target = pos;
+        if (mode == SeekCur) {
+            target = (int64_t)_pos + (int32_t)pos;
+        } else if (mode == SeekEnd) {
+            target = (int64_t)_e.size - pos; // Same convention as LittleFS
+        }
+        if ((target < 0) || (target > _e.size)) {
+            return false;
+        }
+        _pos = (uint32_t)target;
+        return true;
+    }
+
+    size_t position() const override {
+        return _opened ? _pos : 0;
+    }
+
+    size_t size() const override {
+        return _opened ? _e.size : 0;
+    }
+
+    bool truncate(uint32_t size) override {
+        (void) size;
+        return false;
+    }
+
+    void close() override {
+        _opened = false;
+    }
+
+    const char* name() const override {
+        if (!_opened) {
+            return nullptr;
+        }
+        const char *p = _name.get();
+        const char *slash = strrchr(p, '/');
+        return (slash && slash[1]) ? slash + 1 : p;
+    }
+
+    const char* fullName() const override {
+        return _opened ? _name.get() : nullptr;
+    }
+
+    bool isFile() const override {
+        return _opened && !_isDir;
+    }
+
+    bool isDirectory() const override {
+        return _opened && _isDir;
+    }
+
+    time_t getLastWrite() override {
+        return _opened ? (time_t)_e.mtime : 0;
+    }
+
+    time_t getCreationTime() override {
+        return getLastWrite();
+    }
+
+    const uint8_t* mapped() const override {
+        if (!_opened || _isDir || !_fs->_mounted) {
+            return nullptr;
+        }
+        return _fs->_map(_e.data, _e.size);
+    }
+
+    uint64_t contentHash() const override {
+        if (!_opened || _isDir) {
+            return 0;
+        }
+        uint64_t hash = 0;
+        for (size_t i = 0; i < sizeof(_e.hash); i++) {
+            hash = (hash << 8) | _e.hash[i];
+        }
+        return hash;
+    }
+
+protected:
+    PackedFSImpl           *_fs;
+    PackedFSEntry           _e;
+    std::shared_ptr<char>   _name;
+    uint32_t                _pos;
+    bool                    _opened;
+    bool                    _isDir;
+};
+
+
+// Lists the direct children of a directory.  Entries below a subdirectory
+// are contiguous in the sorted directory, so each subdirectory is reported
+// once, on its first entry.
+class PackedFSDirImpl : public DirImpl
+{
+public:
+    PackedFSDirImpl(PackedFSImpl* fs, const char* prefix)
+        : _fs(fs), _index(0), _valid(false), _dir(false) {
+        strcpy(_prefix, prefix);
+        _prefixLen = strlen(_prefix);
+        _first = _fs->_lowerBound(_prefix);
+        _index = _first;
+        _child[0] = 0;
+        memset(&_e, 0, sizeof(_e));
+    }
+
+    FileImplPtr openFile(OpenMode openMode, AccessMode accessMode) override {
+        if (!_valid) {
+            return FileImplPtr();
+        }
+        char path[2 * PackedFSImpl::nameMax]; // open() rejects what does not fit a name
+        snprintf(path, sizeof(path), "%s%s", _prefix, _child);
+        return _fs->open(path, openMode, accessMode);
+    }
+
+    const char* fileName() override {
+        return _valid ? _child : nullptr;
+    }
+
+    size_t fileSize() override {
+        return (_valid && !_dir) ? _e.size : 0;
+    }
+
+    time_t fileTime() override {
+        return (_valid && !_dir) ? (time_t)_e.mtime : 0;
+    }
+
+    time_t fileCreationTime() override {
+        return fileTime();
+    }
+
+    bool isFile() const override {
+        return _valid && !_dir;
+    }
+
+    bool isDirectory() const override {
+        return _valid && _dir;
+    }
+
+    bool next() override {
+        char name[PackedFSImpl::nameMax];
+        char last[PackedFSImpl::nameMax];
+        strcpy(last, _dir ? _child : "");
+        _valid = false;
+        while (_fs->_mounted && (_index < _fs->_count)) {
+            if (!_fs->_entry(_index++, _e) || !_fs->_name(_e, name) || strncmp(name, _prefix, _prefixLen)) {
+                break; // Past the last entry below this directory
+            }
+            const char* rest = name + _prefixLen;
+            const char* slash = strchr(rest, '/');
+            if (!slash) {
+                strcpy(_child, rest);
+                _dir = false;
+                _valid = true;
+                break;
+            }
+            size_t len = slash - rest;
+            if ((strlen(last) == len) && !strncmp(last, rest, len)) {
+                continue; // Another entry of the subdirectory already reported
+            }
+            memcpy(_child, rest, len);
+            _child[len] = 0;
+            _dir = true;
+            _valid = true;
+            break;
+        }
+        return _valid;
+    }
+
+    bool rewind() override {
+        _index = _first;
+        _valid = false;
+        _dir = false;
+        _child[0] = 0;
+        return true;
+    }
+
+protected:
+    PackedFSImpl  *_fs;
+    PackedFSEntry  _e;
+    char           _prefix[PackedFSImpl::nameMax];
+    char           _child[PackedFSImpl::nameMax];
+    size_t         _prefixLen;
+    uint32_t       _first;
+    uint32_t       _index;
+    bool           _valid;
+    bool           _dir;
+};
+
+};
+
+#if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_PACKEDFS)
+extern FS PackedFS;
+using packedfs_impl::PackedFSConfig;
+#endif
+
+#endif // !defined(__PACKEDFS_H)
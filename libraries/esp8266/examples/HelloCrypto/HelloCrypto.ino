@@ -69,6 +69,18 @@ void loop() {
   Serial.println(String(F("This is the SHA256 HMAC of our example data, in HEX format, using String output:\n")) + SHA256::hmac(exampleData, derivedKey, sizeof derivedKey, SHA256::NATURAL_LENGTH));
 
 
+  // Streaming hash and HMAC
+  // Data can be added in pieces, e.g. while reading a File, and the HMAC key is only processed once per HmacContext
+  SHA256::Context hashContext;
+  hashContext.update(exampleData.c_str(), 5);
+  hashContext.update(exampleData.c_str() + 5, exampleData.length() - 5);
+  Serial.println(String(F("\nThis is the SHA256 hash of our example data, computed in two parts:\n")) + hashContext.finish());
+
+  SHA256::HmacContext hmacContext(derivedKey, sizeof derivedKey);
+  hmacContext.update(exampleData.c_str(), exampleData.length());
+  Serial.println(String(F("This is the SHA256 HMAC of our example data, using a HmacContext:\n")) + hmacContext.finish());
+
+
   // Authenticated Encryption with Associated Data (AEAD)
   String dataToEncrypt = F("This data is not encrypted.");
   uint8_t resultingNonce[12] { 0 }; // The nonce is always 12 bytes
@@ -0,0 +1,123 @@
+/*
+  CertStore trust anchor lookup time, host only
+
+  Needs BearSSL (make ssl) and a certs.ar made by
+  libraries/ESP8266WiFi/examples/BearSSL_CertStore/certs-from-mozilla.py
+
+  Build and run from tests/host:
+    make ssl
+    make OPTZ=-O2 bench/CertStoreLookup/CertStoreLookup
+    CERTS_AR=/path/to/data/certs.ar ./bin/CertStoreLookup/CertStoreLookup -f -L 2048
+
+  The archive is copied into the LittleFS mock, then the same lookups are
+  timed with a linear index scan (previous behaviour), a sorted index,
+  a sorted index with the trust anchor cache and a PROGMEM index.
+*/
+
+#include <ESP8266WiFi.h>
+#include <CertStoreBearSSL.h>
+#include <LittleFS.h>
+
+#include <stdio.h>
+
+#define LOOKUPS 2000
+#define HOT     6     // Roots most connections chain up to
+
+// Reach the BearSSL callbacks and index internals
+class BenchCertStore : public BearSSL::CertStore {
+  public:
+    const br_x509_trust_anchor *find(const uint8_t *sha) {
+      return findHashedTA(this, (void *)sha, 32);
+    }
+    void release(const br_x509_trust_anchor *ta) {
+      freeHashedTA(this, ta);
+    }
+    void setSorted(bool sorted) {
+      _sorted = sorted;
+    }
+};
+
+BenchCertStore certStore;
+using CertInfo = BearSSL::CertStore::CertInfo;
+CertInfo *infos;
+int count;
+
+bool copyArchive() {
+  const char *path = getenv("CERTS_AR") ? getenv("CERTS_AR") : "certs.ar";
+  FILE *in = fopen(path, "rb");
+  if (!in) {
+    Serial.printf("can't open '%s', set CERTS_AR\n", path);
+    return false;
+  }
+  File out = LittleFS.open("/certs.ar", "w");
+  uint8_t buf[1024];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), in)) > 0) {
+    out.write(buf, len);
+  }
+  fclose(in);
+  out.close();
+  return true;
+}
+
+void run(const char *name, bool hot) {
+  srand(1);
+  int found = 0;
+  unsigned long start = micros();
+  for (int i = 0; i < LOOKUPS; i++) {
+    int n = rand() % (hot ? HOT : count);
+    const br_x509_trust_anchor *ta = certStore.find(infos[n].sha256);
+    if (ta) {
+      found++;
+      certStore.release(ta);
+    }
+  }
+  unsigned long us = micros() - start;
+  Serial.printf("%-24s %-6s %5d/%d found, %7.1f us/lookup\n", name, hot ? "hot" : "spread",
+                found, LOOKUPS, (float)us / LOOKUPS);
+}
+
+void runBoth(const char *name) {
+  run(name, true);
+  run(name, false);
+}
+
+void setup() {
+  Serial.begin(115200);
+  if (!LittleFS.begin() || !copyArchive()) {
+    exit(1);
+  }
+
+  unsigned long start = micros();
+  count = certStore.initCertStore(LittleFS, "/certs.idx", "/certs.ar");
+  Serial.printf("%d certs indexed in %lu ms\n", count, (micros() - start) / 1000);
+  if (!count) {
+    exit(1);
+  }
+
+  // Keep the index in RAM to pick lookups from, and for the PROGMEM variant
+  infos = new CertInfo[count];
+  File idx = LittleFS.open("/certs.idx", "r");
+  idx.read((uint8_t *)infos, count * sizeof(CertInfo));
+  idx.close();
+
+  certStore.setCacheSize(0);
+  certStore.setSorted(false);
+  runBoth("linear, no cache");
+  certStore.setSorted(true);
+  runBoth("sorted, no cache");
+  certStore.setCacheSize(4);
+  runBoth("sorted, 4 cached");
+
+  certStore.initCertStore(LittleFS, infos, count, "/certs.ar");
+  certStore.setCacheSize(0);
+  runBoth("progmem, no cache");
+  certStore.setCacheSize(4);
+  runBoth("progmem, 4 cached");
+
+  delete[] infos;
+  exit(0);
+}
+
+void loop() {
+}
@@ -0,0 +1,96 @@
+/*
+  ChaCha20Poly1305 small message sealing rate, host only
+
+  Needs BearSSL (make ssl).
+
+  Build and run from tests/host:
+    make ssl
+    make OPTZ=-O2 bench/ChaChaSeal/ChaChaSeal
+    ./bin/ChaChaSeal/ChaChaSeal -f
+
+  The same messages are sealed one by one with ChaCha20Poly1305::encrypt()
+  (with and without keySalt), then in batches of BATCH messages with a
+  ChaCha20Poly1305::Context, and the batches are opened back.
+*/
+
+#include <Arduino.h>
+#include <Crypto.h>
+
+#define MESSAGES      20000
+#define MESSAGE_SIZE  48
+#define BATCH         16
+
+using namespace experimental::crypto;
+
+const uint8_t key[ENCRYPTION_KEY_LENGTH] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+const char keySalt[] = "mesh";
+const char aad[] = "header";
+
+uint8_t payloads[BATCH][MESSAGE_SIZE];
+uint8_t packet[BATCH * (ChaCha20Poly1305::Context::RECORD_OVERHEAD + MESSAGE_SIZE)];
+
+void report(const char *name, unsigned long us) {
+  Serial.printf("%-26s %7lu messages/s (%5.1f us/message)\n",
+                name, (unsigned long)(MESSAGES * 1000000ULL / us), (double)us / MESSAGES);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  for (int i = 0; i < BATCH; i++) {
+    memset(payloads[i], 'a' + i, MESSAGE_SIZE);
+  }
+
+  uint8_t data[MESSAGE_SIZE];
+  uint8_t nonce[ChaCha20Poly1305::NONCE_LENGTH];
+  uint8_t tag[ChaCha20Poly1305::TAG_LENGTH];
+
+  unsigned long startUs = micros();
+  for (int i = 0; i < MESSAGES; i++) {
+    memcpy(data, payloads[i % BATCH], MESSAGE_SIZE);
+    ChaCha20Poly1305::encrypt(data, MESSAGE_SIZE, key, keySalt, sizeof keySalt, nonce, tag, aad, sizeof aad);
+  }
+  report("encrypt() with keySalt", micros() - startUs);
+
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i++) {
+    memcpy(data, payloads[i % BATCH], MESSAGE_SIZE);
+    ChaCha20Poly1305::encrypt(data, MESSAGE_SIZE, key, nullptr, 0, nonce, tag, aad, sizeof aad);
+  }
+  report("encrypt() without keySalt", micros() - startUs);
+
+  ChaCha20Poly1305::Context sender(key, keySalt, sizeof keySalt);
+  ChaCha20Poly1305::Context receiver(key, keySalt, sizeof keySalt);
+  ChaCha20Poly1305::Message messages[BATCH];
+  for (int i = 0; i < BATCH; i++) {
+    messages[i] = { payloads[i], MESSAGE_SIZE };
+  }
+
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i += BATCH) {
+    sender.sealBatch(messages, BATCH, packet, sizeof packet, aad, sizeof aad);
+  }
+  report("Context::sealBatch()", micros() - startUs);
+
+  ChaCha20Poly1305::Message opened[BATCH];
+  size_t failed = 0;
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i += BATCH) {
+    size_t packetLength = sender.sealBatch(messages, BATCH, packet, sizeof packet, aad, sizeof aad);
+    size_t count = receiver.openBatch(packet, packetLength, opened, BATCH, aad, sizeof aad);
+    for (size_t m = 0; m < count; m++) {
+      failed += opened[m].data == nullptr || memcmp(opened[m].data, payloads[m], MESSAGE_SIZE) != 0;
+    }
+  }
+  report("Context::seal+openBatch()", micros() - startUs);
+
+  if (failed) {
+    Serial.printf("%u messages failed to open\n", (unsigned)failed);
+    exit(EXIT_FAILURE);
+  }
+
+  exit(EXIT_SUCCESS);
+}
+
+void loop() {
+}
@@ -0,0 +1,125 @@
+/*
+  experimental::crypto hash and HMAC throughput, host only
+
+  Needs BearSSL (make ssl).
+
+  Build and run from tests/host:
+    make ssl
+    make OPTZ=-O2 bench/CryptoHash/CryptoHash
+    ./bin/CryptoHash/CryptoHash -f
+
+  For each algorithm a 1 MB buffer is hashed through a Context in
+  STREAM_BUFFER_SIZE chunks, then read back through a Stream. Short
+  messages are signed with the one-shot hmac() (key processed on every
+  call) and with an HmacContext reusing the precomputed key.
+*/
+
+#include <Arduino.h>
+#include <Crypto.h>
+#include <TypeConversion.h>
+
+#define DATA_LENGTH   (1024 * 1024)
+#define MESSAGES      20000
+#define MESSAGE_SIZE  64
+
+using namespace experimental::crypto;
+
+uint8_t data[DATA_LENGTH];
+const char key[] = "a key shared by all messages";
+
+// Serve the data buffer as a Stream, like a File would
+class BufferStream : public Stream {
+  public:
+    BufferStream(const uint8_t *buffer, size_t length) : _buffer(buffer), _length(length), _pos(0) { }
+    int available() override {
+      return _length - _pos;
+    }
+    int read() override {
+      return _pos < _length ? _buffer[_pos++] : -1;
+    }
+    int peek() override {
+      return _pos < _length ? _buffer[_pos] : -1;
+    }
+    size_t readBytes(char *buffer, size_t length) override {
+      length = std::min(length, _length - _pos);
+      memcpy(buffer, _buffer + _pos, length);
+      _pos += length;
+      return length;
+    }
+    size_t write(uint8_t) override {
+      return 0;
+    }
+
+  private:
+    const uint8_t *_buffer;
+    size_t _length;
+    size_t _pos;
+};
+
+unsigned long mbps(size_t bytes, unsigned long us) {
+  return us ? (unsigned long)(bytes * 1000000ULL / us / 1024 / 1024) : 0;
+}
+
+template <typename H>
+void bench(const char *name) {
+  uint8_t result[H::NATURAL_LENGTH];
+
+  typename H::Context context;
+  unsigned long startUs = micros();
+  for (size_t i = 0; i < DATA_LENGTH; i += STREAM_BUFFER_SIZE) {
+    context.update(data + i, STREAM_BUFFER_SIZE);
+  }
+  context.finish(result);
+  unsigned long updateUs = micros() - startUs;
+
+  BufferStream stream(data, DATA_LENGTH);
+  startUs = micros();
+  context.begin();
+  context.update(stream);
+  String streamed = context.finish();
+  unsigned long streamUs = micros() - startUs;
+
+  if (streamed != experimental::TypeConversion::uint8ArrayToHexString(result, H::NATURAL_LENGTH)) {
+    Serial.printf("%s: stream and buffer hashes differ\n", name);
+    exit(EXIT_FAILURE);
+  }
+
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i++) {
+    H::hmac(data + i * MESSAGE_SIZE % DATA_LENGTH, MESSAGE_SIZE, key, sizeof(key), result, H::NATURAL_LENGTH);
+  }
+  unsigned long oneShotUs = micros() - startUs;
+
+  typename H::HmacContext hmac(key, sizeof(key));
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i++) {
+    hmac.begin();
+    hmac.update(data + i * MESSAGE_SIZE % DATA_LENGTH, MESSAGE_SIZE);
+    hmac.finish(result);
+  }
+  unsigned long contextUs = micros() - startUs;
+
+  Serial.printf("%-7s update %4lu MB/s  stream %4lu MB/s  hmac %3d B: one-shot %6lu/s  context %6lu/s\n",
+                name, mbps(DATA_LENGTH, updateUs), mbps(DATA_LENGTH, streamUs), MESSAGE_SIZE,
+                (unsigned long)(MESSAGES * 1000000ULL / oneShotUs), (unsigned long)(MESSAGES * 1000000ULL / contextUs));
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  for (size_t i = 0; i < DATA_LENGTH; i++) {
+    data[i] = i * 2654435761U >> 24;
+  }
+
+  bench<MD5>("MD5");
+  bench<SHA1>("SHA1");
+  bench<SHA224>("SHA224");
+  bench<SHA256>("SHA256");
+  bench<SHA384>("SHA384");
+  bench<SHA512>("SHA512");
+
+  exit(EXIT_SUCCESS);
+}
+
+void loop() {
+}
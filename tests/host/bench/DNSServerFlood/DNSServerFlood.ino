@@ -0,0 +1,110 @@
+/*
+  DNSServer query flood, host only
+
+  Build and run from tests/host:
+    make OPTZ=-O2 bench/DNSServerFlood/DNSServerFlood
+    ./bin/DNSServerFlood/DNSServerFlood -f
+
+  Queries are sent from a posix socket to the DNSServer listening through
+  the UdpContext mock, replies are counted back on the same socket.
+*/
+
+#include <ESP8266WiFi.h>
+#include <DNSServer.h>
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define DNS_PORT    5353
+#define RECORDS     64
+#define QUERIES     100000
+#define BURST       16
+
+DNSServer dnsServer;
+int sock;
+struct sockaddr_in server;
+uint8_t query[MAX_DNS_PACKETSIZE];
+uint32_t sent, received, answered;
+unsigned long startUs;
+
+size_t buildQuery(uint16_t id, const char* name)
+{
+  memset(query, 0, sizeof(DNSHeader));
+  query[0] = id >> 8;
+  query[1] = id;
+  query[2] = 0x01;  // RD
+  query[5] = 1;     // QDCount
+  size_t len = sizeof(DNSHeader);
+  while (*name) {
+    const char* dot = strchr(name, '.');
+    size_t labelLength = dot ? (size_t)(dot - name) : strlen(name);
+    query[len++] = labelLength;
+    memcpy(&query[len], name, labelLength);
+    len += labelLength;
+    name += labelLength + (dot ? 1 : 0);
+  }
+  query[len++] = 0;
+  query[len++] = 0;
+  query[len++] = DNS_QTYPE_A;
+  query[len++] = 0;
+  query[len++] = DNS_QCLASS_IN;
+  return len;
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  for (int i = 0; i < RECORDS; i++) {
+    dnsServer.addRecord(String("host") + i + ".example.com", IPAddress(10, 0, i / 256, i % 256));
+  }
+  dnsServer.start(DNS_PORT, "portal.example.com", IPAddress(192, 168, 4, 1));
+
+  sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  fcntl(sock, F_SETFL, O_NONBLOCK);
+  memset(&server, 0, sizeof(server));
+  server.sin_family = AF_INET;
+  server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  server.sin_port = htons(DNS_PORT);
+
+  startUs = micros();
+}
+
+void loop() {
+  // keep a few queries in flight: captive portal clients mostly ask
+  // unknown names, some known records and the portal itself
+  while (sent < QUERIES && sent - received < BURST) {
+    char name[32];
+    switch (sent % 4) {
+      case 0: snprintf(name, sizeof(name), "portal.example.com"); break;
+      case 1: snprintf(name, sizeof(name), "www.HOST%d.example.com", (int)(sent % RECORDS)); break;
+      default: snprintf(name, sizeof(name), "unknown%d.example.org", (int)sent); break;
+    }
+    size_t len = buildQuery(sent, name);
+    if (sendto(sock, query, len, 0, (const sockaddr*)&server, sizeof(server)) != (ssize_t)len) {
+      break;
+    }
+    sent++;
+  }
+
+  dnsServer.processNextRequest();
+
+  uint8_t reply[MAX_DNS_PACKETSIZE + DNS_ANSWER_SIZE];
+  ssize_t len;
+  while ((len = recv(sock, reply, sizeof(reply), 0)) > 0) {
+    received++;
+    if (len > (ssize_t)sizeof(DNSHeader) && reply[7] == 1) {
+      answered++;
+    }
+  }
+
+  if (received == QUERIES) {
+    unsigned long us = micros() - startUs;
+    Serial.printf("%u queries (%u answered) in %lu ms: %lu queries/s\n",
+                  received, answered, us / 1000, (unsigned long)(received * 1000000ULL / us));
+    close(sock);
+    dnsServer.stop();
+    exit(EXIT_SUCCESS);
+  }
+}
@@ -0,0 +1,249 @@
+/*
+  SPIFFS, LittleFS and SDFS running the same workloads, host only
+
+  Build and run from tests/host:
+    make OPTZ=-O2 bench/FSWorkloads/FSWorkloads
+    ./bin/FSWorkloads/FSWorkloads -f
+  With FLASH_CACHE=<bytes> in the environment, the flash_hal cache is
+  enabled for SPIFFS and LittleFS.
+
+  Every workload starts on a freshly formatted 512KB filesystem, with the
+  8KB blocks and 256 byte pages of the boards' flash layouts.  SPIFFS and
+  LittleFS sit on the flash mock, which counts the reads, programs and
+  erases reaching the flash, the erases of the most worn sector, and the
+  time a typical SPI flash would have been busy with them (FlashMockTiming
+  in common/flash_hal_mock.h), in total and for the slowest single
+  File::write(), flush() or close().  The SD card under SDFS is plain memory
+  accessed by SdFat, only the 512 byte sectors it changed are counted.
+*/
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <SDFS.h>
+#include <spiffs_mock.h>
+#include <littlefs_mock.h>
+#include <sdfs_mock.h>
+#include <vector>
+
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+#define FS_KB     512
+#define BLOCK_KB  8
+#define PAGE_B    256
+
+struct Workload {
+  const char *name;
+  void (*prepare)(FS &fs);  // Not measured, may be nullptr
+  void (*run)(FS &fs);
+};
+
+uint8_t chunk[512];
+uint32_t cacheBytes;
+uint64_t worstWriteNs;
+
+void check(bool ok, const char *what) {
+  if (!ok) {
+    Serial.printf("failed: %s\n", what);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Flash time taken by the slowest of the write(), flush() and close() calls
+size_t timedWrite(File &f, size_t len) {
+  uint64_t before = s_phys_ops.busyNs;
+  size_t written = f.write(chunk, len);
+  worstWriteNs = std::max(worstWriteNs, s_phys_ops.busyNs - before);
+  return written;
+}
+
+void timedFlush(File &f, bool close) {
+  uint64_t before = s_phys_ops.busyNs;
+  if (close) {
+    f.close();
+  } else {
+    f.flush();
+  }
+  worstWriteNs = std::max(worstWriteNs, s_phys_ops.busyNs - before);
+}
+
+void writeFile(FS &fs, const String &path, size_t size, size_t step) {
+  File f = fs.open(path, "w");
+  check(f, "open for writing");
+  for (size_t done = 0; done < size; done += step) {
+    check(timedWrite(f, std::min(step, size - done)) == std::min(step, size - done), "write");
+  }
+  timedFlush(f, true);
+}
+
+void readFile(FS &fs, const String &path, size_t size) {
+  File f = fs.open(path, "r");
+  check(f && f.size() == size, "open for reading");
+  uint8_t buf[128];
+  while (f.read(buf, sizeof(buf)) > 0) {
+  }
+  f.close();
+}
+
+// 64 files of 1000 bytes written 100 bytes at a time
+void createSmall(FS &fs) {
+  for (int i = 0; i < 64; i++) {
+    writeFile(fs, String("/small") + i, 1000, 100);
+  }
+}
+
+// 2000 log records of 48 bytes, flushed every 16 records
+void appendLog(FS &fs) {
+  File f = fs.open("/log", "a");
+  check(f, "open log");
+  for (int i = 0; i < 2000; i++) {
+    timedWrite(f, 48);
+    if (i % 16 == 15) {
+      timedFlush(f, false);
+    }
+  }
+  timedFlush(f, true);
+}
+
+// A 4KB settings file saved 200 times, more than the filesystem holds
+void rewriteConfig(FS &fs) {
+  for (int i = 0; i < 200; i++) {
+    writeFile(fs, "/config", 4096, 512);
+  }
+}
+
+// The same with gcStep() given up to 200ms between the saves, as
+// setBackgroundGC() would while the sketch is idle
+void rewriteConfigGC(FS &fs) {
+  for (int i = 0; i < 200; i++) {
+    writeFile(fs, "/config", 4096, 512);
+    fs.gcStep(200000);
+  }
+}
+
+// 128KB written in 512 byte chunks, then read back
+void bigFile(FS &fs) {
+  writeFile(fs, "/big", 128 * 1024, 512);
+  readFile(fs, "/big", 128 * 1024);
+}
+
+// Every small file opened and read 4 times
+void readSmall(FS &fs) {
+  for (int pass = 0; pass < 4; pass++) {
+    for (int i = 0; i < 64; i++) {
+      readFile(fs, String("/small") + i, 1000);
+    }
+  }
+}
+
+// Lookups of present and missing names
+void lookup(FS &fs) {
+  for (int pass = 0; pass < 8; pass++) {
+    for (int i = 0; i < 64; i++) {
+      check(fs.exists(String("/small") + i), "exists");
+      check(!fs.exists(String("/missing") + i), "missing");
+    }
+  }
+}
+
+const Workload workloads[] = {
+  { "create 64 x 1KB", nullptr, createSmall },
+  { "append log 96KB", nullptr, appendLog },
+  { "rewrite 4KB x200", nullptr, rewriteConfig },
+  { "same + gcStep", nullptr, rewriteConfigGC },
+  { "big file 128KB", nullptr, bigFile },
+  { "read 64 x 1KB x4", createSmall, readSmall },
+  { "exists x1024", createSmall, lookup },
+};
+
+void header() {
+  Serial.printf("%-8s %-17s %7s %8s %7s %8s %6s %5s %9s %9s %8s\n",
+                "fs", "workload", "reads", "read KB", "progs", "prog KB",
+                "erases", "worst", "flash ms", "write max", "host ms");
+}
+
+void measure(const char *fsName, FS &fs, const Workload &w, bool flash) {
+  check(fs.format() && fs.begin(), "format and mount");
+  if (w.prepare) {
+    w.prepare(fs);
+  }
+  flash_hal_sync();
+  flash_mock_reset_ops();
+  worstWriteNs = 0;
+  std::vector<uint8_t> card;
+  if (!flash) {
+    card.assign(_sdCard, _sdCard + _sdCardSizeB);
+  }
+
+  unsigned long startUs = micros();
+  w.run(fs);
+  fs.end();
+  flash_hal_sync();
+  unsigned long hostUs = micros() - startUs;
+
+  if (flash) {
+    uint32_t worst = 0;
+    for (uint32_t n : s_phys_sector_erases) {
+      worst = std::max(worst, n);
+    }
+    Serial.printf("%-8s %-17s %7u %8u %7u %8u %6u %5u %9u %9u %8lu\n", fsName, w.name,
+                  s_phys_ops.reads, s_phys_ops.readBytes / 1024,
+                  s_phys_ops.programs, s_phys_ops.programBytes / 1024,
+                  s_phys_ops.erases, worst, (uint32_t)(s_phys_ops.busyNs / 1000000),
+                  (uint32_t)(worstWriteNs / 1000000), hostUs / 1000);
+  } else {
+    uint32_t sectors = 0;
+    for (size_t i = 0; i < card.size(); i += 512) {
+      sectors += memcmp(&card[i], _sdCard + i, 512) != 0;
+    }
+    Serial.printf("%-8s %-17s %7s %8s %7u %8u %6s %5s %9s %9s %8lu\n", fsName, w.name,
+                  "-", "-", sectors, sectors / 2, "-", "-", "-", "-", hostUs / 1000);
+  }
+}
+
+void benchSPIFFS(const Workload &w) {
+  SpiffsMock mock(FS_KB * 1024, BLOCK_KB * 1024, PAGE_B);
+  check(flash_hal_cache_begin(cacheBytes), "cache");
+  measure("SPIFFS", SPIFFS, w, true);
+  flash_hal_cache_begin(0);
+}
+
+void benchLittleFS(const Workload &w) {
+  LittleFSMock mock(FS_KB * 1024, BLOCK_KB * 1024, PAGE_B);
+  check(flash_hal_cache_begin(cacheBytes), "cache");
+  measure("LittleFS", LittleFS, w, true);
+  flash_hal_cache_begin(0);
+}
+
+void benchSDFS(const Workload &w) {
+  SDFS_MOCK_DECLARE(FS_KB, BLOCK_KB, PAGE_B, "");
+  measure("SDFS", SDFS, w, false);
+  SDFS.end();
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // The emulation mounts its own SPIFFS and LittleFS, each workload gets a fresh one instead
+  mock_stop_spiffs();
+  mock_stop_littlefs();
+
+  for (size_t i = 0; i < sizeof(chunk); i++) {
+    chunk[i] = 'a' + i % 26;
+  }
+  const char *cache = getenv("FLASH_CACHE");
+  cacheBytes = cache ? atoi(cache) : 0;
+  Serial.printf("flash_hal cache: %u bytes\n", cacheBytes);
+
+  header();
+  for (const Workload &w : workloads) {
+    benchSPIFFS(w);
+    benchLittleFS(w);
+    benchSDFS(w);
+  }
+
+  exit(EXIT_SUCCESS);
+}
+
+void loop() {
+}
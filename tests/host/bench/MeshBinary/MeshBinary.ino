@@ -0,0 +1,117 @@
+/*
+  ESP8266WiFiMesh message rate, String vs binary transport, host only
+
+  Build and run from tests/host:
+    make OPTZ=-O2 bench/MeshBinary/MeshBinary
+    ./bin/MeshBinary/MeshBinary -f
+
+  The sketch forks: the child is the AP node answering requests, the parent
+  is the station node (the host mock is always connected, its gateway being
+  the host itself). The same small messages are sent with attemptTransmission()
+  (one TCP connection per message), with attemptBinaryTransmission() one
+  message per call (kept-alive session), then in pipelined batches of BATCH.
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFiMesh.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MESSAGES      2000
+#define MESSAGE_SIZE  48
+#define BATCH         16
+
+uint8_t payloads[BATCH][MESSAGE_SIZE];
+ESP8266WiFiMesh::BinaryMessage batch[BATCH];
+size_t responses = 0;
+
+String requestHandler(const String &request, ESP8266WiFiMesh &) {
+  return request;
+}
+
+transmission_status_t responseHandler(const String &, ESP8266WiFiMesh &) {
+  responses++;
+  return TS_TRANSMISSION_COMPLETE;
+}
+
+size_t binaryRequestHandler(const uint8_t *request, size_t requestLength, uint8_t *response, size_t, ESP8266WiFiMesh &) {
+  memcpy(response, request, requestLength);
+  return requestLength;
+}
+
+transmission_status_t binaryResponseHandler(const uint8_t *, size_t responseLength, ESP8266WiFiMesh &) {
+  if (responseLength != MESSAGE_SIZE) {
+    return TS_TRANSMISSION_FAILED;
+  }
+  responses++;
+  return TS_TRANSMISSION_COMPLETE;
+}
+
+void networkFilter(int, ESP8266WiFiMesh &) {
+}
+
+ESP8266WiFiMesh meshNode(requestHandler, responseHandler, networkFilter, "ChangeThisWiFiPassword_TODO", "MeshNode_");
+
+void report(const char *name, unsigned long us) {
+  Serial.printf("%-32s %7lu messages/s (%6.1f us/message) %5u/%u responses\n",
+                name, (unsigned long)(MESSAGES * 1000000ULL / us), (double)us / MESSAGES,
+                (unsigned)responses, MESSAGES);
+  responses = 0;
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  for (int i = 0; i < BATCH; i++) {
+    memset(payloads[i], 'a' + i, MESSAGE_SIZE);
+    batch[i] = { payloads[i], MESSAGE_SIZE };
+  }
+
+  meshNode.setBinaryRequestHandler(binaryRequestHandler);
+  meshNode.setBinaryResponseHandler(binaryResponseHandler);
+
+  pid_t server = fork();
+  if (server == 0) {
+    meshNode.begin();
+    meshNode.activateAP();
+    for (;;) {
+      meshNode.acceptRequest();
+      delay(0);
+    }
+  }
+
+  delay(500); // let the AP node listen
+  ESP8266WiFiMesh::connectionQueue.push_back(NetworkInfo(String("MeshNode_")));
+
+  String message;
+  message.reserve(MESSAGE_SIZE);
+  for (int i = 0; i < MESSAGE_SIZE; i++) {
+    message += (char)payloads[0][i];
+  }
+  unsigned long startUs = micros();
+  for (int i = 0; i < MESSAGES; i++) {
+    meshNode.attemptTransmission(message, false);
+  }
+  report("attemptTransmission()", micros() - startUs);
+
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i++) {
+    meshNode.attemptBinaryTransmission(payloads[i % BATCH], MESSAGE_SIZE);
+  }
+  report("attemptBinaryTransmission() x1", micros() - startUs);
+
+  startUs = micros();
+  for (int i = 0; i < MESSAGES; i += BATCH) {
+    meshNode.attemptBinaryTransmission(batch, BATCH);
+  }
+  report("attemptBinaryTransmission() x16", micros() - startUs);
+
+  meshNode.closeSessions();
+  kill(server, SIGTERM);
+  waitpid(server, nullptr, 0);
+  exit(0);
+}
+
+void loop() {
+}
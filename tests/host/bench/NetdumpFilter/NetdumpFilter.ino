@@ -0,0 +1,176 @@
+/*
+  Netdump filters, Packet based std::function vs compiled expression, host only
+
+  Build and run from tests/host:
+    make ULIBDIRS=../../libraries/Netdump OPTZ=-O2 bench/NetdumpFilter/NetdumpFilter
+    ./bin/NetdumpFilter/NetdumpFilter -f
+
+  A mix of synthetic frames (ARP, IPv4 TCP/UDP/ICMP, IPv6 UDP) is matched
+  against the same selections written both ways, the results must agree.
+  Over-nested expressions must be rejected without exhausting the stack.
+*/
+
+#include <Arduino.h>
+#include <NetdumpFilter.h>
+#include <NetdumpPacket.h>
+#include <functional>
+
+using namespace NetCapture;
+
+#define ROUNDS  20000
+#define FRAMES  8
+
+char frames[FRAMES][128];
+size_t lengths[FRAMES];
+
+size_t makeFrame(char* f, uint16_t etherType, uint8_t protocol, uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport, uint8_t tcpFlags) {
+  memset(f, 0, 128);
+  f[12] = etherType >> 8;
+  f[13] = etherType;
+  if (etherType == 0x0806) {
+    return 42;
+  }
+  size_t transport;
+  if (etherType == 0x86dd) {
+    f[14] = 0x60;
+    f[20] = protocol;
+    transport = 54;
+  } else {
+    f[14] = 0x45;
+    f[23] = protocol;
+    for (int i = 0; i < 4; i++) {
+      f[26 + i] = src >> (24 - 8 * i);
+      f[30 + i] = dst >> (24 - 8 * i);
+    }
+    transport = 34;
+  }
+  f[transport] = sport >> 8;
+  f[transport + 1] = sport;
+  f[transport + 2] = dport >> 8;
+  f[transport + 3] = dport;
+  f[transport + 13] = tcpFlags;
+  if (etherType == 0x0800) {
+    f[17] = transport + 40 - 14 - (protocol == 6 ? 0 : 20); // ip total length
+  }
+  return transport + 40 - (protocol == 6 ? 0 : 20);
+}
+
+
+void run(const char* expression, const std::function<bool(const Packet&)>& filter) {
+  CompiledFilter compiled;
+  if (!compiled.compile(expression)) {
+    Serial.printf("'%s': syntax error at %u\n", expression, (unsigned)compiled.errorPosition());
+    return;
+  }
+
+  int matches = 0;
+  for (int i = 0; i < FRAMES; i++) {
+    Packet np(0, 0, frames[i], lengths[i], 0, 1);
+    bool a = filter(np);
+    bool b = compiled.match(frames[i], lengths[i]);
+    if (a != b) {
+      Serial.printf("'%s': frame %d mismatch\n", expression, i);
+    }
+    matches += b;
+  }
+
+  volatile int sink = 0;
+  unsigned long startUs = micros();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < FRAMES; i++) {
+      Packet np(0, 0, frames[i], lengths[i], 0, 1);
+      sink += filter(np);
+    }
+  }
+  unsigned long packetUs = micros() - startUs;
+
+  startUs = micros();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < FRAMES; i++) {
+      sink += compiled.match(frames[i], lengths[i]);
+    }
+  }
+  unsigned long compiledUs = micros() - startUs;
+  (void)sink;
+
+  Serial.printf("%-40s %d/%d %2u insns  Packet %7.1f ns/frame  compiled %6.1f ns/frame\n",
+                expression, matches, FRAMES, (unsigned)compiled.size(),
+                packetUs * 1000.0 / (ROUNDS * FRAMES), compiledUs * 1000.0 / (ROUNDS * FRAMES));
+}
+
+// Compiles without running, exits on an unexpected result
+void checkCompile(const char* what, const String& expression, bool valid, size_t size = 0) {
+  CompiledFilter compiled;
+  if (compiled.compile(expression.c_str()) != valid || (size && compiled.size() != size)) {
+    Serial.printf("%s: %s, %u insns\n", what, valid ? "rejected" : "accepted", (unsigned)compiled.size());
+    exit(1);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  const uint32_t local = 0x0a2b0175, gateway = 0x0a2b01fe;
+  lengths[0] = makeFrame(frames[0], 0x0806, 0, 0, 0, 0, 0, 0);
+  lengths[1] = makeFrame(frames[1], 0x0800, 6, gateway, local, 54546, 80, 0x02);
+  lengths[2] = makeFrame(frames[2], 0x0800, 6, local, gateway, 80, 54546, 0x18);
+  lengths[3] = makeFrame(frames[3], 0x0800, 17, gateway, 0xeffffffa, 50315, 1900, 0);
+  lengths[4] = makeFrame(frames[4], 0x0800, 17, local, gateway, 5353, 5353, 0);
+  lengths[5] = makeFrame(frames[5], 0x0800, 1, gateway, local, 0, 0, 0);
+  lengths[6] = makeFrame(frames[6], 0x86dd, 17, 0, 0, 546, 547, 0);
+  lengths[7] = makeFrame(frames[7], 0x0800, 6, gateway, 0x08080808, 40000, 443, 0x10);
+
+  const NetdumpIP localIP(10, 43, 1, 117);
+  run("tcp port 80", [](const Packet & p) {
+    return p.isTCP() && p.hasPort(80);
+  });
+  run("host 10.43.1.117", [&](const Packet & p) {
+    return p.isIPv4() && p.hasIP(localIP);
+  });
+  run("udp and (port 53 or port 5353)", [](const Packet & p) {
+    return p.isUDP() && (p.hasPort(53) || p.hasPort(5353));
+  });
+  run("not arp and not icmp", [](const Packet & p) {
+    return !p.isARP() && !p.isICMP();
+  });
+  run("tcp[13] & 2 != 0", [](const Packet & p) {
+    return p.isTCP() && (p.getTcpFlags() & 2);
+  });
+  run("net 10.43.1.0/24 and udp dst port 1900", [](const Packet & p) {
+    return p.isIPv4() && p.sourceIP().toString().startsWith("10.43.1.") && p.isUDP() && p.getDstPort() == 1900;
+  });
+  run("ether[12:2] = 0x0806 || ip[2:2] > 60", [](const Packet & p) {
+    return p.isARP() || (p.isIPv4() && p.getIpTotalLen() > 60);
+  });
+  run("len >= 80 and !(icmp or udp)", [](const Packet & p) {
+    return p.getPacketSize() >= 80 && !(p.isICMP() || p.isUDP());
+  });
+
+  run("tcp port", nullptr);
+  run("host 10.43.1", nullptr);
+
+  run("not not not arp", [](const Packet & p) {
+    return !p.isARP();
+  });
+
+  // Nesting is bounded before it can exhaust the stack, runs of "not" collapse
+  String nested = "tcp";
+  for (size_t i = 0; i < CompiledFilter::maxNesting; i++) {
+    nested = "(" + nested + ")";
+  }
+  checkCompile("maxNesting parentheses", nested, true);
+  checkCompile("maxNesting + 1 parentheses", "(" + nested + ")", false);
+  for (int i = 0; i < 5000; i++) {
+    nested = "(" + nested + ")";
+  }
+  checkCompile("5016 parentheses", nested, false);
+  String negated = "arp";
+  for (int i = 0; i < 5001; i++) {
+    negated = "not " + negated;
+  }
+  checkCompile("5001 nots", negated, true, 2);
+  exit(0);
+}
+
+void loop() {
+}
@@ -18,3 +18,9 @@
 #include <sys/time.h>
 #include "Arduino.h"
 
+
+// The emulation build has this in user_interface.cpp, and the tests get
+// esp_get_cycle_count() from MockEsp.cpp through test_PolledTimeout.cpp
+extern "C" void esp_schedule(void)
+{
+}
@@ -61,6 +61,20 @@ int mockSockSetup (int sock)
 	return sock;
 }
 
+void mockSetNoDelay (int sock, bool nodelay)
+{
+	int i = nodelay;
+	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &i, sizeof i) == -1)
+		perror(MOCK "sockopt(TCP_NODELAY)");
+}
+
+bool mockGetNoDelay (int sock)
+{
+	int i = 0;
+	socklen_t len = sizeof i;
+	return getsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &i, &len) == 0 && i;
+}
+
 int mockConnect (uint32_t ipv4, int& sock, int port)
 {
 	struct sockaddr_in server;
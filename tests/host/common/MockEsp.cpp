@@ -227,6 +227,36 @@ String EspClass::getFullVersion ()
 	return "emulation-on-host";
 }
 
+static uint32_t rtcUserMemory[512 / 4];
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > sizeof(rtcUserMemory) || size == 0)
+        return false;
+    memcpy(data, (uint8_t*)rtcUserMemory + offset * 4, size);
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+    if (offset * 4 + size > sizeof(rtcUserMemory) || size == 0)
+        return false;
+    memcpy((uint8_t*)rtcUserMemory + offset * 4, data, size);
+    return true;
+}
+
+uint8_t *EspClass::random(uint8_t *resultArray, const size_t outputSizeBytes) const
+{
+    for (size_t i = 0; i < outputSizeBytes; i++)
+        resultArray[i] = ::random() & 0xff;
+    return resultArray;
+}
+
+uint32_t EspClass::random() const
+{
+    return ::random();
+}
+
 uint32_t EspClass::getFreeContStack()
 {
     return 4000;
@@ -2,6 +2,8 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <algorithm>
+#include "flash_hal_mock.h"
 
 extern "C"
 {
@@ -12,17 +14,48 @@ extern "C"
     uint8_t* s_phys_data = nullptr;
 }
 
-int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst) {
+FlashMockOps s_phys_ops;
+std::vector<uint32_t> s_phys_sector_erases;
+FlashMockTiming s_phys_timing;
+void (*s_phys_erase_hook)(uint32_t addr) = nullptr;
+
+void flash_mock_reset_ops() {
+    memset(&s_phys_ops, 0, sizeof(s_phys_ops));
+    s_phys_sector_erases.assign(s_phys_size / FLASH_SECTOR_SIZE, 0);
+}
+
+int32_t flash_hal_phys_read(uint32_t addr, uint32_t size, uint8_t *dst) {
+    s_phys_ops.reads++;
+    s_phys_ops.readBytes += size;
+    s_phys_ops.busyNs += s_phys_timing.readSetupNs + (uint64_t)size * s_phys_timing.readByteNs;
     memcpy(dst, s_phys_data + addr, size);
     return 0;
 }
 
-int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src) {
-    memcpy(s_phys_data + addr, src, size);
+const uint8_t *flash_hal_phys_map(uint32_t addr, uint32_t size) {
+    if (!s_phys_data || addr > s_phys_size || size > s_phys_size - addr) {
+        return nullptr;
+    }
+    return s_phys_data + addr;
+}
+
+int32_t flash_hal_phys_write(uint32_t addr, uint32_t size, const uint8_t *src) {
+    s_phys_ops.programs++;
+    s_phys_ops.programBytes += size;
+    // The flash programs at most one 256-byte page per command
+    for (uint32_t pos = addr, end = addr + size; pos < end; ) {
+        const uint32_t len = std::min(end, (pos & ~0xffU) + 0x100) - pos;
+        s_phys_ops.busyNs += s_phys_timing.programSetupUs * 1000ULL + (uint64_t)(len - 1) * s_phys_timing.programByteNs;
+        pos += len;
+    }
+    // Like NOR flash, programming can only clear bits
+    for (uint32_t i = 0; i < size; ++i) {
+        s_phys_data[addr + i] &= src[i];
+    }
     return 0;
 }
 
-int32_t flash_hal_erase(uint32_t addr, uint32_t size) {
+int32_t flash_hal_phys_erase(uint32_t addr, uint32_t size) {
     if ((size & (FLASH_SECTOR_SIZE - 1)) != 0 ||
         (addr & (FLASH_SECTOR_SIZE - 1)) != 0) {
         abort();
@@ -30,7 +63,16 @@ int32_t flash_hal_erase(uint32_t addr, uint32_t size) {
     const uint32_t sector = addr / FLASH_SECTOR_SIZE;
     const uint32_t sectorCount = size / FLASH_SECTOR_SIZE;
     for (uint32_t i = 0; i < sectorCount; ++i) {
+        if (s_phys_erase_hook) {
+            s_phys_erase_hook((sector + i) * FLASH_SECTOR_SIZE);
+        }
         memset(s_phys_data + (sector + i) * FLASH_SECTOR_SIZE, 0xff, FLASH_SECTOR_SIZE);
+        s_phys_ops.erases++;
+        s_phys_ops.busyNs += s_phys_timing.eraseUs * 1000ULL;
+        if (sector + i >= s_phys_sector_erases.size()) {
+            s_phys_sector_erases.resize(sector + i + 1, 0);
+        }
+        s_phys_sector_erases[sector + i]++;
     }
     return 0;
 }
@@ -2,6 +2,7 @@
 #define flash_hal_mock_h
 
 #include <stdint.h>
+#include <vector>
 
 extern "C"
 {
@@ -12,8 +13,38 @@ extern "C"
     extern uint8_t* s_phys_data;
 }
 
-extern int32_t flash_hal_read(uint32_t addr, uint32_t size, uint8_t *dst);
-extern int32_t flash_hal_write(uint32_t addr, uint32_t size, const uint8_t *src);
-extern int32_t flash_hal_erase(uint32_t addr, uint32_t size);
+// Operations that reached the emulated flash, below the flash_hal cache
+struct FlashMockOps {
+    uint32_t reads;
+    uint32_t readBytes;
+    uint32_t programs;
+    uint32_t programBytes;
+    uint32_t erases;        // Sectors
+    uint64_t busyNs;        // Time a real flash would have spent on them
+};
+extern FlashMockOps s_phys_ops;
+
+// Erases of each sector of s_phys_data
+extern std::vector<uint32_t> s_phys_sector_erases;
+
+// Typical timings of the SPI NOR flash found on ESP8266 modules (W25Q32 and
+// GD25Q32 datasheets), read through the ROM routines at 40MHz DIO.  Only
+// busyNs follows them, the emulation itself does not wait.
+struct FlashMockTiming {
+    uint32_t readSetupNs = 2000;    // Command, address and call overhead
+    uint32_t readByteNs = 100;
+    uint32_t programSetupUs = 30;   // First byte of a page program (tBP1)
+    uint32_t programByteNs = 2500;  // Each further byte (tBPn), 0.7ms per page
+    uint32_t eraseUs = 45000;       // 4KB sector erase (tSE)
+};
+extern FlashMockTiming s_phys_timing;
+
+// Called before each sector is erased, with the flash as a reset would leave it
+extern void (*s_phys_erase_hook)(uint32_t addr);
+
+// Clears s_phys_ops and the erase counts
+void flash_mock_reset_ops();
+
+#include <flash_hal.h>
 
 #endif
@@ -114,13 +114,13 @@ public:
 
     void setNoDelay(bool nodelay)
     {
-        mockverbose("TODO setNoDelay(%d)\n", (int)nodelay);
+        if (_sock >= 0)
+            mockSetNoDelay(_sock, nodelay);
     }
 
     bool getNoDelay() const
     {
-        mockverbose("TODO getNoDelay()\n");
-        return false;
+        return _sock >= 0 && mockGetNoDelay(_sock);
     }
 
     void setTimeout(int timeout_ms)
@@ -22,6 +22,7 @@
 #define UDPCONTEXT_H
 
 #include <functional>
+#include <vector>
 
 #include <MocklwIP.h>
 #include <IPAddress.h>
@@ -248,6 +249,48 @@ public:
         return err == ERR_OK;
     }
 
+    void setTxPool(int depth)
+    {
+        (void)depth;
+    }
+
+    bool queue(ip_addr_t* addr = 0, uint16_t port = 0)
+    {
+        if (_queue.size() >= txQueueMaxDepth)
+        {
+            cancelBuffer();
+            return false;
+        }
+        _queue.push_back({ addr ? addr->addr : _dst.addr, port ? : _dstport, std::vector<char>(_outbuf, _outbuf + _outbufsize) });
+        cancelBuffer();
+        return true;
+    }
+
+    size_t queued() const
+    {
+        return _queue.size();
+    }
+
+    size_t sendQueued()
+    {
+        size_t sent = 0;
+        for (const auto& q : _queue)
+            if (mockUDPWrite(_sock, (const uint8_t*)q.data.data(), q.data.size(), _timeout_ms, q.dst, q.dstport) == q.data.size())
+                sent++;
+        _queue.clear();
+        return sent;
+    }
+
+    void setRxQueueMax(int packets)
+    {
+        (void)packets;
+    }
+
+    uint32_t rxDropped() const
+    {
+        return 0;
+    }
+
     void mock_cb(void)
     {
         if (_on_rx) _on_rx();
@@ -289,6 +332,15 @@ private:
 
     uint8_t addrsize;
     uint8_t addr[16];
+
+    struct Queued
+    {
+        u32_t dst;
+        uint16_t dstport;
+        std::vector<char> data;
+    };
+    std::vector<Queued> _queue;
+    static constexpr size_t txQueueMaxDepth = 8;
 };
 
 extern "C" inline err_t igmp_joingroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr)
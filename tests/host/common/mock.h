@@ -142,6 +142,8 @@ ssize_t mockFillInBuf (int sock, char* ccinbuf, size_t& ccinbufsize);
 ssize_t mockPeekBytes (int sock, char* dst, size_t size, int timeout_ms, char* buf, size_t& bufsize);
 ssize_t mockRead      (int sock, char* dst, size_t size, int timeout_ms, char* buf, size_t& bufsize);
 ssize_t mockWrite     (int sock, const uint8_t* data, size_t size, int timeout_ms);
+void   mockSetNoDelay (int sock, bool nodelay);
+bool   mockGetNoDelay (int sock);
 int serverAccept (int sock);
 
 // udp
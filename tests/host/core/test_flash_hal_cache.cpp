@@ -0,0 +1,272 @@
+/*
+ test_flash_hal_cache.cpp - flash_hal cache tests
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ */
+
+#include <catch.hpp>
+#include <string.h>
+#include <vector>
+#include <FS.h>
+#include "../common/spiffs_mock.h"
+
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+namespace flash_hal_cache_test {
+
+// Enables the cache for one test and flushes it before the flash goes away
+struct CacheScope {
+    CacheScope(uint32_t size, bool writeBack = true) {
+        REQUIRE(flash_hal_cache_begin(size, writeBack));
+        flash_hal_cache_get_stats(nullptr, true);
+        flash_mock_reset_ops();
+    }
+    ~CacheScope() {
+        flash_hal_cache_begin(0);
+    }
+};
+
+struct RawFlash {
+    RawFlash(uint32_t size) : data(size, 0xff) {
+        s_phys_data = data.data();
+        s_phys_size = size;
+    }
+    ~RawFlash() {
+        s_phys_data = nullptr;
+        s_phys_size = 0;
+    }
+    std::vector<uint8_t> data;
+};
+
+TEST_CASE("flash_hal cache merges small writes into page programs", "[core][flash_hal]")
+{
+    RawFlash flash(64 * 1024);
+    CacheScope cache(4 * 1024);
+
+    uint8_t buf[8];
+    for (uint32_t i = 0; i < 64; i++) {
+        memset(buf, i, sizeof(buf));
+        REQUIRE(flash_hal_write(4096 + i * 4, 4, buf) == FLASH_HAL_OK);
+    }
+    // Nothing reached the flash yet, but reads see the new data
+    REQUIRE(s_phys_ops.programs == 0);
+    REQUIRE(flash.data[4096] == 0xff);
+    REQUIRE(flash_hal_read(4096 + 4 * 10, 4, buf) == FLASH_HAL_OK);
+    REQUIRE(buf[0] == 10);
+
+    REQUIRE(flash_hal_sync() == FLASH_HAL_OK);
+    REQUIRE(s_phys_ops.programs == 1);
+    REQUIRE(s_phys_ops.programBytes == 256);
+    for (uint32_t i = 0; i < 64; i++) {
+        REQUIRE(flash.data[4096 + i * 4 + 3] == i);
+    }
+    REQUIRE(flash_hal_sync() == FLASH_HAL_OK);
+    REQUIRE(s_phys_ops.programs == 1);
+
+    flash_hal_cache_stats stats;
+    flash_hal_cache_get_stats(&stats);
+    REQUIRE(stats.writeMisses == 1);
+    REQUIRE(stats.writeHits == 63);
+    REQUIRE(stats.writeBacks == 1);
+}
+
+TEST_CASE("flash_hal cache reads, erases and maps consistently", "[core][flash_hal]")
+{
+    RawFlash flash(64 * 1024);
+    for (size_t i = 0; i < flash.data.size(); i++) {
+        flash.data[i] = i * 7;
+    }
+    CacheScope cache(2 * 1024);
+
+    uint8_t a[16], b[16];
+    // Unaligned reads straddling a page
+    for (int pass = 0; pass < 4; pass++) {
+        REQUIRE(flash_hal_read(250, sizeof(a), a) == FLASH_HAL_OK);
+        REQUIRE(!memcmp(a, &flash.data[250], sizeof(a)));
+    }
+    REQUIRE(s_phys_ops.reads == 2);
+    flash_hal_cache_stats stats;
+    flash_hal_cache_get_stats(&stats);
+    REQUIRE(stats.readMisses == 2);
+    REQUIRE(stats.readHits == 6);
+
+    // Large reads go to flash in one transfer and leave the cache alone
+    std::vector<uint8_t> big(4096);
+    flash_mock_reset_ops();
+    REQUIRE(flash_hal_read(8192, big.size(), big.data()) == FLASH_HAL_OK);
+    REQUIRE(s_phys_ops.reads == 1);
+    REQUIRE(!memcmp(big.data(), &flash.data[8192], big.size()));
+    REQUIRE(flash_hal_read(250, sizeof(a), b) == FLASH_HAL_OK);
+    REQUIRE(s_phys_ops.reads == 1);
+
+    // Programming only clears bits, like the flash does
+    memset(a, 0x0f, sizeof(a));
+    REQUIRE(flash_hal_write(250, sizeof(a), a) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_read(250, sizeof(a), b) == FLASH_HAL_OK);
+    for (size_t i = 0; i < sizeof(b); i++) {
+        REQUIRE(b[i] == (uint8_t)(((250 + i) * 7) & 0x0f));
+    }
+
+    // Mapping pushes pending writes first
+    const uint8_t* mapped = flash_hal_map(250, sizeof(b));
+    REQUIRE(mapped);
+    REQUIRE(!memcmp(mapped, b, sizeof(b)));
+
+    // Erasing pushes pending writes, then drops the erased pages
+    REQUIRE(flash_hal_write(4096 + 10, 2, a) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_write(20000, 2, a) == FLASH_HAL_OK);
+    flash_mock_reset_ops();
+    REQUIRE(flash_hal_erase(4096, 4096) == FLASH_HAL_OK);
+    REQUIRE(s_phys_ops.programs == 2);
+    REQUIRE(flash.data[20000] == ((20000 * 7) & 0x0f));
+    REQUIRE(flash_hal_read(4096 + 8, 4, b) == FLASH_HAL_OK);
+    REQUIRE(b[0] == 0xff);
+    REQUIRE(b[3] == 0xff);
+    REQUIRE(flash.data[4096 + 10] == 0xff);
+}
+
+TEST_CASE("flash mock accounts operations, wear and time", "[core][flash_hal]")
+{
+    RawFlash flash(64 * 1024);
+    flash_mock_reset_ops();
+    REQUIRE(s_phys_sector_erases.size() == 16);
+
+    uint8_t buf[300];
+    memset(buf, 0, sizeof(buf));
+    REQUIRE(flash_hal_read(0, 100, buf) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_write(200, sizeof(buf), buf) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_erase(8192, 8192) == FLASH_HAL_OK);
+    REQUIRE(flash_hal_erase(8192, 4096) == FLASH_HAL_OK);
+
+    REQUIRE(s_phys_ops.reads == 1);
+    REQUIRE(s_phys_ops.readBytes == 100);
+    REQUIRE(s_phys_ops.programs == 1);
+    REQUIRE(s_phys_ops.programBytes == 300);
+    REQUIRE(s_phys_ops.erases == 3);
+    REQUIRE(s_phys_sector_erases[1] == 0);
+    REQUIRE(s_phys_sector_erases[2] == 2);
+    REQUIRE(s_phys_sector_erases[3] == 1);
+
+    // The write crosses a page boundary, so it takes two page programs
+    const FlashMockTiming& t = s_phys_timing;
+    const uint64_t expected = t.readSetupNs + 100ULL * t.readByteNs
+                              + 2 * t.programSetupUs * 1000ULL + (56 - 1 + 244 - 1) * (uint64_t)t.programByteNs
+                              + 3 * t.eraseUs * 1000ULL;
+    REQUIRE(s_phys_ops.busyNs == expected);
+
+    // Programming only clears bits
+    buf[0] = 0xf0;
+    REQUIRE(flash_hal_write(8192, 1, buf) == FLASH_HAL_OK);
+    buf[0] = 0x3c;
+    REQUIRE(flash_hal_write(8192, 1, buf) == FLASH_HAL_OK);
+    REQUIRE(flash.data[8192] == 0x30);
+}
+
+TEST_CASE("flash_hal cache saves SPIFFS flash accesses", "[core][flash_hal][spiffs]")
+{
+    uint32_t ops[2][2]; // reads, programs
+    std::vector<uint8_t> image[2];
+    for (int cached = 0; cached < 2; cached++) {
+        SPIFFS_MOCK_DECLARE(64, 8, 256, "");
+        CacheScope cache(cached ? 8192 : 0);
+        REQUIRE(SPIFFS.format());
+        REQUIRE(SPIFFS.begin());
+        flash_mock_reset_ops();
+        for (int i = 0; i < 24; i++) {
+            File f = SPIFFS.open(String("/log") + (i % 6), "a");
+            REQUIRE(f);
+            for (int j = 0; j < 20; j++) {
+                f.printf("%d:%d\n", i % 6, j);
+            }
+            f.close();
+        }
+        for (int pass = 0; pass < 4; pass++) {
+            for (int i = 0; i < 6; i++) {
+                File f = SPIFFS.open(String("/log") + i, "r");
+                REQUIRE(f);
+                REQUIRE(f.readStringUntil('\n') == String(i) + ":0");
+            }
+        }
+        ops[cached][0] = s_phys_ops.reads;
+        ops[cached][1] = s_phys_ops.programs;
+        File f = SPIFFS.open("/log1", "r");
+        REQUIRE(f.size() == 4 * (10 * 4 + 10 * 5));
+        REQUIRE(f.readStringUntil('\n') == "1:0");
+        f.close();
+        SPIFFS.end();
+        REQUIRE(flash_hal_sync() == FLASH_HAL_OK);
+        image[cached].assign(s_phys_data, s_phys_data + s_phys_size);
+    }
+    // SPIFFS caches pages itself, the rest of the metadata reads and the
+    // partial page programs between two closes still merge here
+    REQUIRE(ops[1][0] < ops[0][0] / 2);
+    REQUIRE(ops[1][1] < ops[0][1]);
+    REQUIRE(image[0] == image[1]);
+}
+
+static std::vector<std::vector<uint8_t>> s_resets;
+
+static void snapshotBeforeErase(uint32_t addr)
+{
+    (void)addr;
+    s_resets.emplace_back(s_phys_data, s_phys_data + s_phys_size);
+}
+
+TEST_CASE("flash_hal cache keeps synced SPIFFS files across resets during GC", "[core][flash_hal][spiffs]")
+{
+    String keep;
+    for (int i = 0; i < 100; i++) {
+        keep += String(i) + ",";
+    }
+    s_resets.clear();
+    {
+        SPIFFS_MOCK_DECLARE(64, 8, 256, "");
+        CacheScope cache(8192);
+        REQUIRE(SPIFFS.format());
+        REQUIRE(SPIFFS.begin());
+        File f = SPIFFS.open("/keep", "w");
+        REQUIRE(f.print(keep) == keep.length());
+        f.close();
+
+        // Appends and removes keep the GC moving live pages and erasing blocks,
+        // snapshot the flash as a reset would leave it before each erase
+        s_phys_erase_hook = snapshotBeforeErase;
+        for (int i = 0; i < 600; i++) {
+            File log = SPIFFS.open("/log", "a");
+            REQUIRE(log);
+            for (int j = 0; j < 4; j++) {
+                log.printf("%04d:%d some log line\n", i, j);
+            }
+            bool full = log.size() > 12 * 1024;
+            log.close();
+            if (full) {
+                REQUIRE(SPIFFS.remove("/log"));
+            }
+        }
+        s_phys_erase_hook = nullptr;
+        SPIFFS.end();
+    }
+    REQUIRE(s_resets.size() > 20);
+
+    for (const auto& image : s_resets) {
+        SPIFFS_MOCK_DECLARE(64, 8, 256, "");
+        memcpy(s_phys_data, image.data(), image.size());
+        REQUIRE(SPIFFS.begin());
+        File f = SPIFFS.open("/keep", "r");
+        REQUIRE(f);
+        REQUIRE(f.readString() == keep);
+        f.close();
+        SPIFFS.end();
+    }
+    s_resets.clear();
+}
+
+};
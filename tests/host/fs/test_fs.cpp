@@ -15,7 +15,9 @@
 
 #include <catch.hpp>
 #include <map>
+#include <unistd.h>
 #include <FS.h>
+#include <Schedule.h>
 #include "../common/spiffs_mock.h"
 #include "../common/littlefs_mock.h"
 #include "../common/sdfs_mock.h"
@@ -57,6 +59,172 @@ TEST_CASE("SPIFFS checks the config object passed in", "[fs]")
     REQUIRE_FALSE(SPIFFS.setConfig(d));
     REQUIRE_FALSE(LittleFS.setConfig(l));
 }
+
+TEST_CASE("SPIFFS name cache follows creates, renames and removes", "[fs]")
+{
+    SPIFFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(SPIFFS.setConfig(SPIFFSConfig().setNameCache(16)));
+    REQUIRE(SPIFFS.begin());
+    for (int i = 0; i < 8; i++) {
+        auto f = SPIFFS.open(String("/file") + i, "w");
+        REQUIRE(f.print(i) == 1);
+    }
+
+    FSStats st;
+    REQUIRE(SPIFFS.stats(st, true));
+    REQUIRE_FALSE(SPIFFS.exists("/missing"));
+    REQUIRE_FALSE(SPIFFS.exists("/missing"));
+    REQUIRE(SPIFFS.exists("/file3"));
+    REQUIRE(SPIFFS.open("/file3", "r").readString() == "3");
+    REQUIRE(SPIFFS.stats(st, true));
+    REQUIRE(st.lookupHits >= 2);
+
+    // Names known to be missing appear, known ones move or go away
+    REQUIRE(SPIFFS.open("/missing", "w").print("m") == 1);
+    REQUIRE(SPIFFS.exists("/missing"));
+    REQUIRE(SPIFFS.rename("/file3", "/renamed"));
+    REQUIRE_FALSE(SPIFFS.exists("/file3"));
+    REQUIRE(SPIFFS.open("/renamed", "r").readString() == "3");
+    REQUIRE(SPIFFS.remove("/renamed"));
+    REQUIRE_FALSE(SPIFFS.exists("/renamed"));
+    auto a = SPIFFS.open("/file5", "a");
+    REQUIRE(a.print("55") == 2);
+    a.close();
+    REQUIRE(SPIFFS.open("/file5", "r").readString() == "555");
+
+    // Garbage collection moves headers, lookups still find them
+    for (int round = 0; round < 20; round++) {
+        auto f = SPIFFS.open("/churn", "w");
+        for (int i = 0; i < 100; i++) {
+            f.print("0123456789");
+        }
+        f.close();
+        REQUIRE(SPIFFS.remove("/churn"));
+    }
+    for (int i = 0; i < 8; i++) {
+        if (i == 3) {
+            continue;
+        }
+        REQUIRE(SPIFFS.open(String("/file") + i, "r").readString() == String(i == 5 ? "555" : String(i)));
+    }
+    REQUIRE(SPIFFS.stats(st));
+    REQUIRE(st.lookupHits > 0);
+
+    // Same answers from the flash after a remount without cache
+    SPIFFS.end();
+    REQUIRE(SPIFFS.setConfig(SPIFFSConfig()));
+    REQUIRE(SPIFFS.begin());
+    REQUIRE(SPIFFS.exists("/missing"));
+    REQUIRE_FALSE(SPIFFS.exists("/file3"));
+    REQUIRE_FALSE(SPIFFS.exists("/renamed"));
+    REQUIRE(SPIFFS.stats(st));
+    REQUIRE(st.lookupHits == 0);
+}
+
+// Stalls the first erase past any budget, as an erase near the datasheet
+// maximum or a long interrupt would
+static bool s_slowErase;
+static void slowErase(uint32_t addr)
+{
+    (void)addr;
+    if (s_slowErase) {
+        s_slowErase = false;
+        usleep(300000);
+    }
+}
+
+TEST_CASE("SPIFFS collects garbage ahead of writes", "[fs]")
+{
+    SPIFFS_MOCK_DECLARE(64, 8, 512, "");
+    REQUIRE(SPIFFS.begin());
+    uint8_t data[1000];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)i;
+    }
+    // Leave blocks mixing live and deleted pages
+    for (int i = 0; i < 24; i++) {
+        auto f = SPIFFS.open(String("/f") + i, "w");
+        REQUIRE(f.write(data, sizeof(data)) == sizeof(data));
+    }
+    for (int i = 0; i < 24; i += 2) {
+        REQUIRE(SPIFFS.remove(String("/f") + i));
+    }
+
+    FSStats st;
+    REQUIRE(SPIFFS.stats(st, true));
+    REQUIRE(st.gcSteps == 0);
+    // Until measured, a step over 8KB blocks counts as two 50ms sector erases
+    // and is not started with a smaller budget
+    REQUIRE_FALSE(SPIFFS.gcStep(0));
+    REQUIRE_FALSE(SPIFFS.gcStep(99999));
+    REQUIRE(SPIFFS.stats(st));
+    REQUIRE(st.gcSteps == 0);
+    // One step slower than any budget does not keep the next ones out
+    s_slowErase = true;
+    s_phys_erase_hook = slowErase;
+    REQUIRE(SPIFFS.gcStep(150000));
+    s_phys_erase_hook = nullptr;
+    REQUIRE_FALSE(s_slowErase);
+    REQUIRE(SPIFFS.stats(st));
+    REQUIRE(st.gcSteps == 1);
+    SPIFFS.gcStep(150000);
+    REQUIRE(SPIFFS.stats(st));
+    REQUIRE(st.gcSteps > 1);
+    int calls = 0;
+    while (SPIFFS.gcStep(150000)) {
+        REQUIRE(++calls < 20);
+    }
+    REQUIRE(SPIFFS.stats(st, true));
+    REQUIRE(st.gcSteps > 0);
+    REQUIRE_FALSE(SPIFFS.gcStep(1000000));
+    for (int i = 1; i < 24; i += 2) {
+        auto f = SPIFFS.open(String("/f") + i, "r");
+        uint8_t buf[sizeof(data)];
+        REQUIRE(f.read(buf, sizeof(buf)) == sizeof(buf));
+        REQUIRE(!memcmp(buf, data, sizeof(data)));
+    }
+
+    // The same from a recurrent scheduled function, until stopped.  Each
+    // round takes a free block for new data and leaves garbage behind
+    auto fill = [&](int round) {
+        for (int i = round; i < 24; i += 4) {
+            REQUIRE(SPIFFS.remove(String("/f") + i));
+        }
+        auto g = SPIFFS.open("/g", "w");
+        for (int i = 0; i < 8; i++) {
+            REQUIRE(g.write(data, sizeof(data)) == sizeof(data));
+        }
+    };
+    fill(1);
+    REQUIRE(SPIFFS.setBackgroundGC(1, 200000));
+    for (int i = 0; i < 1000 && SPIFFS.stats(st) && !st.gcSteps; i++) {
+        run_scheduled_recurrent_functions();
+    }
+    REQUIRE(st.gcSteps > 0);
+    REQUIRE(SPIFFS.setBackgroundGC(0));
+    REQUIRE(SPIFFS.stats(st, true));
+    fill(3);
+    REQUIRE(SPIFFS.gcStep(0) == false); // Work left, but none for a zero budget
+    for (int i = 0; i < 100; i++) {
+        run_scheduled_recurrent_functions();
+    }
+    REQUIRE(SPIFFS.stats(st, true));
+    REQUIRE(st.gcSteps == 0);
+
+    // Every write and flush lands in the latency histogram
+    auto f = SPIFFS.open("/log", "w");
+    for (int i = 0; i < 10; i++) {
+        REQUIRE(f.write(data, 100) == 100);
+    }
+    f.flush();
+    f.close();
+    REQUIRE(SPIFFS.stats(st));
+    uint32_t total = 0;
+    for (size_t i = 0; i < FSStats::latencyBuckets; i++) {
+        total += st.writeLatency[i];
+    }
+    REQUIRE(total == 11);
+}
 #pragma GCC diagnostic pop
 
 };
@@ -93,6 +261,85 @@ TEST_CASE("LittleFS checks the config object passed in", "[fs]")
     REQUIRE(LittleFS.setConfig(l));
 }
 
+// The cases below were written without the littlefs submodule checked out,
+// so they (and the LittleFS changes they cover) have not been compiled or
+// run yet
+TEST_CASE("LittleFS rejects unusable cache geometry", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    // Multiple of read and prog sizes, but not a divisor of the 8KB block
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setReadSize(32).setProgSize(32).setCacheSize(96)));
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setReadSize(48)));     // not a divisor of the cache
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig().setLookaheadSize(12)));
+    REQUIRE(LittleFS.setConfig(LittleFSConfig().setCacheSize(512).setLookaheadSize(16)));
+    REQUIRE(LittleFS.begin());
+    REQUIRE_FALSE(LittleFS.setConfig(LittleFSConfig()));
+}
+
+TEST_CASE("LittleFS read-ahead keeps file positions and saves flash reads", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    uint8_t data[3000];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7);
+    }
+    REQUIRE(LittleFS.begin());
+    auto w = LittleFS.open("/data", "w");
+    REQUIRE(w.write(data, sizeof(data)) == sizeof(data));
+    w.close();
+    LittleFS.end();
+
+    FSStats stats[2];
+    for (int pass = 0; pass < 2; pass++) {
+        REQUIRE(LittleFS.setConfig(LittleFSConfig().setReadAhead(pass ? 2048 : 0)));
+        REQUIRE(LittleFS.begin());
+        auto f = LittleFS.open("/data", "r");
+        REQUIRE(f);
+        LittleFS.stats(stats[pass], true);
+        for (size_t i = 0; i < sizeof(data); i++) {
+            REQUIRE(f.read() == data[i]);
+        }
+        REQUIRE(f.read() == -1);
+        REQUIRE(LittleFS.stats(stats[pass]));
+
+        REQUIRE(f.seek(100, SeekSet));
+        uint8_t buf[10];
+        REQUIRE(f.read(buf, sizeof(buf)) == sizeof(buf));
+        REQUIRE(!memcmp(buf, data + 100, sizeof(buf)));
+        REQUIRE(f.position() == 110);
+        REQUIRE(f.available() == (int)sizeof(data) - 110);
+        REQUIRE(f.seek(40, SeekCur));
+        REQUIRE(f.position() == 150);
+        REQUIRE(f.read() == data[150]);
+        f.close();
+        LittleFS.end();
+    }
+    REQUIRE(stats[1].readCalls < stats[0].readCalls);
+    REQUIRE(stats[1].progCalls == 0);
+}
+
+TEST_CASE("LittleFS maps single block files opened read-only", "[fs]")
+{
+    LITTLEFS_MOCK_DECLARE(64, 8, 512, "");
+    uint8_t data[3000];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 13);
+    }
+    REQUIRE(LittleFS.begin());
+    auto w = LittleFS.open("/table", "w");
+    REQUIRE(w.write(data, sizeof(data)) == sizeof(data));
+    REQUIRE(w.mapped() == nullptr);
+    w.close();
+    createFile("/tiny", "inline");
+
+    auto f = LittleFS.open("/table", "r");
+    const uint8_t* table = f.mapped();
+    REQUIRE(table != nullptr);
+    REQUIRE(!memcmp(table, data, sizeof(data)));
+    REQUIRE(LittleFS.open("/table", "r+").mapped() == nullptr);
+    REQUIRE(LittleFS.open("/tiny", "r").mapped() == nullptr);
+}
+
 };
 
 namespace sdfs_test {
@@ -0,0 +1,192 @@
+/*
+ test_packedfs.cpp - host side read-only packed image tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <map>
+#include <set>
+#include <vector>
+#include <FS.h>
+#include "../common/flash_hal_mock.h"
+#include "../../../libraries/PackedFS/src/PackedFS.h"
+
+using packedfs_impl::PackedFSImpl;
+using packedfs_impl::PackedFSHeader;
+using packedfs_impl::PackedFSEntry;
+
+namespace packedfs_test {
+
+// Same layout as tools/mkpackfs.py writes, hashes are fake
+static std::vector<uint8_t> makeImage(const std::map<std::string, std::string>& files)
+{
+    std::vector<uint8_t> image(sizeof(PackedFSHeader) + files.size() * sizeof(PackedFSEntry));
+    std::vector<PackedFSEntry> entries;
+    for (const auto& f : files) {
+        PackedFSEntry e;
+        memset(&e, 0, sizeof(e));
+        e.name = image.size();
+        image.insert(image.end(), f.first.c_str(), f.first.c_str() + f.first.size() + 1);
+        e.mtime = 1000 + entries.size();
+        e.hash[7] = entries.size() + 1;
+        entries.push_back(e);
+    }
+    size_t i = 0;
+    for (const auto& f : files) {
+        image.resize((image.size() + 3) & ~3);
+        entries[i].data = image.size();
+        entries[i].size = f.second.size();
+        image.insert(image.end(), f.second.begin(), f.second.end());
+        i++;
+    }
+    PackedFSHeader h = { PackedFSImpl::magic, PackedFSImpl::version, sizeof(PackedFSEntry), (uint32_t)files.size(), (uint32_t)image.size() };
+    memcpy(image.data(), &h, sizeof(h));
+    memcpy(image.data() + sizeof(h), entries.data(), entries.size() * sizeof(PackedFSEntry));
+    return image;
+}
+
+static const std::map<std::string, std::string> content = {
+    { "index.html", "<html>home</html>" },
+    { "css/app.css", "body{}" },
+    { "css/print.css", "@media print{}" },
+    { "css/img/logo.svg", "<svg/>" },
+    { "js/app.js.gz", std::string("\x1f\x8b\x08\x00zz", 6) },
+    { "favicon.ico", "ico" },
+};
+
+static std::set<String> listDir(FS& fs, const char* path)
+{
+    std::set<String> result;
+    Dir dir = fs.openDir(path);
+    while (dir.next()) {
+        String name = dir.fileName();
+        if (dir.isDirectory()) {
+            name += '/';
+        }
+        REQUIRE(result.find(name) == std::end(result));
+        result.insert(name);
+    }
+    return result;
+}
+
+TEST_CASE("PackedFS mounts only a valid image", "[packedfs]")
+{
+    FS fs(FSImplPtr(new PackedFSImpl()));
+    REQUIRE_FALSE(fs.begin());
+    REQUIRE_FALSE(fs.setConfig(SPIFFSConfig()));
+
+    auto image = makeImage(content);
+    image[0] ^= 1;
+    REQUIRE(fs.setConfig(PackedFSConfig(image.data())));
+    REQUIRE_FALSE(fs.begin());
+    image[0] ^= 1;
+    REQUIRE(fs.begin());
+    FSInfo info;
+    REQUIRE(fs.info(info));
+    REQUIRE(info.totalBytes == image.size());
+    REQUIRE_FALSE(fs.setConfig(PackedFSConfig(image.data())));
+}
+
+TEST_CASE("PackedFS finds and reads files", "[packedfs]")
+{
+    auto image = makeImage(content);
+    FS fs(FSImplPtr(new PackedFSImpl()));
+    REQUIRE(fs.setConfig(PackedFSConfig(image.data())));
+    REQUIRE(fs.begin());
+
+    for (const auto& f : content) {
+        String path = String("/") + f.first.c_str();
+        REQUIRE(fs.exists(path));
+        File file = fs.open(path, "r");
+        REQUIRE(file);
+        REQUIRE(file.isFile());
+        REQUIRE(file.size() == f.second.size());
+        std::string read;
+        while (file.available()) {
+            read += (char)file.read();
+        }
+        REQUIRE(read == f.second);
+        REQUIRE(file.mapped() != nullptr);
+        REQUIRE(((uintptr_t)file.mapped() & 3) == 0);
+        REQUIRE(!memcmp(file.mapped(), f.second.data(), f.second.size()));
+        REQUIRE(file.contentHash() != 0);
+    }
+    REQUIRE(fs.exists("css"));
+    REQUIRE(fs.exists("/css/img/"));
+    REQUIRE_FALSE(fs.exists("/cs"));
+    REQUIRE_FALSE(fs.exists("/css/app"));
+    REQUIRE_FALSE(fs.exists("/zzz"));
+    REQUIRE_FALSE(fs.open("/index.html", "w"));
+    REQUIRE_FALSE(fs.open("/new.txt", "a"));
+    REQUIRE_FALSE(fs.remove("/index.html"));
+    REQUIRE_FALSE(fs.format());
+    REQUIRE(fs.open("/css", "r").isDirectory());
+
+    File f = fs.open("index.html", "r");
+    REQUIRE(f.getLastWrite() != 0);
+    REQUIRE(f.seek(6, SeekSet));
+    REQUIRE((char)f.read() == 'h');
+    REQUIRE(f.seek(3, SeekCur));
+    REQUIRE((char)f.read() == '<');
+    REQUIRE(f.seek(1, SeekEnd));
+    REQUIRE((char)f.read() == '>');
+    REQUIRE_FALSE(f.seek(100, SeekSet));
+    REQUIRE(f.position() == f.size());
+}
+
+TEST_CASE("PackedFS lists direct children", "[packedfs]")
+{
+    auto image = makeImage(content);
+    FS fs(FSImplPtr(new PackedFSImpl()));
+    REQUIRE(fs.setConfig(PackedFSConfig(image.data())));
+    REQUIRE(fs.begin());
+
+    REQUIRE(listDir(fs, "/") == std::set<String>({ "css/", "favicon.ico", "index.html", "js/" }));
+    REQUIRE(listDir(fs, "/css") == std::set<String>({ "app.css", "img/", "print.css" }));
+    REQUIRE(listDir(fs, "/css/img/") == std::set<String>({ "logo.svg" }));
+    REQUIRE(listDir(fs, "/nothing").empty());
+
+    Dir dir = fs.openDir("/js");
+    REQUIRE(dir.next());
+    REQUIRE(dir.fileSize() == 6);
+    File f = dir.openFile("r");
+    REQUIRE(String(f.fullName()) == "js/app.js.gz");
+    REQUIRE_FALSE(dir.next());
+    REQUIRE(dir.rewind());
+    REQUIRE(dir.next());
+}
+
+TEST_CASE("PackedFS reads an image from flash", "[packedfs]")
+{
+    auto image = makeImage(content);
+    std::vector<uint8_t> flash(0x2000 + image.size(), 0xff);
+    memcpy(flash.data() + 0x2000, image.data(), image.size());
+    s_phys_data = flash.data();
+    s_phys_size = flash.size();
+
+    FS fs(FSImplPtr(new PackedFSImpl()));
+    REQUIRE(fs.setConfig(PackedFSConfig().setFlash(0x2000, image.size())));
+    REQUIRE(fs.begin());
+    File f = fs.open("/css/print.css", "r");
+    REQUIRE(f.readString() == "@media print{}");
+    REQUIRE(f.mapped() > flash.data() + 0x2000);
+    REQUIRE(!memcmp(f.mapped(), "@media print{}", 14));
+    fs.end();
+
+    REQUIRE(fs.setConfig(PackedFSConfig().setFlash(0x2000, image.size() - 1)));
+    REQUIRE_FALSE(fs.begin());
+
+    s_phys_data = nullptr;
+    s_phys_size = 0;
+}
+
+};
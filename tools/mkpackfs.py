@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+
+# Build a read-only PackedFS image from a directory, for the PackedFS library.
+#
+# The image holds a header, a directory sorted by path (binary searched on the
+# device), the paths, then every file whole and 4-byte aligned.  It is written
+# as a raw binary to upload to flash, or as a C header with a PROGMEM array to
+# link into the sketch.  With --gzip, compressible files are stored as <name>.gz
+# when that is smaller, which ESP8266WebServer::serveStatic() sends with
+# Content-Encoding: gzip.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+from __future__ import print_function
+import argparse
+import fnmatch
+import gzip
+import hashlib
+import os
+import struct
+import sys
+
+# Must match libraries/PackedFS/src/PackedFS.h
+MAGIC = 0x53464b50
+VERSION = 1
+HEADER = struct.Struct('<IHHII')
+ENTRY = struct.Struct('<IIII8s')
+NAME_MAX = 64 # including the terminating NUL
+
+GZIP_TYPES = [ '*.htm', '*.html', '*.css', '*.js', '*.json', '*.svg', '*.txt', '*.xml', '*.csv', '*.map' ]
+
+def align4(n):
+    return (n + 3) & ~3
+
+def collect(source, exclude):
+    files = []
+    for root, dirs, names in os.walk(source):
+        dirs.sort()
+        for name in sorted(names):
+            path = os.path.join(root, name)
+            rel = os.path.relpath(path, source).replace(os.sep, '/')
+            if any(fnmatch.fnmatch(rel, pat) or fnmatch.fnmatch(name, pat) for pat in exclude):
+                continue
+            files.append((rel, path))
+    return files
+
+def load(files, args):
+    entries = {}
+    for rel, path in files:
+        with open(path, 'rb') as f:
+            data = f.read()
+        mtime = 0 if args.no_mtime else int(os.path.getmtime(path))
+        name = rel
+        if args.gzip and not rel.endswith('.gz') and any(fnmatch.fnmatch(rel, pat) for pat in GZIP_TYPES):
+            packed = gzip.compress(data, 9, mtime=0)
+            if len(packed) < len(data):
+                name, data = rel + '.gz', packed
+        if len(name.encode('utf-8')) >= NAME_MAX:
+            raise Exception('Path "' + name + '" is longer than ' + str(NAME_MAX - 1) + ' bytes')
+        if name in entries:
+            raise Exception('Path "' + name + '" appears twice')
+        entries[name] = (data, mtime)
+    return entries
+
+def build(entries):
+    names = sorted(entries.keys(), key=lambda n: n.encode('utf-8'))
+    offset = HEADER.size + ENTRY.size * len(names)
+    name_offsets = []
+    for name in names:
+        name_offsets.append(offset)
+        offset += len(name.encode('utf-8')) + 1
+    data_offsets = []
+    for name in names:
+        offset = align4(offset)
+        data_offsets.append(offset)
+        offset += len(entries[name][0])
+    size = align4(offset)
+
+    image = bytearray(size)
+    HEADER.pack_into(image, 0, MAGIC, VERSION, ENTRY.size, len(names), size)
+    for i, name in enumerate(names):
+        data, mtime = entries[name]
+        digest = hashlib.sha256(data).digest()[:8]
+        ENTRY.pack_into(image, HEADER.size + i * ENTRY.size, name_offsets[i], data_offsets[i], len(data), mtime, digest)
+        encoded = name.encode('utf-8')
+        image[name_offsets[i]:name_offsets[i] + len(encoded)] = encoded
+        image[data_offsets[i]:data_offsets[i] + len(data)] = data
+    return bytes(image)
+
+def write_header(image, out, symbol):
+    out.write('// Generated by tools/mkpackfs.py, do not edit\n')
+    out.write('#pragma once\n')
+    out.write('#include <pgmspace.h>\n\n')
+    out.write('static const uint8_t {sym}[{size}] PROGMEM __attribute__((aligned(4))) = {{\n'.format(sym=symbol, size=len(image)))
+    for i in range(0, len(image), 16):
+        out.write('    ' + ', '.join('0x%02x' % b for b in image[i:i + 16]) + ',\n')
+    out.write('};\n')
+
+def main():
+    parser = argparse.ArgumentParser(description='Build a read-only PackedFS image')
+    parser.add_argument('-s', '--source', action='store', required=True, help='Directory to pack')
+    parser.add_argument('-o', '--out', action='store', default=None, help='Binary image to write')
+    parser.add_argument('--header', action='store', default=None, help='C header with a PROGMEM array to write')
+    parser.add_argument('--symbol', action='store', default='packedfs_image', help='Name of the array in --header')
+    parser.add_argument('--size', action='store', type=lambda x: int(x, 0), default=0, help='Fail if the image is larger')
+    parser.add_argument('--gzip', action='store_true', help='Store compressible files gzipped as <name>.gz when smaller')
+    parser.add_argument('--no-mtime', action='store_true', help='Store 0 as time stamps, for reproducible images')
+    parser.add_argument('-x', '--exclude', action='append', default=[], help='Skip paths or names matching this pattern')
+    args = parser.parse_args()
+
+    if not args.out and not args.header:
+        parser.error('nothing to write, give --out and/or --header')
+
+    image = build(load(collect(args.source, args.exclude), args))
+    if args.size and len(image) > args.size:
+        raise Exception('Image is {size} bytes, more than {max}'.format(size=len(image), max=args.size))
+
+    if args.out:
+        with open(args.out, 'wb') as out:
+            out.write(image)
+    if args.header:
+        with open(args.header, 'w') as out:
+            write_header(image, out, args.symbol)
+
+    print('Packed {count} files into {size} bytes'.format(count=struct.unpack_from('<I', image, 8)[0], size=len(image)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())